@@ -0,0 +1,396 @@
+#include "color.h"
+
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+namespace {
+
+const float PI = 3.14159265358979f;
+
+// D65
+const float WHITE_X = 0.95047f;
+const float WHITE_Y = 1.0f;
+const float WHITE_Z = 1.08883f;
+
+const float LAB_EPSILON = 216.0f / 24389.0f;
+const float LAB_KAPPA = 24389.0f / 27.0f;
+
+inline float Min3(float a, float b, float c) {
+  float m = a < b ? a : b;
+  return m < c ? m : c;
+}
+
+inline float Max3(float a, float b, float c) {
+  float m = a > b ? a : b;
+  return m > c ? m : c;
+}
+
+inline float Clamp01(float x) { return x < 0 ? 0 : (x > 1 ? 1 : x); }
+
+//? 立方根: 位运算给初值，再做三次牛顿迭代，精度到 float 的末位附近
+//? 标准库的 cbrtf 是函数调用，会挡住循环向量化
+inline float Cbrt(float x) {
+  float ax = fabsf(x);
+  uint32_t i;
+  memcpy(&i, &ax, sizeof(i));
+  i = i / 3 + 709921077u;
+  float y;
+  memcpy(&y, &i, sizeof(y));
+  y = (2.0f * y + ax / (y * y)) * (1.0f / 3.0f);
+  y = (2.0f * y + ax / (y * y)) * (1.0f / 3.0f);
+  y = (2.0f * y + ax / (y * y)) * (1.0f / 3.0f);
+  y = ax == 0 ? 0 : y;
+  return x < 0 ? -y : y;
+}
+
+inline float DecodeSrgb(float c) {
+  return c <= 0.04045f ? c * (1.0f / 12.92f)
+                       : powf((c + 0.055f) * (1.0f / 1.055f), 2.4f);
+}
+
+inline float EncodeSrgb(float c) {
+  return c <= 0.0031308f ? c * 12.92f
+                         : 1.055f * powf(c, 1.0f / 2.4f) - 0.055f;
+}
+
+inline float LabF(float t) {
+  return t > LAB_EPSILON ? Cbrt(t) : (LAB_KAPPA * t + 16.0f) * (1.0f / 116.0f);
+}
+
+inline float LabFInv(float f) {
+  float f3 = f * f * f;
+  return f3 > LAB_EPSILON ? f3 : (116.0f * f - 16.0f) * (1.0f / LAB_KAPPA);
+}
+
+struct LinearTable {
+  float v[256];
+  LinearTable() {
+    for (int i = 0; i < 256; i++) v[i] = DecodeSrgb(i / 255.0f);
+  }
+};
+
+const LinearTable linearTable;
+
+}  // namespace
+
+void UnpackSrgb(const unsigned char* bgra, size_t count, ColorSpan rgb) {
+  size_t i = 0;
+#ifdef __SSE2__
+  // 一次四个像素: 按 32 位取出再移位拆通道
+  const __m128i mask = _mm_set1_epi32(0xff);
+  const __m128 scale = _mm_set1_ps(1.0f / 255.0f);
+  for (; i + 4 <= count; i += 4) {
+    __m128i p = _mm_loadu_si128((const __m128i*)(bgra + i * 4));
+    __m128i r = _mm_and_si128(_mm_srli_epi32(p, 16), mask);
+    __m128i g = _mm_and_si128(_mm_srli_epi32(p, 8), mask);
+    __m128i b = _mm_and_si128(p, mask);
+    _mm_storeu_ps(rgb.c0 + i, _mm_mul_ps(_mm_cvtepi32_ps(r), scale));
+    _mm_storeu_ps(rgb.c1 + i, _mm_mul_ps(_mm_cvtepi32_ps(g), scale));
+    _mm_storeu_ps(rgb.c2 + i, _mm_mul_ps(_mm_cvtepi32_ps(b), scale));
+  }
+#endif
+  for (; i < count; i++) {
+    rgb.c0[i] = bgra[i * 4 + 2] * (1.0f / 255.0f);
+    rgb.c1[i] = bgra[i * 4 + 1] * (1.0f / 255.0f);
+    rgb.c2[i] = bgra[i * 4 + 0] * (1.0f / 255.0f);
+  }
+}
+
+void UnpackLinear(const unsigned char* bgra, size_t count, ColorSpan rgb) {
+  for (size_t i = 0; i < count; i++) {
+    rgb.c0[i] = linearTable.v[bgra[i * 4 + 2]];
+    rgb.c1[i] = linearTable.v[bgra[i * 4 + 1]];
+    rgb.c2[i] = linearTable.v[bgra[i * 4 + 0]];
+  }
+}
+
+static void SrgbToLinearKernel(const float* __restrict in0,
+                               const float* __restrict in1,
+                               const float* __restrict in2, size_t count,
+                               float* __restrict out0, float* __restrict out1,
+                               float* __restrict out2) {
+  for (size_t i = 0; i < count; i++) {
+    out0[i] = DecodeSrgb(in0[i]);
+    out1[i] = DecodeSrgb(in1[i]);
+    out2[i] = DecodeSrgb(in2[i]);
+  }
+}
+
+void SrgbToLinear(ColorSpan srgb, size_t count, ColorSpan linear) {
+  SrgbToLinearKernel(srgb.c0, srgb.c1, srgb.c2, count,
+                     linear.c0, linear.c1, linear.c2);
+}
+
+static void LinearToSrgbKernel(const float* __restrict in0,
+                               const float* __restrict in1,
+                               const float* __restrict in2, size_t count,
+                               float* __restrict out0, float* __restrict out1,
+                               float* __restrict out2) {
+  for (size_t i = 0; i < count; i++) {
+    out0[i] = EncodeSrgb(in0[i]);
+    out1[i] = EncodeSrgb(in1[i]);
+    out2[i] = EncodeSrgb(in2[i]);
+  }
+}
+
+void LinearToSrgb(ColorSpan linear, size_t count, ColorSpan srgb) {
+  LinearToSrgbKernel(linear.c0, linear.c1, linear.c2, count,
+                     srgb.c0, srgb.c1, srgb.c2);
+}
+
+//? 色相: 最大的通道决定落在哪个 60 度扇区，delta 为 0 时色相记为 0
+static void RgbToHsvKernel(const float* __restrict in0,
+                           const float* __restrict in1,
+                           const float* __restrict in2, size_t count,
+                           float* __restrict out0, float* __restrict out1,
+                           float* __restrict out2) {
+  for (size_t i = 0; i < count; i++) {
+    float r = in0[i], g = in1[i], b = in2[i];
+    float maxv = Max3(r, g, b);
+    float minv = Min3(r, g, b);
+    float delta = maxv - minv;
+    float inv = 1.0f / (delta > 0 ? delta : 1.0f);
+
+    float h = maxv == r ? (g - b) * inv
+              : maxv == g ? (b - r) * inv + 2.0f
+                          : (r - g) * inv + 4.0f;
+    h *= 60.0f;
+    h = h < 0 ? h + 360.0f : h;
+
+    out0[i] = delta > 0 ? h : 0.0f;
+    out1[i] = maxv > 0 ? delta / (maxv > 0 ? maxv : 1.0f) : 0.0f;
+    out2[i] = maxv;
+  }
+}
+
+void RgbToHsv(ColorSpan rgb, size_t count, ColorSpan hsv) {
+  RgbToHsvKernel(rgb.c0, rgb.c1, rgb.c2, count, hsv.c0, hsv.c1, hsv.c2);
+}
+
+//? f(n) = V - V*S*max(0, min(k, 4-k, 1)), k = (n + H/60) mod 6
+static void HsvToRgbKernel(const float* __restrict in0,
+                           const float* __restrict in1,
+                           const float* __restrict in2, size_t count,
+                           float* __restrict out0, float* __restrict out1,
+                           float* __restrict out2) {
+  for (size_t i = 0; i < count; i++) {
+    float h = in0[i] * (1.0f / 60.0f), s = in1[i], v = in2[i];
+    float out[3];
+    const float n[3] = {5.0f, 3.0f, 1.0f};
+    for (int c = 0; c < 3; c++) {
+      float k = n[c] + h;
+      k -= 6.0f * (float)(int)(k * (1.0f / 6.0f));  // k >= 0, 截断即取整
+      float t = Min3(k, 4.0f - k, 1.0f);
+      out[c] = v - v * s * (t > 0 ? t : 0);
+    }
+    out0[i] = out[0];
+    out1[i] = out[1];
+    out2[i] = out[2];
+  }
+}
+
+void HsvToRgb(ColorSpan hsv, size_t count, ColorSpan rgb) {
+  HsvToRgbKernel(hsv.c0, hsv.c1, hsv.c2, count, rgb.c0, rgb.c1, rgb.c2);
+}
+
+static void RgbToHslKernel(const float* __restrict in0,
+                           const float* __restrict in1,
+                           const float* __restrict in2, size_t count,
+                           float* __restrict out0, float* __restrict out1,
+                           float* __restrict out2) {
+  for (size_t i = 0; i < count; i++) {
+    float r = in0[i], g = in1[i], b = in2[i];
+    float maxv = Max3(r, g, b);
+    float minv = Min3(r, g, b);
+    float delta = maxv - minv;
+    float inv = 1.0f / (delta > 0 ? delta : 1.0f);
+
+    float h = maxv == r ? (g - b) * inv
+              : maxv == g ? (b - r) * inv + 2.0f
+                          : (r - g) * inv + 4.0f;
+    h *= 60.0f;
+    h = h < 0 ? h + 360.0f : h;
+
+    float l = (maxv + minv) * 0.5f;
+    float denom = 1.0f - fabsf(2.0f * l - 1.0f);
+
+    out0[i] = delta > 0 ? h : 0.0f;
+    out1[i] = delta > 0 && denom > 0 ? delta / (denom > 0 ? denom : 1.0f)
+                                       : 0.0f;
+    out2[i] = l;
+  }
+}
+
+void RgbToHsl(ColorSpan rgb, size_t count, ColorSpan hsl) {
+  RgbToHslKernel(rgb.c0, rgb.c1, rgb.c2, count, hsl.c0, hsl.c1, hsl.c2);
+}
+
+//? f(n) = L - a*max(-1, min(k-3, 9-k, 1)), k = (n + H/30) mod 12
+static void HslToRgbKernel(const float* __restrict in0,
+                           const float* __restrict in1,
+                           const float* __restrict in2, size_t count,
+                           float* __restrict out0, float* __restrict out1,
+                           float* __restrict out2) {
+  for (size_t i = 0; i < count; i++) {
+    float h = in0[i] * (1.0f / 30.0f), s = in1[i], l = in2[i];
+    float a = s * (l < 1.0f - l ? l : 1.0f - l);
+    float out[3];
+    const float n[3] = {0.0f, 8.0f, 4.0f};
+    for (int c = 0; c < 3; c++) {
+      float k = n[c] + h;
+      k -= 12.0f * (float)(int)(k * (1.0f / 12.0f));
+      float t = Min3(k - 3.0f, 9.0f - k, 1.0f);
+      out[c] = l - a * (t > -1.0f ? t : -1.0f);
+    }
+    out0[i] = out[0];
+    out1[i] = out[1];
+    out2[i] = out[2];
+  }
+}
+
+void HslToRgb(ColorSpan hsl, size_t count, ColorSpan rgb) {
+  HslToRgbKernel(hsl.c0, hsl.c1, hsl.c2, count, rgb.c0, rgb.c1, rgb.c2);
+}
+
+static void LinearToLabKernel(const float* __restrict in0,
+                              const float* __restrict in1,
+                              const float* __restrict in2, size_t count,
+                              float* __restrict out0, float* __restrict out1,
+                              float* __restrict out2) {
+  for (size_t i = 0; i < count; i++) {
+    float r = in0[i], g = in1[i], b = in2[i];
+    float x = 0.4123908f * r + 0.3575843f * g + 0.1804808f * b;
+    float y = 0.2126390f * r + 0.7151687f * g + 0.0721923f * b;
+    float z = 0.0193308f * r + 0.1191948f * g + 0.9505322f * b;
+
+    float fx = LabF(x * (1.0f / WHITE_X));
+    float fy = LabF(y * (1.0f / WHITE_Y));
+    float fz = LabF(z * (1.0f / WHITE_Z));
+
+    out0[i] = 116.0f * fy - 16.0f;
+    out1[i] = 500.0f * (fx - fy);
+    out2[i] = 200.0f * (fy - fz);
+  }
+}
+
+void LinearToLab(ColorSpan linear, size_t count, ColorSpan lab) {
+  LinearToLabKernel(linear.c0, linear.c1, linear.c2, count,
+                    lab.c0, lab.c1, lab.c2);
+}
+
+static void LabToLinearKernel(const float* __restrict in0,
+                              const float* __restrict in1,
+                              const float* __restrict in2, size_t count,
+                              float* __restrict out0, float* __restrict out1,
+                              float* __restrict out2) {
+  for (size_t i = 0; i < count; i++) {
+    float L = in0[i];
+    float fy = (L + 16.0f) * (1.0f / 116.0f);
+    float fx = fy + in1[i] * (1.0f / 500.0f);
+    float fz = fy - in2[i] * (1.0f / 200.0f);
+
+    float x = LabFInv(fx) * WHITE_X;
+    float y = (L > LAB_KAPPA * LAB_EPSILON ? fy * fy * fy : L / LAB_KAPPA) *
+              WHITE_Y;
+    float z = LabFInv(fz) * WHITE_Z;
+
+    out0[i] = 3.2409699f * x - 1.5373832f * y - 0.4986108f * z;
+    out1[i] = -0.9692436f * x + 1.8759675f * y + 0.0415551f * z;
+    out2[i] = 0.0556301f * x - 0.2039770f * y + 1.0569715f * z;
+  }
+}
+
+void LabToLinear(ColorSpan lab, size_t count, ColorSpan linear) {
+  LabToLinearKernel(lab.c0, lab.c1, lab.c2, count,
+                    linear.c0, linear.c1, linear.c2);
+}
+
+//? https://bottosson.github.io/posts/oklab/
+static void LinearToOklabKernel(const float* __restrict in0,
+                                const float* __restrict in1,
+                                const float* __restrict in2, size_t count,
+                                float* __restrict out0, float* __restrict out1,
+                                float* __restrict out2) {
+  for (size_t i = 0; i < count; i++) {
+    float r = in0[i], g = in1[i], b = in2[i];
+    float l = Cbrt(0.4122214708f * r + 0.5363325363f * g + 0.0514459929f * b);
+    float m = Cbrt(0.2119034982f * r + 0.6806995451f * g + 0.1073969566f * b);
+    float s = Cbrt(0.0883024619f * r + 0.2817188376f * g + 0.6299787005f * b);
+
+    out0[i] = 0.2104542553f * l + 0.7936177850f * m - 0.0040720468f * s;
+    out1[i] = 1.9779984951f * l - 2.4285922050f * m + 0.4505937099f * s;
+    out2[i] = 0.0259040371f * l + 0.7827717662f * m - 0.8086757660f * s;
+  }
+}
+
+void LinearToOklab(ColorSpan linear, size_t count, ColorSpan oklab) {
+  LinearToOklabKernel(linear.c0, linear.c1, linear.c2, count,
+                      oklab.c0, oklab.c1, oklab.c2);
+}
+
+static void OklabToLinearKernel(const float* __restrict in0,
+                                const float* __restrict in1,
+                                const float* __restrict in2, size_t count,
+                                float* __restrict out0, float* __restrict out1,
+                                float* __restrict out2) {
+  for (size_t i = 0; i < count; i++) {
+    float L = in0[i], a = in1[i], b = in2[i];
+    float l = L + 0.3963377774f * a + 0.2158037573f * b;
+    float m = L - 0.1055613458f * a - 0.0638541728f * b;
+    float s = L - 0.0894841775f * a - 1.2914855480f * b;
+    l = l * l * l;
+    m = m * m * m;
+    s = s * s * s;
+
+    out0[i] = 4.0767416621f * l - 3.3077115913f * m + 0.2309699292f * s;
+    out1[i] = -1.2684380046f * l + 2.6097574011f * m - 0.3413193965f * s;
+    out2[i] = -0.0041960863f * l - 0.7034186147f * m + 1.7076147010f * s;
+  }
+}
+
+void OklabToLinear(ColorSpan oklab, size_t count, ColorSpan linear) {
+  OklabToLinearKernel(oklab.c0, oklab.c1, oklab.c2, count,
+                      linear.c0, linear.c1, linear.c2);
+}
+
+static void OklabToOklchKernel(const float* __restrict in0,
+                               const float* __restrict in1,
+                               const float* __restrict in2, size_t count,
+                               float* __restrict out0, float* __restrict out1,
+                               float* __restrict out2) {
+  for (size_t i = 0; i < count; i++) {
+    float a = in1[i], b = in2[i];
+    float h = atan2f(b, a) * (180.0f / PI);
+    out0[i] = in0[i];
+    out1[i] = sqrtf(a * a + b * b);
+    out2[i] = h < 0 ? h + 360.0f : h;
+  }
+}
+
+void OklabToOklch(ColorSpan oklab, size_t count, ColorSpan oklch) {
+  OklabToOklchKernel(oklab.c0, oklab.c1, oklab.c2, count,
+                     oklch.c0, oklch.c1, oklch.c2);
+}
+
+static void OklchToOklabKernel(const float* __restrict in0,
+                               const float* __restrict in1,
+                               const float* __restrict in2, size_t count,
+                               float* __restrict out0, float* __restrict out1,
+                               float* __restrict out2) {
+  for (size_t i = 0; i < count; i++) {
+    float c = in1[i], h = in2[i] * (PI / 180.0f);
+    out0[i] = in0[i];
+    out1[i] = c * cosf(h);
+    out2[i] = c * sinf(h);
+  }
+}
+
+void OklchToOklab(ColorSpan oklch, size_t count, ColorSpan oklab) {
+  OklchToOklabKernel(oklch.c0, oklch.c1, oklch.c2, count,
+                     oklab.c0, oklab.c1, oklab.c2);
+}
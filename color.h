@@ -0,0 +1,41 @@
+#pragma once
+
+#include <cstddef>
+
+//& 批量颜色空间转换
+//? 所有转换都按通道分开存放 (SoA)，一次处理一整段，循环里没有分支，便于编译器向量化
+//? 输入和输出不能重叠 (内核按 restrict 编译)
+//? RGB 取值 0~1；H 单位为度 (0~360)；Lab 用 D65 白点
+
+struct ColorSpan {
+  float* c0;
+  float* c1;
+  float* c2;
+};
+
+//? 单个颜色当作长度为 1 的 span
+inline ColorSpan PixelSpan(float c[3]) { return {&c[0], &c[1], &c[2]}; }
+
+//& 8 位 BGRA (截图格式) 拆成 float
+void UnpackSrgb(const unsigned char* bgra, size_t count, ColorSpan rgb);
+//? 查表得到线性 RGB，结果和 SrgbToLinear 一致
+void UnpackLinear(const unsigned char* bgra, size_t count, ColorSpan rgb);
+
+void SrgbToLinear(ColorSpan srgb, size_t count, ColorSpan linear);
+void LinearToSrgb(ColorSpan linear, size_t count, ColorSpan srgb);
+
+//& 下面两组以 sRGB (非线性) 为输入输出
+void RgbToHsv(ColorSpan rgb, size_t count, ColorSpan hsv);
+void HsvToRgb(ColorSpan hsv, size_t count, ColorSpan rgb);
+void RgbToHsl(ColorSpan rgb, size_t count, ColorSpan hsl);
+void HslToRgb(ColorSpan hsl, size_t count, ColorSpan rgb);
+
+//& 下面几组以线性 RGB 为输入输出
+void LinearToLab(ColorSpan linear, size_t count, ColorSpan lab);
+void LabToLinear(ColorSpan lab, size_t count, ColorSpan linear);
+void LinearToOklab(ColorSpan linear, size_t count, ColorSpan oklab);
+void OklabToLinear(ColorSpan oklab, size_t count, ColorSpan linear);
+
+//? L 不变, a b 转成 C h
+void OklabToOklch(ColorSpan oklab, size_t count, ColorSpan oklch);
+void OklchToOklab(ColorSpan oklch, size_t count, ColorSpan oklab);
@@ -0,0 +1,206 @@
+#pragma once
+
+// 由 tools/bakefont.cpp 从 fonts/Px437_Acer_VGA_8x8.ttf 生成，不要手改
+
+#include <cstdint>
+
+#define FONT8X8_ASCENDER 7  // 基线以上的行数
+
+//? 每个字形 8 行，每行一个字节，最高位是最左边的像素
+constexpr unsigned char font8x8Ascii[128][8] = {
+    {0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00},  // U+0000
+    {0x7E, 0x81, 0xA5, 0x81, 0xBD, 0x99, 0x81, 0x7E},  // U+0001
+    {0x7C, 0xFE, 0xD6, 0xFE, 0xC6, 0xFE, 0x7C, 0x00},  // U+0002
+    {0x6C, 0xFE, 0xFE, 0xFE, 0x7C, 0x38, 0x10, 0x00},  // U+0003
+    {0x10, 0x38, 0x7C, 0xFE, 0x7C, 0x38, 0x10, 0x00},  // U+0004
+    {0x10, 0x38, 0x54, 0xFE, 0x54, 0x10, 0x7C, 0x00},  // U+0005
+    {0x10, 0x38, 0x7C, 0xFE, 0xD6, 0x10, 0x7C, 0x00},  // U+0006
+    {0x00, 0x00, 0x18, 0x3C, 0x3C, 0x18, 0x00, 0x00},  // U+0007
+    {0xFF, 0xFF, 0xE7, 0xC3, 0xC3, 0xE7, 0xFF, 0xFF},  // U+0008
+    {0x00, 0x3C, 0x66, 0x42, 0x42, 0x66, 0x3C, 0x00},  // U+0009
+    {0xFF, 0xC3, 0x99, 0xBD, 0xBD, 0x99, 0xC3, 0xFF},  // U+000A
+    {0x00, 0x1E, 0x0E, 0x1E, 0x7A, 0xD8, 0xD8, 0x70},  // U+000B
+    {0x3C, 0x66, 0x66, 0x3C, 0x18, 0x7E, 0x18, 0x00},  // U+000C
+    {0x18, 0x1C, 0x1E, 0x1A, 0x18, 0x38, 0x70, 0x00},  // U+000D
+    {0x7E, 0x66, 0x7E, 0x66, 0x6E, 0xEC, 0xC0, 0x00},  // U+000E
+    {0x92, 0x7C, 0x6C, 0xC6, 0x6C, 0x7C, 0x92, 0x00},  // U+000F
+    {0x60, 0x70, 0x78, 0x7C, 0x78, 0x70, 0x60, 0x00},  // U+0010
+    {0x0C, 0x1C, 0x3C, 0x7C, 0x3C, 0x1C, 0x0C, 0x00},  // U+0011
+    {0x30, 0x78, 0xFC, 0x30, 0xFC, 0x78, 0x30, 0x00},  // U+0012
+    {0x6C, 0x6C, 0x6C, 0x6C, 0x00, 0x6C, 0x6C, 0x00},  // U+0013
+    {0x7E, 0xD4, 0xD4, 0xD4, 0x74, 0x14, 0x14, 0x00},  // U+0014
+    {0x3E, 0x60, 0x7C, 0x66, 0x3E, 0x06, 0x7C, 0x00},  // U+0015
+    {0x00, 0x00, 0xFE, 0xFE, 0xFE, 0x00, 0x00, 0x00},  // U+0016
+    {0x18, 0x7E, 0x18, 0x7E, 0x18, 0x00, 0x7E, 0x00},  // U+0017
+    {0x18, 0x3C, 0x7E, 0x18, 0x18, 0x18, 0x18, 0x00},  // U+0018
+    {0x18, 0x18, 0x18, 0x18, 0x7E, 0x3C, 0x18, 0x00},  // U+0019
+    {0x08, 0x0C, 0xFE, 0xFE, 0x0C, 0x08, 0x00, 0x00},  // U+001A
+    {0x20, 0x60, 0xFE, 0xFE, 0x60, 0x20, 0x00, 0x00},  // U+001B
+    {0x00, 0x00, 0xC0, 0xC0, 0xC0, 0xFC, 0x00, 0x00},  // U+001C
+    {0x00, 0x28, 0x6C, 0xFE, 0x6C, 0x28, 0x00, 0x00},  // U+001D
+    {0x00, 0x10, 0x38, 0x7C, 0xFE, 0xFE, 0x00, 0x00},  // U+001E
+    {0x00, 0xFE, 0xFE, 0x7C, 0x38, 0x10, 0x00, 0x00},  // U+001F
+    {0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00},  // U+0020
+    {0x18, 0x3C, 0x3C, 0x18, 0x18, 0x00, 0x18, 0x00},  // U+0021
+    {0x6C, 0x6C, 0x48, 0x00, 0x00, 0x00, 0x00, 0x00},  // U+0022
+    {0x6C, 0x6C, 0xFE, 0x6C, 0xFE, 0x6C, 0x6C, 0x00},  // U+0023
+    {0x18, 0x7E, 0xC0, 0x7C, 0x06, 0xFC, 0x30, 0x00},  // U+0024
+    {0x62, 0x66, 0x0C, 0x18, 0x30, 0x66, 0xC6, 0x00},  // U+0025
+    {0x38, 0x6C, 0x38, 0x76, 0xDC, 0xCC, 0x76, 0x00},  // U+0026
+    {0x18, 0x30, 0x40, 0x00, 0x00, 0x00, 0x00, 0x00},  // U+0027
+    {0x0C, 0x18, 0x30, 0x30, 0x30, 0x18, 0x0C, 0x00},  // U+0028
+    {0x30, 0x18, 0x0C, 0x0C, 0x0C, 0x18, 0x30, 0x00},  // U+0029
+    {0x10, 0xD6, 0x7C, 0x38, 0x7C, 0xD6, 0x10, 0x00},  // U+002A
+    {0x00, 0x18, 0x18, 0x7E, 0x18, 0x18, 0x00, 0x00},  // U+002B
+    {0x00, 0x00, 0x00, 0x00, 0x00, 0x30, 0x30, 0x60},  // U+002C
+    {0x00, 0x00, 0x00, 0xFE, 0x00, 0x00, 0x00, 0x00},  // U+002D
+    {0x00, 0x00, 0x00, 0x00, 0x00, 0x30, 0x30, 0x00},  // U+002E
+    {0x02, 0x06, 0x0C, 0x18, 0x30, 0x60, 0xC0, 0x00},  // U+002F
+    {0x38, 0x6C, 0xC6, 0xC6, 0xC6, 0x6C, 0x38, 0x00},  // U+0030
+    {0x18, 0x38, 0x78, 0x18, 0x18, 0x18, 0x7E, 0x00},  // U+0031
+    {0x3C, 0x66, 0x06, 0x1C, 0x30, 0x66, 0x7E, 0x00},  // U+0032
+    {0x7E, 0x06, 0x0C, 0x1C, 0x06, 0x66, 0x3C, 0x00},  // U+0033
+    {0x1C, 0x3C, 0x6C, 0xCC, 0xFE, 0x0C, 0x1E, 0x00},  // U+0034
+    {0x7E, 0x60, 0x60, 0x7C, 0x06, 0x66, 0x7C, 0x00},  // U+0035
+    {0x3C, 0x60, 0xC0, 0xFC, 0xC6, 0xC6, 0x7C, 0x00},  // U+0036
+    {0xFE, 0xC6, 0x0C, 0x18, 0x30, 0x30, 0x30, 0x00},  // U+0037
+    {0x7C, 0xC6, 0xC6, 0x7C, 0xC6, 0xC6, 0x7C, 0x00},  // U+0038
+    {0x7C, 0xC6, 0xC6, 0x7E, 0x06, 0x0C, 0x78, 0x00},  // U+0039
+    {0x00, 0x00, 0x18, 0x18, 0x00, 0x18, 0x18, 0x00},  // U+003A
+    {0x00, 0x00, 0x18, 0x18, 0x00, 0x18, 0x18, 0x30},  // U+003B
+    {0x0C, 0x18, 0x30, 0x60, 0x30, 0x18, 0x0C, 0x00},  // U+003C
+    {0x00, 0x00, 0xFE, 0x00, 0xFE, 0x00, 0x00, 0x00},  // U+003D
+    {0x30, 0x18, 0x0C, 0x06, 0x0C, 0x18, 0x30, 0x00},  // U+003E
+    {0x3C, 0x66, 0x66, 0x0C, 0x18, 0x00, 0x18, 0x00},  // U+003F
+    {0x7C, 0xC6, 0xDE, 0xD6, 0xCC, 0xC2, 0x7C, 0x00},  // U+0040
+    {0x38, 0x6C, 0xC6, 0xC6, 0xFE, 0xC6, 0xC6, 0x00},  // U+0041
+    {0xFC, 0x66, 0x66, 0x7C, 0x66, 0x66, 0xFC, 0x00},  // U+0042
+    {0x3C, 0x66, 0xC0, 0xC0, 0xC0, 0x66, 0x3C, 0x00},  // U+0043
+    {0xF8, 0x6C, 0x66, 0x66, 0x66, 0x6C, 0xF8, 0x00},  // U+0044
+    {0xFE, 0x62, 0x68, 0x78, 0x68, 0x62, 0xFE, 0x00},  // U+0045
+    {0xFE, 0x62, 0x68, 0x78, 0x68, 0x60, 0x60, 0x00},  // U+0046
+    {0x3C, 0x66, 0xC0, 0xC0, 0xCE, 0x66, 0x3E, 0x00},  // U+0047
+    {0xC6, 0xC6, 0xC6, 0xFE, 0xC6, 0xC6, 0xC6, 0x00},  // U+0048
+    {0x3C, 0x18, 0x18, 0x18, 0x18, 0x18, 0x3C, 0x00},  // U+0049
+    {0x3E, 0x0C, 0x0C, 0x0C, 0xCC, 0xDC, 0x78, 0x00},  // U+004A
+    {0xE6, 0x66, 0x6C, 0x78, 0x6C, 0x66, 0xE6, 0x00},  // U+004B
+    {0xF0, 0x60, 0x60, 0x60, 0x62, 0x66, 0x7E, 0x00},  // U+004C
+    {0xC6, 0xEE, 0xFE, 0xD6, 0xC6, 0xC6, 0xC6, 0x00},  // U+004D
+    {0xC6, 0xE6, 0xF6, 0xDE, 0xCE, 0xC6, 0xC6, 0x00},  // U+004E
+    {0x7C, 0xC6, 0xC6, 0xC6, 0xC6, 0xC6, 0x7C, 0x00},  // U+004F
+    {0xFC, 0x66, 0x66, 0x7C, 0x60, 0x60, 0xF0, 0x00},  // U+0050
+    {0x7C, 0xC6, 0xC6, 0xC6, 0xD6, 0xDE, 0x7C, 0x06},  // U+0051
+    {0xFC, 0x66, 0x66, 0x7C, 0x6C, 0x66, 0xE6, 0x00},  // U+0052
+    {0x7C, 0xC6, 0xC0, 0x7C, 0x06, 0xC6, 0x7C, 0x00},  // U+0053
+    {0x7E, 0x5A, 0x18, 0x18, 0x18, 0x18, 0x3C, 0x00},  // U+0054
+    {0x66, 0x66, 0x66, 0x66, 0x66, 0x66, 0x3C, 0x00},  // U+0055
+    {0xC6, 0xC6, 0xC6, 0xC6, 0x6C, 0x38, 0x10, 0x00},  // U+0056
+    {0xC6, 0xC6, 0xD6, 0xD6, 0xD6, 0xFE, 0x6C, 0x00},  // U+0057
+    {0xC6, 0x6C, 0x38, 0x38, 0x6C, 0xC6, 0xC6, 0x00},  // U+0058
+    {0x66, 0x66, 0x66, 0x3C, 0x18, 0x18, 0x3C, 0x00},  // U+0059
+    {0xFE, 0x86, 0x0C, 0x18, 0x32, 0x66, 0xFE, 0x00},  // U+005A
+    {0x3C, 0x30, 0x30, 0x30, 0x30, 0x30, 0x3C, 0x00},  // U+005B
+    {0x80, 0xC0, 0x60, 0x30, 0x18, 0x0C, 0x06, 0x00},  // U+005C
+    {0x3C, 0x0C, 0x0C, 0x0C, 0x0C, 0x0C, 0x3C, 0x00},  // U+005D
+    {0x18, 0x3C, 0x66, 0x00, 0x00, 0x00, 0x00, 0x00},  // U+005E
+    {0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xFE},  // U+005F
+    {0x20, 0x60, 0x60, 0x60, 0x00, 0x00, 0x00, 0x00},  // U+0060
+    {0x00, 0x00, 0x78, 0x0C, 0x7C, 0xCC, 0x76, 0x00},  // U+0061
+    {0xE0, 0x60, 0x7C, 0x66, 0x66, 0x66, 0xDC, 0x00},  // U+0062
+    {0x00, 0x00, 0x3C, 0x66, 0x60, 0x66, 0x3C, 0x00},  // U+0063
+    {0x0E, 0x0C, 0x7C, 0xCC, 0xCC, 0xCC, 0x76, 0x00},  // U+0064
+    {0x00, 0x00, 0x78, 0xCC, 0xFC, 0xC0, 0x7C, 0x00},  // U+0065
+    {0x1C, 0x30, 0x30, 0xFC, 0x30, 0x30, 0x78, 0x00},  // U+0066
+    {0x00, 0x00, 0x7E, 0xCC, 0xCC, 0x7C, 0x0C, 0xF8},  // U+0067
+    {0xE0, 0x60, 0x7C, 0x66, 0x66, 0x66, 0xE6, 0x00},  // U+0068
+    {0x18, 0x00, 0x38, 0x18, 0x18, 0x18, 0x3C, 0x00},  // U+0069
+    {0x0C, 0x00, 0x0C, 0x0C, 0x0C, 0xCC, 0xCC, 0x78},  // U+006A
+    {0xE0, 0x60, 0x66, 0x6C, 0x78, 0x6C, 0xE6, 0x00},  // U+006B
+    {0x38, 0x18, 0x18, 0x18, 0x18, 0x18, 0x3C, 0x00},  // U+006C
+    {0x00, 0x00, 0xFC, 0xD6, 0xD6, 0xD6, 0xD6, 0x00},  // U+006D
+    {0x00, 0x00, 0xFC, 0x66, 0x66, 0x66, 0x66, 0x00},  // U+006E
+    {0x00, 0x00, 0x3C, 0x66, 0x66, 0x66, 0x3C, 0x00},  // U+006F
+    {0x00, 0x00, 0xFC, 0x66, 0x66, 0x7C, 0x60, 0xF0},  // U+0070
+    {0x00, 0x00, 0x7E, 0xCC, 0xCC, 0x7C, 0x0C, 0x1E},  // U+0071
+    {0x00, 0x00, 0xDC, 0x76, 0x66, 0x60, 0xF0, 0x00},  // U+0072
+    {0x00, 0x00, 0x3E, 0x60, 0x3C, 0x06, 0x7C, 0x00},  // U+0073
+    {0x30, 0x30, 0xFC, 0x30, 0x30, 0x36, 0x1C, 0x00},  // U+0074
+    {0x00, 0x00, 0xCC, 0xCC, 0xCC, 0xCC, 0x76, 0x00},  // U+0075
+    {0x00, 0x00, 0xCC, 0xCC, 0xCC, 0x78, 0x30, 0x00},  // U+0076
+    {0x00, 0x00, 0xC6, 0xD6, 0xD6, 0xFE, 0x6C, 0x00},  // U+0077
+    {0x00, 0x00, 0xC6, 0x6C, 0x38, 0x6C, 0xC6, 0x00},  // U+0078
+    {0x00, 0x00, 0xC6, 0xC6, 0x6C, 0x38, 0x30, 0xE0},  // U+0079
+    {0x00, 0x00, 0x7E, 0x4C, 0x18, 0x32, 0x7E, 0x00},  // U+007A
+    {0x1C, 0x30, 0x30, 0x70, 0x30, 0x30, 0x1C, 0x00},  // U+007B
+    {0x18, 0x18, 0x18, 0x00, 0x18, 0x18, 0x18, 0x00},  // U+007C
+    {0x70, 0x18, 0x18, 0x1C, 0x18, 0x18, 0x70, 0x00},  // U+007D
+    {0x00, 0x76, 0xDC, 0x00, 0x00, 0x00, 0x00, 0x00},  // U+007E
+    {0x00, 0x10, 0x38, 0x6C, 0xC6, 0xC6, 0xFE, 0x00},  // U+007F
+};
+
+struct Font8x8Glyph {
+  uint32_t codepoint;
+  unsigned char rows[8];
+};
+
+//? 字体里有的 Latin-1 字符 (比如 HSV 行的 °)
+constexpr Font8x8Glyph font8x8Latin1[] = {
+    {0x00A0, {0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00}},
+    {0x00A1, {0x18, 0x00, 0x18, 0x18, 0x3C, 0x3C, 0x18, 0x00}},
+    {0x00A2, {0x06, 0x7C, 0xCE, 0xD0, 0xE6, 0x7C, 0xC0, 0x00}},
+    {0x00A3, {0x1C, 0x30, 0xFE, 0x30, 0x70, 0xB6, 0xEC, 0x00}},
+    {0x00A5, {0x66, 0x66, 0x3C, 0x7E, 0x18, 0x7E, 0x18, 0x00}},
+    {0x00A7, {0x3E, 0x60, 0x7C, 0x66, 0x3E, 0x06, 0x7C, 0x00}},
+    {0x00AA, {0xF8, 0x6C, 0xCC, 0x76, 0x00, 0xFE, 0x00, 0x00}},
+    {0x00AB, {0x00, 0x36, 0x6C, 0xD8, 0x6C, 0x36, 0x00, 0x00}},
+    {0x00AC, {0x00, 0x00, 0xFC, 0x0C, 0x0C, 0x00, 0x00, 0x00}},
+    {0x00B0, {0x18, 0x24, 0x24, 0x18, 0x00, 0x00, 0x00, 0x00}},
+    {0x00B1, {0x18, 0x18, 0x7E, 0x18, 0x18, 0x00, 0x7E, 0x00}},
+    {0x00B2, {0x3C, 0x66, 0x0C, 0x30, 0x7E, 0x00, 0x00, 0x00}},
+    {0x00B5, {0x00, 0x66, 0x66, 0x66, 0x66, 0xDC, 0x80, 0x00}},
+    {0x00B6, {0x7E, 0xD4, 0xD4, 0xD4, 0x74, 0x14, 0x14, 0x00}},
+    {0x00B7, {0x00, 0x00, 0x00, 0x18, 0x00, 0x00, 0x00, 0x00}},
+    {0x00BA, {0x3C, 0x66, 0x66, 0x3C, 0x00, 0x7E, 0x00, 0x00}},
+    {0x00BB, {0x00, 0xD8, 0x6C, 0x36, 0x6C, 0xD8, 0x00, 0x00}},
+    {0x00BC, {0xC6, 0xCC, 0xDA, 0x36, 0x6A, 0xCE, 0x82, 0x00}},
+    {0x00BD, {0xC6, 0xCC, 0xD8, 0x3C, 0x66, 0xCC, 0x9E, 0x00}},
+    {0x00BF, {0x30, 0x00, 0x30, 0x30, 0x66, 0x66, 0x3C, 0x00}},
+    {0x00C4, {0x6C, 0x00, 0x38, 0x6C, 0xC6, 0xFE, 0xC6, 0x00}},
+    {0x00C5, {0x38, 0x44, 0x38, 0x6C, 0xC6, 0xFE, 0xC6, 0x00}},
+    {0x00C6, {0x3E, 0x78, 0xD8, 0xDE, 0xF8, 0xD8, 0xDE, 0x00}},
+    {0x00C7, {0x7C, 0xC0, 0xC6, 0x7C, 0x18, 0x0C, 0x78, 0x00}},
+    {0x00C9, {0x0C, 0x18, 0x7E, 0x60, 0x7C, 0x60, 0x7E, 0x00}},
+    {0x00D1, {0x62, 0x9C, 0x00, 0xCC, 0xEC, 0xDC, 0xCC, 0x00}},
+    {0x00D6, {0x36, 0x00, 0x3C, 0x66, 0x66, 0x66, 0x3C, 0x00}},
+    {0x00DC, {0x66, 0x00, 0x66, 0x66, 0x66, 0x66, 0x3C, 0x00}},
+    {0x00DF, {0x1C, 0x36, 0x36, 0x7C, 0x66, 0x66, 0xDC, 0x80}},
+    {0x00E0, {0x30, 0x18, 0x78, 0x0C, 0x7C, 0xCC, 0x76, 0x00}},
+    {0x00E1, {0x18, 0x30, 0x78, 0x0C, 0x7C, 0xCC, 0x76, 0x00}},
+    {0x00E2, {0x38, 0x44, 0x78, 0x0C, 0x7C, 0xCC, 0x76, 0x00}},
+    {0x00E4, {0x6C, 0x00, 0x78, 0x0C, 0x7C, 0xCC, 0x76, 0x00}},
+    {0x00E5, {0x38, 0x44, 0x78, 0x0C, 0x7C, 0xCC, 0x76, 0x00}},
+    {0x00E6, {0x00, 0x00, 0xEC, 0x3A, 0x7E, 0xB8, 0xEE, 0x00}},
+    {0x00E7, {0x78, 0xC0, 0xCC, 0x78, 0x18, 0x0C, 0x78, 0x00}},
+    {0x00E8, {0x18, 0x0C, 0x3C, 0x66, 0x7E, 0x60, 0x3E, 0x00}},
+    {0x00E9, {0x0C, 0x18, 0x3C, 0x66, 0x7E, 0x60, 0x3E, 0x00}},
+    {0x00EA, {0x1C, 0x22, 0x3C, 0x66, 0x7E, 0x60, 0x3E, 0x00}},
+    {0x00EB, {0x36, 0x00, 0x3C, 0x66, 0x7E, 0x60, 0x3E, 0x00}},
+    {0x00EC, {0x30, 0x18, 0x38, 0x18, 0x18, 0x18, 0x3C, 0x00}},
+    {0x00ED, {0x18, 0x30, 0x38, 0x18, 0x18, 0x18, 0x3C, 0x00}},
+    {0x00EE, {0x38, 0x44, 0x38, 0x18, 0x18, 0x18, 0x3C, 0x00}},
+    {0x00EF, {0x36, 0x00, 0x38, 0x18, 0x18, 0x18, 0x3C, 0x00}},
+    {0x00F1, {0x62, 0x9C, 0x00, 0xB8, 0xCC, 0xCC, 0xCC, 0x00}},
+    {0x00F2, {0x30, 0x18, 0x3C, 0x66, 0x66, 0x66, 0x3C, 0x00}},
+    {0x00F3, {0x0C, 0x18, 0x3C, 0x66, 0x66, 0x66, 0x3C, 0x00}},
+    {0x00F4, {0x38, 0x44, 0x3C, 0x66, 0x66, 0x66, 0x3C, 0x00}},
+    {0x00F6, {0x6C, 0x00, 0x3C, 0x66, 0x66, 0x66, 0x3C, 0x00}},
+    {0x00F7, {0x18, 0x18, 0x00, 0x7E, 0x00, 0x18, 0x18, 0x00}},
+    {0x00F9, {0x30, 0x18, 0x00, 0xCC, 0xCC, 0xCC, 0x76, 0x00}},
+    {0x00FA, {0x18, 0x30, 0xCC, 0xCC, 0xCC, 0xCC, 0x76, 0x00}},
+    {0x00FB, {0x38, 0x44, 0x00, 0xCC, 0xCC, 0xCC, 0x76, 0x00}},
+    {0x00FC, {0x6C, 0x00, 0xCC, 0xCC, 0xCC, 0xCC, 0x76, 0x00}},
+    {0x00FF, {0x6C, 0x00, 0xC6, 0x6C, 0x38, 0x30, 0xE0, 0x00}},
+};
+
+constexpr int font8x8Latin1Count =
+    sizeof(font8x8Latin1) / sizeof(font8x8Latin1[0]);
@@ -0,0 +1,92 @@
+#include "glload.h"
+
+#include <stdio.h>
+
+namespace glload {
+#define GLLOAD_DEFINE(ret, name, params, args) PFN_##name name;
+GL_CORE_FUNCTIONS(GLLOAD_DEFINE)
+#undef GLLOAD_DEFINE
+
+template <class... T>
+static void Unused(const T&...) {}
+
+//? 可选函数一开始指向这里的蹦床，第一次调用时换成驱动的地址再转过去
+//? 驱动没有的函数换成什么都不做的 Missing_ 版本，函数指针永远不会是空的，
+//? 没先用 GLHas 检查就调用也只是没有效果
+#define GLLOAD_LAZY(ret, name, params, args)         \
+  static ret GLLOAD_APIENTRY Missing_##name params { \
+    Unused args;                                     \
+    return ret();                                    \
+  }                                                  \
+  static ret GLLOAD_APIENTRY Lazy_##name params {    \
+    GLHas(GLOPT_##name);                             \
+    return name args;                                \
+  }                                                  \
+  PFN_##name name = Lazy_##name;
+GL_OPTIONAL_FUNCTIONS(GLLOAD_LAZY)
+#undef GLLOAD_LAZY
+}  // namespace glload
+
+namespace {
+GLLoadProc loader;
+int versionMajor, versionMinor;
+
+struct OptionalEntry {
+  const char* name;
+  void** slot;
+  void* lazy;
+  void* missing;
+  bool loaded;
+  bool available;
+};
+
+#define GLLOAD_ENTRY(ret, name, params, args)                \
+  {#name, (void**)&glload::name, (void*)glload::Lazy_##name, \
+   (void*)glload::Missing_##name, false, false},
+OptionalEntry optionalEntries[GL_OPTIONAL_COUNT] = {
+    GL_OPTIONAL_FUNCTIONS(GLLOAD_ENTRY)};
+#undef GLLOAD_ENTRY
+}  // namespace
+
+bool LoadGL(GLLoadProc getProc, int major, int minor) {
+  loader = getProc;
+  for (OptionalEntry& entry : optionalEntries) {
+    *entry.slot = entry.lazy;
+    entry.loaded = false;
+    entry.available = false;
+  }
+
+  //? 先看版本，不够的话别的都不用取
+  glload::glGetString = (glload::PFN_glGetString)getProc("glGetString");
+  if (!glload::glGetString) return false;
+  const char* version = (const char*)glload::glGetString(GL_VERSION);
+  if (!version ||
+      sscanf(version, "%d.%d", &versionMajor, &versionMinor) != 2 ||
+      !GLVersionAtLeast(major, minor)) {
+    return false;
+  }
+
+  bool complete = true;
+#define GLLOAD_RESOLVE(ret, name, params, args)      \
+  glload::name = (glload::PFN_##name)getProc(#name); \
+  complete = complete && glload::name != nullptr;
+  GL_CORE_FUNCTIONS(GLLOAD_RESOLVE)
+#undef GLLOAD_RESOLVE
+  return complete;
+}
+
+bool GLVersionAtLeast(int major, int minor) {
+  return versionMajor > major ||
+         (versionMajor == major && versionMinor >= minor);
+}
+
+bool GLHas(GLOptional function) {
+  OptionalEntry& entry = optionalEntries[function];
+  if (!entry.loaded) {
+    void* proc = loader ? loader(entry.name) : nullptr;
+    entry.available = proc != nullptr;
+    *entry.slot = proc ? proc : entry.missing;
+    entry.loaded = true;
+  }
+  return entry.available;
+}
@@ -0,0 +1,274 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+//& 只加载用到的 GL 函数 (代替 glad 的整张表)
+//? 函数表是下面两个 X-macro 列表，要用新的函数就加一行 (和 enum)
+//? 核心函数 (3.3 以内) 在 LoadGL 时一起取，缺一个就当不支持 3.3
+//? 可选函数第一次调用时才取；可能没有的 (扩展) 调用前先用 GLHas 确认
+//? 函数指针放在 glload 命名空间里，不会和 libGL / opengl32 导出的同名符号冲突
+
+#if defined(_WIN32)
+#define GLLOAD_APIENTRY __stdcall
+#else
+#define GLLOAD_APIENTRY
+#endif
+
+typedef unsigned int GLenum;
+typedef unsigned char GLboolean;
+typedef unsigned int GLbitfield;
+typedef int GLint;
+typedef unsigned int GLuint;
+typedef int GLsizei;
+typedef float GLfloat;
+typedef char GLchar;
+typedef unsigned char GLubyte;
+typedef ptrdiff_t GLintptr;
+typedef ptrdiff_t GLsizeiptr;
+typedef uint64_t GLuint64;
+typedef struct __GLsync* GLsync;
+
+#define GL_FALSE 0
+#define GL_TRUE 1
+
+#define GL_TRIANGLES 0x0004
+#define GL_SRC_ALPHA 0x0302
+#define GL_ONE_MINUS_SRC_ALPHA 0x0303
+#define GL_BLEND 0x0BE2
+#define GL_SCISSOR_TEST 0x0C11
+#define GL_UNPACK_ALIGNMENT 0x0CF5
+#define GL_PACK_ALIGNMENT 0x0D05
+#define GL_TEXTURE_2D 0x0DE1
+#define GL_UNSIGNED_BYTE 0x1401
+#define GL_UNSIGNED_INT 0x1405
+#define GL_FLOAT 0x1406
+#define GL_RED 0x1903
+#define GL_RGBA 0x1908
+#define GL_VERSION 0x1F02
+#define GL_NEAREST 0x2600
+#define GL_LINEAR 0x2601
+#define GL_LINEAR_MIPMAP_LINEAR 0x2703
+#define GL_TEXTURE_MAG_FILTER 0x2800
+#define GL_TEXTURE_MIN_FILTER 0x2801
+#define GL_TEXTURE_WRAP_S 0x2802
+#define GL_TEXTURE_WRAP_T 0x2803
+#define GL_COLOR_BUFFER_BIT 0x00004000
+#define GL_RGBA8 0x8058
+#define GL_TEXTURE_3D 0x806F
+#define GL_TEXTURE_WRAP_R 0x8072
+#define GL_BGRA 0x80E1
+#define GL_CLAMP_TO_BORDER 0x812D
+#define GL_CLAMP_TO_EDGE 0x812F
+#define GL_TEXTURE_MIN_LOD 0x813A
+#define GL_TEXTURE_MAX_LEVEL 0x813D
+#define GL_TEXTURE0 0x84C0
+#define GL_TEXTURE1 0x84C1
+#define GL_TEXTURE2 0x84C2
+#define GL_QUERY_RESULT 0x8866
+#define GL_QUERY_RESULT_AVAILABLE 0x8867
+#define GL_ARRAY_BUFFER 0x8892
+#define GL_ELEMENT_ARRAY_BUFFER 0x8893
+#define GL_STREAM_DRAW 0x88E0
+#define GL_STATIC_DRAW 0x88E4
+#define GL_TIME_ELAPSED 0x88BF
+#define GL_FRAGMENT_SHADER 0x8B30
+#define GL_VERTEX_SHADER 0x8B31
+#define GL_COMPILE_STATUS 0x8B81
+#define GL_LINK_STATUS 0x8B82
+#define GL_READ_FRAMEBUFFER 0x8CA8
+#define GL_DRAW_FRAMEBUFFER 0x8CA9
+#define GL_FRAMEBUFFER_COMPLETE 0x8CD5
+#define GL_COLOR_ATTACHMENT0 0x8CE0
+#define GL_FRAMEBUFFER 0x8D40
+#define GL_RENDERBUFFER 0x8D41
+#define GL_SYNC_GPU_COMMANDS_COMPLETE 0x9117
+#define GL_SYNC_FLUSH_COMMANDS_BIT 0x00000001
+#define GL_MAP_WRITE_BIT 0x0002
+#define GL_MAP_INVALIDATE_RANGE_BIT 0x0004
+#define GL_MAP_UNSYNCHRONIZED_BIT 0x0020
+#define GL_MAP_PERSISTENT_BIT 0x0040
+#define GL_MAP_COHERENT_BIT 0x0080
+
+// clang-format off
+//? X(返回类型, 名字, (参数), (实参))
+#define GL_CORE_FUNCTIONS(X)                                                  \
+  X(void, glActiveTexture, (GLenum texture), (texture))                       \
+  X(void, glAttachShader, (GLuint program, GLuint shader), (program, shader)) \
+  X(void, glBeginQuery, (GLenum target, GLuint id), (target, id))             \
+  X(void, glBindBuffer, (GLenum target, GLuint buffer), (target, buffer))     \
+  X(void, glBindFramebuffer, (GLenum target, GLuint fb), (target, fb))        \
+  X(void, glBindRenderbuffer, (GLenum target, GLuint rb), (target, rb))       \
+  X(void, glBindTexture, (GLenum target, GLuint texture), (target, texture))  \
+  X(void, glBindVertexArray, (GLuint array), (array))                         \
+  X(void, glBlendFunc, (GLenum sfactor, GLenum dfactor), (sfactor, dfactor))  \
+  X(void, glBlitFramebuffer,                                                  \
+    (GLint srcX0, GLint srcY0, GLint srcX1, GLint srcY1, GLint dstX0,         \
+     GLint dstY0, GLint dstX1, GLint dstY1, GLbitfield mask, GLenum filter),  \
+    (srcX0, srcY0, srcX1, srcY1, dstX0, dstY0, dstX1, dstY1, mask, filter))   \
+  X(void, glBufferData,                                                       \
+    (GLenum target, GLsizeiptr size, const void* data, GLenum usage),         \
+    (target, size, data, usage))                                              \
+  X(GLenum, glCheckFramebufferStatus, (GLenum target), (target))              \
+  X(void, glClear, (GLbitfield mask), (mask))                                 \
+  X(void, glClearColor, (GLfloat r, GLfloat g, GLfloat b, GLfloat a),         \
+    (r, g, b, a))                                                             \
+  X(GLenum, glClientWaitSync,                                                 \
+    (GLsync sync, GLbitfield flags, GLuint64 timeout),                        \
+    (sync, flags, timeout))                                                   \
+  X(void, glCompileShader, (GLuint shader), (shader))                         \
+  X(GLuint, glCreateProgram, (), ())                                          \
+  X(GLuint, glCreateShader, (GLenum type), (type))                            \
+  X(void, glDeleteBuffers, (GLsizei n, const GLuint* ids), (n, ids))          \
+  X(void, glDeleteFramebuffers, (GLsizei n, const GLuint* ids), (n, ids))     \
+  X(void, glDeleteQueries, (GLsizei n, const GLuint* ids), (n, ids))          \
+  X(void, glDeleteRenderbuffers, (GLsizei n, const GLuint* ids), (n, ids))    \
+  X(void, glDeleteShader, (GLuint shader), (shader))                          \
+  X(void, glDeleteSync, (GLsync sync), (sync))                                \
+  X(void, glDeleteTextures, (GLsizei n, const GLuint* ids), (n, ids))         \
+  X(void, glDeleteVertexArrays, (GLsizei n, const GLuint* ids), (n, ids))     \
+  X(void, glDisable, (GLenum cap), (cap))                                     \
+  X(void, glDrawArrays, (GLenum mode, GLint first, GLsizei count),            \
+    (mode, first, count))                                                     \
+  X(void, glDrawElements,                                                     \
+    (GLenum mode, GLsizei count, GLenum type, const void* indices),           \
+    (mode, count, type, indices))                                             \
+  X(void, glEnable, (GLenum cap), (cap))                                      \
+  X(void, glEndQuery, (GLenum target), (target))                              \
+  X(void, glEnableVertexAttribArray, (GLuint index), (index))                 \
+  X(GLsync, glFenceSync, (GLenum condition, GLbitfield flags),                \
+    (condition, flags))                                                       \
+  X(void, glFinish, (), ())                                                   \
+  X(void, glFramebufferRenderbuffer,                                          \
+    (GLenum target, GLenum attachment, GLenum rbtarget, GLuint rb),           \
+    (target, attachment, rbtarget, rb))                                       \
+  X(void, glFramebufferTexture2D,                                             \
+    (GLenum target, GLenum attachment, GLenum textarget, GLuint texture,      \
+     GLint level),                                                            \
+    (target, attachment, textarget, texture, level))                          \
+  X(void, glGenBuffers, (GLsizei n, GLuint* ids), (n, ids))                   \
+  X(void, glGenFramebuffers, (GLsizei n, GLuint* ids), (n, ids))              \
+  X(void, glGenQueries, (GLsizei n, GLuint* ids), (n, ids))                   \
+  X(void, glGenRenderbuffers, (GLsizei n, GLuint* ids), (n, ids))             \
+  X(void, glGenTextures, (GLsizei n, GLuint* ids), (n, ids))                  \
+  X(void, glGenVertexArrays, (GLsizei n, GLuint* ids), (n, ids))              \
+  X(void, glGetProgramInfoLog,                                                \
+    (GLuint program, GLsizei size, GLsizei* length, GLchar* log),             \
+    (program, size, length, log))                                             \
+  X(void, glGetProgramiv, (GLuint program, GLenum pname, GLint* params),      \
+    (program, pname, params))                                                 \
+  X(void, glGetQueryObjectiv, (GLuint id, GLenum pname, GLint* params),       \
+    (id, pname, params))                                                      \
+  X(void, glGetQueryObjectui64v,                                              \
+    (GLuint id, GLenum pname, GLuint64* params),                              \
+    (id, pname, params))                                                      \
+  X(void, glGetShaderInfoLog,                                                 \
+    (GLuint shader, GLsizei size, GLsizei* length, GLchar* log),              \
+    (shader, size, length, log))                                              \
+  X(void, glGetShaderiv, (GLuint shader, GLenum pname, GLint* params),        \
+    (shader, pname, params))                                                  \
+  X(const GLubyte*, glGetString, (GLenum name), (name))                       \
+  X(GLint, glGetUniformLocation, (GLuint program, const GLchar* name),        \
+    (program, name))                                                          \
+  X(void, glLinkProgram, (GLuint program), (program))                         \
+  X(void*, glMapBufferRange,                                                  \
+    (GLenum target, GLintptr offset, GLsizeiptr length, GLbitfield access),   \
+    (target, offset, length, access))                                         \
+  X(void, glPixelStorei, (GLenum pname, GLint param), (pname, param))         \
+  X(void, glReadPixels,                                                       \
+    (GLint x, GLint y, GLsizei width, GLsizei height, GLenum format,          \
+     GLenum type, void* pixels),                                              \
+    (x, y, width, height, format, type, pixels))                              \
+  X(void, glRenderbufferStorage,                                              \
+    (GLenum target, GLenum format, GLsizei width, GLsizei height),            \
+    (target, format, width, height))                                          \
+  X(void, glScissor, (GLint x, GLint y, GLsizei width, GLsizei height),       \
+    (x, y, width, height))                                                    \
+  X(void, glShaderSource,                                                     \
+    (GLuint shader, GLsizei count, const GLchar* const* string,               \
+     const GLint* length),                                                    \
+    (shader, count, string, length))                                          \
+  X(void, glTexImage2D,                                                       \
+    (GLenum target, GLint level, GLint internalformat, GLsizei width,         \
+     GLsizei height, GLint border, GLenum format, GLenum type,                \
+     const void* pixels),                                                     \
+    (target, level, internalformat, width, height, border, format, type,      \
+     pixels))                                                                 \
+  X(void, glTexImage3D,                                                       \
+    (GLenum target, GLint level, GLint internalformat, GLsizei width,         \
+     GLsizei height, GLsizei depth, GLint border, GLenum format, GLenum type, \
+     const void* pixels),                                                     \
+    (target, level, internalformat, width, height, depth, border, format,     \
+     type, pixels))                                                           \
+  X(void, glTexParameterf, (GLenum target, GLenum pname, GLfloat param),      \
+    (target, pname, param))                                                   \
+  X(void, glTexParameteri, (GLenum target, GLenum pname, GLint param),        \
+    (target, pname, param))                                                   \
+  X(void, glTexSubImage2D,                                                    \
+    (GLenum target, GLint level, GLint x, GLint y, GLsizei width,             \
+     GLsizei height, GLenum format, GLenum type, const void* pixels),         \
+    (target, level, x, y, width, height, format, type, pixels))               \
+  X(void, glTexSubImage3D,                                                    \
+    (GLenum target, GLint level, GLint x, GLint y, GLint z, GLsizei width,    \
+     GLsizei height, GLsizei depth, GLenum format, GLenum type,               \
+     const void* pixels),                                                     \
+    (target, level, x, y, z, width, height, depth, format, type, pixels))     \
+  X(void, glUniform1f, (GLint location, GLfloat v0), (location, v0))          \
+  X(void, glUniform1i, (GLint location, GLint v0), (location, v0))            \
+  X(void, glUniform2i, (GLint location, GLint v0, GLint v1),                  \
+    (location, v0, v1))                                                       \
+  X(void, glUniform2fv,                                                       \
+    (GLint location, GLsizei count, const GLfloat* value),                    \
+    (location, count, value))                                                 \
+  X(void, glUniform4fv,                                                       \
+    (GLint location, GLsizei count, const GLfloat* value),                    \
+    (location, count, value))                                                 \
+  X(void, glUniformMatrix4fv,                                                 \
+    (GLint location, GLsizei count, GLboolean transpose,                      \
+     const GLfloat* value),                                                   \
+    (location, count, transpose, value))                                      \
+  X(GLboolean, glUnmapBuffer, (GLenum target), (target))                      \
+  X(void, glUseProgram, (GLuint program), (program))                          \
+  X(void, glVertexAttribPointer,                                              \
+    (GLuint index, GLint size, GLenum type, GLboolean normalized,             \
+     GLsizei stride, const void* pointer),                                    \
+    (index, size, type, normalized, stride, pointer))                         \
+  X(void, glViewport, (GLint x, GLint y, GLsizei width, GLsizei height),      \
+    (x, y, width, height))
+
+//? glBufferStorage 是 4.4 / ARB_buffer_storage
+#define GL_OPTIONAL_FUNCTIONS(X)                                              \
+  X(void, glBufferStorage,                                                    \
+    (GLenum target, GLsizeiptr size, const void* data, GLbitfield flags),     \
+    (target, size, data, flags))
+// clang-format on
+
+namespace glload {
+#define GLLOAD_DECLARE(ret, name, params, args)    \
+  typedef ret(GLLOAD_APIENTRY* PFN_##name) params; \
+  extern PFN_##name name;
+GL_CORE_FUNCTIONS(GLLOAD_DECLARE)
+GL_OPTIONAL_FUNCTIONS(GLLOAD_DECLARE)
+#undef GLLOAD_DECLARE
+}  // namespace glload
+
+#define GLLOAD_USING(ret, name, params, args) using glload::name;
+GL_CORE_FUNCTIONS(GLLOAD_USING)
+GL_OPTIONAL_FUNCTIONS(GLLOAD_USING)
+#undef GLLOAD_USING
+
+enum GLOptional {
+#define GLLOAD_ENUM(ret, name, params, args) GLOPT_##name,
+  GL_OPTIONAL_FUNCTIONS(GLLOAD_ENUM)
+#undef GLLOAD_ENUM
+  GL_OPTIONAL_COUNT
+};
+
+typedef void* (*GLLoadProc)(const char* name);
+
+//? 取核心函数，版本不到 major.minor 或者缺函数时返回 false
+//? 换了上下文要重新调一次，可选函数也会回到未加载的状态
+bool LoadGL(GLLoadProc getProc, int major, int minor);
+bool GLVersionAtLeast(int major, int minor);
+//? 取一次可选函数 (只取一次)，返回驱动有没有给
+bool GLHas(GLOptional function);
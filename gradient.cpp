@@ -0,0 +1,174 @@
+#include "gradient.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+
+#include "parallel.h"
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+//? 边界两侧像素的梯度之和低于这个值不算边 (约等于亮度差 8)
+#define SNAP_THRESHOLD 16
+
+//? 一行 BGRA 转成亮度，权重和 Rec.709 一致，定点 (和为 256)
+static void LumaRow(const unsigned char* bgra, int width, unsigned char* dst) {
+  int x = 0;
+#ifdef __SSE2__
+  // 一次 8 个像素: 通道拆到 32 位再压成 16 位，乘加最多 255 * 256 不会溢出
+  // (按无符号看)，逻辑右移 8 位后压回字节
+  const __m128i mask = _mm_set1_epi32(0xff);
+  const __m128i wr = _mm_set1_epi16(54);
+  const __m128i wg = _mm_set1_epi16(183);
+  const __m128i wb = _mm_set1_epi16(19);
+  for (; x + 8 <= width; x += 8) {
+    __m128i p0 = _mm_loadu_si128((const __m128i*)(bgra + x * 4));
+    __m128i p1 = _mm_loadu_si128((const __m128i*)(bgra + x * 4 + 16));
+    __m128i r = _mm_packs_epi32(_mm_and_si128(_mm_srli_epi32(p0, 16), mask),
+                                _mm_and_si128(_mm_srli_epi32(p1, 16), mask));
+    __m128i g = _mm_packs_epi32(_mm_and_si128(_mm_srli_epi32(p0, 8), mask),
+                                _mm_and_si128(_mm_srli_epi32(p1, 8), mask));
+    __m128i b = _mm_packs_epi32(_mm_and_si128(p0, mask),
+                                _mm_and_si128(p1, mask));
+    __m128i sum = _mm_add_epi16(
+        _mm_add_epi16(_mm_mullo_epi16(r, wr), _mm_mullo_epi16(g, wg)),
+        _mm_mullo_epi16(b, wb));
+    sum = _mm_srli_epi16(sum, 8);
+    _mm_storel_epi64((__m128i*)(dst + x), _mm_packus_epi16(sum, sum));
+  }
+#endif
+  for (; x < width; x++) {
+    const unsigned char* p = bgra + x * 4;
+    dst[x] = (unsigned char)((54 * p[2] + 183 * p[1] + 19 * p[0]) >> 8);
+  }
+}
+
+//? 单个像素的 Sobel，越界的列取边上的像素
+static void SobelAt(const unsigned char* up, const unsigned char* mid,
+                    const unsigned char* down, int x, int width,
+                    unsigned char* gx, unsigned char* gy) {
+  int l = std::max(x - 1, 0);
+  int r = std::min(x + 1, width - 1);
+  int dx = (up[r] - up[l]) + 2 * (mid[r] - mid[l]) + (down[r] - down[l]);
+  int dy = (up[l] + 2 * up[x] + up[r]) - (down[l] + 2 * down[x] + down[r]);
+  gx[x] = (unsigned char)(abs(dx) >> 2);
+  gy[x] = (unsigned char)(abs(dy) >> 2);
+}
+
+//? 一行梯度，up / down 是上下相邻的亮度行 (越界的行由调用方换成本行)
+static void SobelRow(const unsigned char* up, const unsigned char* mid,
+                     const unsigned char* down, int width, unsigned char* gx,
+                     unsigned char* gy) {
+  if (width <= 0) return;
+  SobelAt(up, mid, down, 0, width, gx, gy);
+  int x = 1;
+#ifdef __SSE2__
+  // 一次 8 个像素，16 位上算，最大 4 * 255 不会溢出
+  const __m128i zero = _mm_setzero_si128();
+  for (; x + 9 <= width; x += 8) {
+    __m128i ul = _mm_unpacklo_epi8(
+        _mm_loadl_epi64((const __m128i*)(up + x - 1)), zero);
+    __m128i uc = _mm_unpacklo_epi8(
+        _mm_loadl_epi64((const __m128i*)(up + x)), zero);
+    __m128i ur = _mm_unpacklo_epi8(
+        _mm_loadl_epi64((const __m128i*)(up + x + 1)), zero);
+    __m128i ml = _mm_unpacklo_epi8(
+        _mm_loadl_epi64((const __m128i*)(mid + x - 1)), zero);
+    __m128i mr = _mm_unpacklo_epi8(
+        _mm_loadl_epi64((const __m128i*)(mid + x + 1)), zero);
+    __m128i dl = _mm_unpacklo_epi8(
+        _mm_loadl_epi64((const __m128i*)(down + x - 1)), zero);
+    __m128i dc = _mm_unpacklo_epi8(
+        _mm_loadl_epi64((const __m128i*)(down + x)), zero);
+    __m128i dr = _mm_unpacklo_epi8(
+        _mm_loadl_epi64((const __m128i*)(down + x + 1)), zero);
+
+    __m128i dx = _mm_add_epi16(_mm_sub_epi16(ur, ul), _mm_sub_epi16(dr, dl));
+    __m128i dm = _mm_sub_epi16(mr, ml);
+    dx = _mm_add_epi16(dx, _mm_add_epi16(dm, dm));
+    __m128i dy = _mm_sub_epi16(_mm_add_epi16(ul, ur), _mm_add_epi16(dl, dr));
+    __m128i dv = _mm_sub_epi16(uc, dc);
+    dy = _mm_add_epi16(dy, _mm_add_epi16(dv, dv));
+
+    // |v| = max(v, -v)
+    dx = _mm_max_epi16(dx, _mm_sub_epi16(zero, dx));
+    dy = _mm_max_epi16(dy, _mm_sub_epi16(zero, dy));
+    dx = _mm_srli_epi16(dx, 2);
+    dy = _mm_srli_epi16(dy, 2);
+    _mm_storel_epi64((__m128i*)(gx + x), _mm_packus_epi16(dx, dx));
+    _mm_storel_epi64((__m128i*)(gy + x), _mm_packus_epi16(dy, dy));
+  }
+#endif
+  for (; x < width; x++) SobelAt(up, mid, down, x, width, gx, gy);
+}
+
+void ComputeGradientField(const unsigned char* bgra, int width, int height,
+                          GradientField& field) {
+  size_t count = (size_t)width * height;
+  std::vector<unsigned char> luma(count);
+  field.width = width;
+  field.height = height;
+  field.gx.resize(count);
+  field.gy.resize(count);
+
+  ParallelFor(0, height, [&](int begin, int end) {
+    for (int y = begin; y < end; y++) {
+      LumaRow(bgra + (size_t)y * width * 4, width,
+              luma.data() + (size_t)y * width);
+    }
+  });
+
+  ParallelFor(0, height, [&](int begin, int end) {
+    for (int y = begin; y < end; y++) {
+      const unsigned char* mid = luma.data() + (size_t)y * width;
+      const unsigned char* up = y + 1 < height ? mid + width : mid;
+      const unsigned char* down = y > 0 ? mid - width : mid;
+      size_t offset = (size_t)y * width;
+      SobelRow(up, mid, down, width, field.gx.data() + offset,
+               field.gy.data() + offset);
+    }
+  });
+}
+
+//? line 是这条线上第 0 个像素，stride 是相邻像素的间隔，count 个像素
+//? 边界 b 在像素 b - 1 和 b 之间，强度是两侧像素的梯度之和
+static int SnapAlong(const unsigned char* line, size_t stride, int count,
+                     float pos, int radius) {
+  auto strength = [&](int b) {
+    return line[(b - 1) * stride] + line[b * stride];
+  };
+
+  int center = (int)lroundf(pos);
+  int lo = std::max(center - radius, 1);
+  int hi = std::min(center + radius, count - 1);
+  int best = -1;
+  float bestDistance = 0.0f;
+  for (int b = lo; b <= hi; b++) {
+    if (strength(b) < SNAP_THRESHOLD) continue;
+    float distance = fabsf(b - pos);
+    if (best < 0 || distance < bestDistance) {
+      best = b;
+      bestDistance = distance;
+    }
+  }
+  if (best < 0) return -1;
+
+  // 抗锯齿或者模糊的边有好几个边界都够强，爬到最强的那个
+  while (best < hi && strength(best + 1) > strength(best)) best++;
+  while (best > lo && strength(best - 1) > strength(best)) best--;
+  return best;
+}
+
+int SnapEdgeX(const GradientField& field, float x, int row, int radius) {
+  if (row < 0 || row >= field.height || field.gx.empty()) return -1;
+  const unsigned char* line = field.gx.data() + (size_t)row * field.width;
+  return SnapAlong(line, 1, field.width, x, radius);
+}
+
+int SnapEdgeY(const GradientField& field, int column, float y, int radius) {
+  if (column < 0 || column >= field.width || field.gy.empty()) return -1;
+  const unsigned char* line = field.gy.data() + column;
+  return SnapAlong(line, field.width, field.height, y, radius);
+}
@@ -0,0 +1,24 @@
+#pragma once
+
+#include <vector>
+
+//& 截图的 Sobel 梯度场，给标尺吸附边缘用
+//? 每次截图算一次: 先转成亮度，再按行交给 ParallelFor 做 3x3 Sobel
+//? 只存横竖两个方向的绝对值 (除以 4，正好放进一个字节)，行序和截图一样
+//? 查询只扫一条线上几十个字节，拖动时每帧调用也不用缓存
+
+struct GradientField {
+  int width, height;
+  std::vector<unsigned char> gx;  // 竖直的边 (左右亮度不同)
+  std::vector<unsigned char> gy;  // 水平的边
+};
+
+void ComputeGradientField(const unsigned char* bgra, int width, int height,
+                          GradientField& field);
+
+//? 第 row 行上离 x 最近的竖直边，返回像素边界的坐标 (1 ~ width - 1)
+//? 先找 radius 以内最近的够强的边界，再往更强的方向爬到这条边的峰值
+//? 没有就返回 -1
+int SnapEdgeX(const GradientField& field, float x, int row, int radius);
+//? 第 column 列上离 y 最近的水平边
+int SnapEdgeY(const GradientField& field, int column, float y, int radius);
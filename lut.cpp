@@ -0,0 +1,215 @@
+#include "lut.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+#include "color.h"
+
+namespace {
+
+// Machado, Oliveira, Fernandes 2009，严重程度 1.0，作用在线性 RGB 上
+const float kProtan[9] = {0.152286f,  1.052583f,  -0.204868f,
+                          0.114503f,  0.786281f,  0.099216f,
+                          -0.003882f, -0.048116f, 1.051998f};
+const float kDeutan[9] = {0.367322f,  0.860646f, -0.227968f,
+                          0.280085f,  0.672501f, 0.047413f,
+                          -0.011820f, 0.042940f, 0.968881f};
+const float kTritan[9] = {1.255528f,  -0.076749f, -0.178779f,
+                          -0.078411f, 0.930809f,  0.147602f,
+                          0.004733f,  0.691367f,  0.303900f};
+// 线性 Display P3 -> 线性 sRGB
+const float kP3ToSrgb[9] = {1.2249f,  -0.2247f, 0.0f,     //
+                            -0.0420f, 1.0419f,  0.0f,     //
+                            -0.0197f, -0.0786f, 1.0979f};
+
+void ApplyMatrix(const float m[9], ColorSpan c, size_t count) {
+  for (size_t i = 0; i < count; i++) {
+    float r = c.c0[i], g = c.c1[i], b = c.c2[i];
+    c.c0[i] = m[0] * r + m[1] * g + m[2] * b;
+    c.c1[i] = m[3] * r + m[4] * g + m[5] * b;
+    c.c2[i] = m[6] * r + m[7] * g + m[8] * b;
+  }
+}
+
+float Saturate(float v) { return std::min(std::max(v, 0.0f), 1.0f); }
+
+//? Google 的 turbo 多项式近似，输出已经是显示用的 sRGB
+void Turbo(float x, float out[3]) {
+  x = Saturate(x);
+  float x2 = x * x, x3 = x2 * x, x4 = x2 * x2, x5 = x4 * x;
+  out[0] = 0.13572138f + 4.61539260f * x - 42.66032258f * x2 +
+           132.13108234f * x3 - 152.94239396f * x4 + 59.28637943f * x5;
+  out[1] = 0.09140261f + 2.19418839f * x + 4.84296658f * x2 -
+           14.18503333f * x3 + 4.27729857f * x4 + 2.82956604f * x5;
+  out[2] = 0.10667330f + 12.64194608f * x - 60.58204836f * x2 +
+           110.36276771f * x3 - 89.90310912f * x4 + 27.34824973f * x5;
+}
+
+//? sRGB 值上的 Rec.709 亮度
+float Luma(float r, float g, float b) {
+  return 0.2126f * r + 0.7152f * g + 0.0722f * b;
+}
+
+}  // namespace
+
+const char* ColorTransformName(ColorTransform transform) {
+  switch (transform) {
+    case TRANSFORM_PROTAN:
+      return "PROTAN";
+    case TRANSFORM_DEUTAN:
+      return "DEUTAN";
+    case TRANSFORM_TRITAN:
+      return "TRITAN";
+    case TRANSFORM_STRETCH:
+      return "STRETCH";
+    case TRANSFORM_FALSE_COLOR:
+      return "FALSE COLOR";
+    case TRANSFORM_GAMUT:
+      return "GAMUT P3";
+    default:
+      return "NONE";
+  }
+}
+
+LutImageStats ComputeLutImageStats(const unsigned char* bgra, int width,
+                                   int height) {
+  uint32_t hist[256] = {};
+  size_t count = (size_t)width * height;
+  for (size_t i = 0; i < count; i++) {
+    const unsigned char* p = bgra + i * 4;
+    // 和 Luma 一样的权重，定点 (和为 256)
+    hist[(54 * p[2] + 183 * p[1] + 19 * p[0]) >> 8]++;
+  }
+
+  // 第一个让累计数超过 count * fraction 的亮度
+  auto percentile = [&](double fraction) {
+    uint64_t target = (uint64_t)(count * fraction);
+    uint64_t acc = 0;
+    for (int v = 0; v < 256; v++) {
+      acc += hist[v];
+      if (acc > target) return v / 255.0f;
+    }
+    return 1.0f;
+  };
+  LutImageStats stats;
+  stats.low = percentile(0.01);
+  stats.median = percentile(0.5);
+  stats.high = percentile(0.99);
+  return stats;
+}
+
+void BuildColorLut(ColorTransform transform, const LutImageStats& stats,
+                   int size, unsigned char* out) {
+  size_t count = (size_t)size * size * size;
+  std::vector<float> buffer(count * 6);
+  ColorSpan srgb = {&buffer[0], &buffer[count], &buffer[count * 2]};
+  ColorSpan work = {&buffer[count * 3], &buffer[count * 4],
+                    &buffer[count * 5]};
+
+  // 格点，R 变化最快
+  float step = 1.0f / (size - 1);
+  for (size_t i = 0; i < count; i++) {
+    srgb.c0[i] = (i % size) * step;
+    srgb.c1[i] = (i / size % size) * step;
+    srgb.c2[i] = (i / size / size) * step;
+  }
+
+  switch (transform) {
+    case TRANSFORM_PROTAN:
+    case TRANSFORM_DEUTAN:
+    case TRANSFORM_TRITAN: {
+      const float* m = transform == TRANSFORM_PROTAN   ? kProtan
+                       : transform == TRANSFORM_DEUTAN ? kDeutan
+                                                       : kTritan;
+      SrgbToLinear(srgb, count, work);
+      ApplyMatrix(m, work, count);
+      for (size_t i = 0; i < count; i++) {
+        work.c0[i] = Saturate(work.c0[i]);
+        work.c1[i] = Saturate(work.c1[i]);
+        work.c2[i] = Saturate(work.c2[i]);
+      }
+      LinearToSrgb(work, count, srgb);
+      break;
+    }
+    case TRANSFORM_STRETCH: {
+      // 1%~99% 拉到 0~1，再用 gamma 把中位数放到 0.5
+      float range = stats.high - stats.low;
+      if (range < 1.0f / 255) break;
+      float mid = Saturate((stats.median - stats.low) / range);
+      float gamma = 1.0f;
+      if (mid > 0.0f && mid < 1.0f) {
+        gamma = std::min(std::max(logf(0.5f) / logf(mid), 0.25f), 4.0f);
+      }
+      float* channels[3] = {srgb.c0, srgb.c1, srgb.c2};
+      for (float* c : channels) {
+        for (size_t i = 0; i < count; i++) {
+          c[i] = powf(Saturate((c[i] - stats.low) / range), gamma);
+        }
+      }
+      break;
+    }
+    case TRANSFORM_FALSE_COLOR: {
+      SrgbToLinear(srgb, count, work);
+      ColorSpan oklab = {srgb.c0, srgb.c1, srgb.c2};
+      LinearToOklab(work, count, oklab);
+      for (size_t i = 0; i < count; i++) {
+        float c[3];
+        Turbo(oklab.c0[i], c);
+        srgb.c0[i] = c[0];
+        srgb.c1[i] = c[1];
+        srgb.c2[i] = c[2];
+      }
+      break;
+    }
+    case TRANSFORM_GAMUT: {
+      // 当作 P3 转到 sRGB，超出范围的是 sRGB 显示不了的颜色
+      SrgbToLinear(srgb, count, work);
+      ApplyMatrix(kP3ToSrgb, work, count);
+      const float eps = 1e-3f;
+      for (size_t i = 0; i < count; i++) {
+        bool outside = std::min({work.c0[i], work.c1[i], work.c2[i]}) < -eps ||
+                       std::max({work.c0[i], work.c1[i], work.c2[i]}) > 1 + eps;
+        if (outside) continue;
+        float grey = 0.5f * Luma(srgb.c0[i], srgb.c1[i], srgb.c2[i]);
+        srgb.c0[i] = srgb.c1[i] = srgb.c2[i] = grey;
+      }
+      break;
+    }
+    default:
+      break;
+  }
+
+  for (size_t i = 0; i < count; i++) {
+    out[i * 4 + 0] = (unsigned char)lroundf(Saturate(srgb.c0[i]) * 255);
+    out[i * 4 + 1] = (unsigned char)lroundf(Saturate(srgb.c1[i]) * 255);
+    out[i * 4 + 2] = (unsigned char)lroundf(Saturate(srgb.c2[i]) * 255);
+    out[i * 4 + 3] = 255;
+  }
+}
+
+void LookupColorLut(const unsigned char* lut, int size,
+                    const unsigned char rgb[3], unsigned char out[3]) {
+  int base[3];
+  float frac[3];
+  for (int c = 0; c < 3; c++) {
+    float x = rgb[c] / 255.0f * (size - 1);
+    base[c] = std::min((int)x, size - 2);
+    frac[c] = x - base[c];
+  }
+
+  float sum[3] = {};
+  for (int corner = 0; corner < 8; corner++) {
+    float weight = 1.0f;
+    size_t index = 0, stride = 1;
+    for (int c = 0; c < 3; c++) {
+      int bit = (corner >> c) & 1;
+      weight *= bit ? frac[c] : 1.0f - frac[c];
+      index += (base[c] + bit) * stride;
+      stride *= size;
+    }
+    for (int c = 0; c < 3; c++) sum[c] += weight * lut[index * 4 + c];
+  }
+  for (int c = 0; c < 3; c++) out[c] = (unsigned char)lroundf(sum[c]);
+}
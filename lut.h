@@ -0,0 +1,37 @@
+#pragma once
+
+//& 颜色变换的 3D LUT: 截图画完以后每个像素查一次表，不按模式写 shader
+//? 表是 size^3 个 RGBA8，R 变化最快 (和 glTexImage3D 的顺序一致)
+//? 格点是 sRGB (非线性) 0~1 的均分，查表按三线性插值
+
+#define LUT_SIZE 33
+
+enum ColorTransform {
+  TRANSFORM_NONE,
+  TRANSFORM_PROTAN,       // 红色盲模拟 (Machado 2009，严重程度 1)
+  TRANSFORM_DEUTAN,       // 绿色盲
+  TRANSFORM_TRITAN,       // 蓝色盲
+  TRANSFORM_STRETCH,      // 对比度拉伸 + gamma，参数来自截图的亮度分布
+  TRANSFORM_FALSE_COLOR,  // OKLab 亮度映射成 turbo 伪彩色
+  TRANSFORM_GAMUT,        // 截图当作 Display P3，sRGB 以外的保留颜色，其余变灰
+  TRANSFORM_COUNT
+};
+
+const char* ColorTransformName(ColorTransform transform);
+
+//? 拉伸用的亮度 (sRGB 0~1) 的 1%、50%、99% 分位
+struct LutImageStats {
+  float low, median, high;
+};
+
+//? 整张截图 (BGRA) 的亮度直方图，单线程 (在后台线程里调用)
+LutImageStats ComputeLutImageStats(const unsigned char* bgra, int width,
+                                   int height);
+
+//? out 是 size^3 * 4 字节；stats 只有 TRANSFORM_STRETCH 用
+void BuildColorLut(ColorTransform transform, const LutImageStats& stats,
+                   int size, unsigned char* out);
+
+//? 和 GPU 一样的三线性插值，rgb 和 out 是 R G B
+void LookupColorLut(const unsigned char* lut, int size,
+                    const unsigned char rgb[3], unsigned char out[3]);
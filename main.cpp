@@ -1,23 +1,48 @@
-#include <cassert>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdarg>
 #include <cstdio>
+#include <cstring>
 #include <string>
-#include <libloaderapi.h>
-#include <tchar.h>
-#include <strsafe.h>
-#include <windowsx.h>
+#include <thread>
+#include <unordered_map>
+#include <vector>
 #include <math.h>
-#include <ShellScalingApi.h>
 
 #ifdef FREETYPE
 #include <ft2build.h>
 #include FT_FREETYPE_H
-#include <map>
 #endif
 
-#include <glad/glad.h>
+
+#include "color.h"
+#include "font8x8.h"
+#include "glload.h"
+#include "gradient.h"
+#include "lut.h"
+#include "mip.h"
+#include "parallel.h"
+#include "picker.h"
+#include "platform.h"
+#include "rendergraph.h"
+#include "sdf.h"
+#include "softrender.h"
+#include "trace.h"
 
 #define BUF_SIZE 1024
-#define REFRESH_TIMER_ID 1
+#define ATLAS_COLUMNS 16
+#define GLYPH_CACHE_SLOTS 128  // 图集里留给非 ASCII 字形的格子数
+#define SDF_PIXEL_HEIGHT 32  // 距离场图集里字形的像素高度
+#define SDF_SPREAD 4         // 距离场向字形外扩的像素数
+#define SDF_OVERSAMPLE 8     // FreeType 字形先按这个倍数光栅化
+#define SDF_CELL (SDF_PIXEL_HEIGHT + SDF_SPREAD * 2 + 1)
+#define FONT_TEXEL_SCALE (SDF_PIXEL_HEIGHT / 8)  // 点阵一个点的图集像素数
+#define TEXT_VERTEX_FLOATS 7  // x y u v r g b
+#define TEXT_RING_REGIONS 3      // 顶点环形缓冲分几段，轮流写
+#define TEXT_RING_GLYPHS 2048    // 每段最多放多少个字形
+#define TEXT_RING_REGION_FLOATS (TEXT_RING_GLYPHS * 6 * TEXT_VERTEX_FLOATS)
+#define MAX_FRAMES_IN_FLIGHT 2  // CPU 最多领先 GPU 几帧
 
 #define wheelScale 0.005
 #define scaleFriction 3.0
@@ -29,8 +54,18 @@
 #define VELOCITY_THRESHOLD 15.0
 #define INITIAL_FL_DELTA_RADIUS 250.0
 
-const wchar_t WIN_CLASS_NAME[] = _T("WHAT_8MTfo7IzrQ");
-const wchar_t MUTEX_NAME[] = _T("WHAT_1JzKDIayja");
+#define DYNRES_BUDGET_MS 4.0f  // 相机在动时截图这一趟的 GPU 预算
+#define DYNRES_MIN_SCALE 0.5f  // 内部分辨率每边最低降到一半
+#define DYNRES_STEPS 16  // 缩放按 1/16 取整，耗时的小波动不会让分辨率来回跳
+
+#define GRID_MIN_SCALE 8.0f    // 一个截图像素放大到这么多屏幕像素就画网格
+#define LABEL_MIN_SCALE 48.0f  // 放得下 6 个字符时在每个像素里写十六进制值
+
+#define LOUPE_CELLS 15   // 放大镜每边几个截图像素 (奇数，光标下的在正中)
+#define LOUPE_ZOOM 10    // 放大镜里一个截图像素占几个屏幕像素
+#define LOUPE_BORDER 2
+#define LOUPE_OFFSET 24  // 放大镜离光标的距离
+#define LOUPE_SIZE (LOUPE_CELLS * LOUPE_ZOOM + LOUPE_BORDER * 2)
 
 template <typename T>
 struct Vec2 {
@@ -104,16 +139,20 @@ typedef struct Camera {
       velocity -= velocity * dt * dragFriction;
     }
   }
+  //? 和 update 的条件一样: 还在缩放，或者松手后还在滑
+  bool isMoving(bool isDragging) {
+    return abs(deltaScale) > 0.1 ||
+           (!isDragging && velocity.length() > VELOCITY_THRESHOLD);
+  }
 } Camera;
 
-#ifdef FREETYPE
 struct Character {
-  GLuint TextureID;  // 字形纹理的ID
-  Vec2i Size;        // 字形大小
-  Vec2i Bearing;     // 从基准线到字形左部/顶部的偏移值
-  FT_Pos Advance;    // 原点距下一个字形原点的距离
+  Vec2f UVMin;    // 字形在图集里的纹理坐标 (左上)
+  Vec2f UVMax;    // 字形在图集里的纹理坐标 (右下)
+  Vec2i Size;     // 字形大小
+  Vec2i Bearing;  // 从基准线到字形左部/顶部的偏移值
+  int Advance;    // 原点距下一个字形原点的距离 (1/64 像素)
 };
-#endif
 
 struct Mat4 {
   float m[16];  // 列主序
@@ -154,6 +193,7 @@ out vec2 TexCoord;
 uniform vec2 uResolution;
 uniform vec2 cameraPos;
 uniform float cameraScale;
+uniform vec4 viewport; // 当前输出在桌面上的 x y w h (y 向上)
 
 uniform vec2 screenshotSize;
 
@@ -162,7 +202,9 @@ void main()
     // BitmapToMem 存储时已经倒过来了
     vec2 ndc = vec2((((aPos.x - cameraPos.x) / uResolution.x) * 2.0 - 1.0) * cameraScale,
         (((aPos.y + cameraPos.y ) / uResolution.y) * 2.0 - 1.0) * cameraScale);
-    gl_Position = vec4(ndc, 0, 1.0);
+    // 相机是整个桌面的，再切出当前输出的那一块
+    vec2 desktop = (ndc * 0.5 + 0.5) * uResolution;
+    gl_Position = vec4((desktop - viewport.xy) / viewport.zw * 2.0 - 1.0, 0, 1.0);
     TexCoord = aTexCoord;
 }
 )";
@@ -174,29 +216,317 @@ in vec2 TexCoord;
 out vec4 FragColor;
 
 uniform sampler2D uTexture;
+uniform float cameraScale;
+uniform float sampleScale; // 截图一个像素占画的目标几个像素 (含动态分辨率)
+uniform vec2 screenshotSize;
+uniform int filterMode; // 和 FilterMode 一致
+uniform vec2 gridScale; // 开始画网格、开始写标签的 cameraScale
+uniform sampler2D glyphAtlas; // 标签用 HUD 的距离场图集，ASCII 在前 128 格
+uniform vec4 glyphLayout; // 格子边长、外扩、点阵字形边长 (图集像素)、列数
+
+const float PI = 3.14159265;
+
+vec4 Fetch(ivec2 p)
+{
+  return texelFetch(uTexture, clamp(p, ivec2(0), ivec2(screenshotSize) - 1), 0);
+}
+
+vec4 CatmullRomWeights(float t)
+{
+  float t2 = t * t, t3 = t2 * t;
+  return vec4(-0.5 * t3 + t2 - 0.5 * t,
+              1.5 * t3 - 2.5 * t2 + 1.0,
+              -1.5 * t3 + 2.0 * t2 + 0.5 * t,
+              0.5 * t3 - 0.5 * t2);
+}
+
+vec4 Bicubic(vec2 uv)
+{
+  vec2 pos = uv * screenshotSize - 0.5;
+  vec2 f = fract(pos);
+  ivec2 base = ivec2(floor(pos)) - 1;
+  vec4 wx = CatmullRomWeights(f.x);
+  vec4 wy = CatmullRomWeights(f.y);
+  vec4 sum = vec4(0.0);
+  for (int j = 0; j < 4; j++)
+    for (int i = 0; i < 4; i++)
+      sum += Fetch(base + ivec2(i, j)) * (wx[i] * wy[j]);
+  return clamp(sum, 0.0, 1.0);
+}
+
+float Lanczos3(float x)
+{
+  if (abs(x) < 1e-4) return 1.0;
+  if (abs(x) >= 3.0) return 0.0;
+  float px = PI * x;
+  return 3.0 * sin(px) * sin(px / 3.0) / (px * px);
+}
+
+vec4 Lanczos(vec2 uv)
+{
+  vec2 pos = uv * screenshotSize - 0.5;
+  vec2 f = fract(pos);
+  ivec2 base = ivec2(floor(pos)) - 2;
+  float wx[6], wy[6];
+  float sx = 0.0, sy = 0.0;
+  for (int i = 0; i < 6; i++) {
+    wx[i] = Lanczos3(float(i - 2) - f.x);
+    wy[i] = Lanczos3(float(i - 2) - f.y);
+    sx += wx[i];
+    sy += wy[i];
+  }
+  vec4 sum = vec4(0.0);
+  for (int j = 0; j < 6; j++)
+    for (int i = 0; i < 6; i++)
+      sum += Fetch(base + ivec2(i, j)) * (wx[i] * wy[j]);
+  return clamp(sum / (sx * sy), 0.0, 1.0);
+}
+
+bool Same(vec4 a, vec4 b)
+{
+  return all(lessThan(abs(a.rgb - b.rgb), vec3(0.5 / 255.0)));
+}
+
+// EPX (Scale2x): 每个像素按所在的四分之一块，看上下左右邻居决定要不要圆角
+vec4 PixelArt(vec2 uv)
+{
+  vec2 pos = uv * screenshotSize;
+  ivec2 p = ivec2(floor(pos));
+  vec2 f = fract(pos);
+  vec4 E = Fetch(p);
+  vec4 B = Fetch(p + ivec2(0, 1));   // 上 (纹理自下而上)
+  vec4 D = Fetch(p + ivec2(-1, 0));  // 左
+  vec4 F = Fetch(p + ivec2(1, 0));   // 右
+  vec4 H = Fetch(p + ivec2(0, -1));  // 下
+  bool left = f.x < 0.5;
+  bool up = f.y >= 0.5;
+  if (up && left && Same(D, B) && !Same(B, F) && !Same(D, H)) return D;
+  if (up && !left && Same(B, F) && !Same(B, D) && !Same(F, H)) return F;
+  if (!up && left && Same(D, H) && !Same(D, B) && !Same(H, F)) return D;
+  if (!up && !left && Same(H, F) && !Same(D, H) && !Same(B, F)) return F;
+  return E;
+}
+
+// 第 i 个字符在字形格子里 (0..1, y 向下) 的位置 g 上的覆盖率
+// 用 textureLod 并按放大倍数直接算过渡宽度，分支里不依赖屏幕空间导数
+float Glyph(int code, vec2 g, float screenPixels)
+{
+  if (any(lessThan(g, vec2(0.0))) || any(greaterThan(g, vec2(1.0))))
+    return 0.0;
+  vec2 cell = vec2(code % int(glyphLayout.w), code / int(glyphLayout.w));
+  vec2 texel = cell * glyphLayout.x + glyphLayout.y + g * glyphLayout.z;
+  float dist = textureLod(glyphAtlas, texel / textureSize(glyphAtlas, 0), 0).r;
+  // 距离场每个图集像素变化 127 / 255 / 外扩
+  float perPixel = 127.0 / 255.0 / glyphLayout.y * glyphLayout.z / screenPixels;
+  float width = 0.5 * perPixel;
+  const float edge = 128.0 / 255.0;
+  return smoothstep(edge - width, edge + width, dist);
+}
+
+// 像素中间一行 RRGGBB，宽度占像素的 80%，f 是像素内的位置 (y 向上)
+float HexLabel(vec3 color, vec2 f)
+{
+  float charSize = 0.8 / 6.0;
+  vec2 local = (f - vec2(0.1, 0.5 - charSize * 0.5)) / charSize;
+  int i = int(floor(local.x));
+  if (i < 0 || i > 5 || local.y < 0.0 || local.y >= 1.0) return 0.0;
+  int value = int(color[i / 2] * 255.0 + 0.5);
+  int nibble = (i % 2 == 0) ? value >> 4 : value & 15;
+  int code = nibble < 10 ? 48 + nibble : 55 + nibble;
+  vec2 g = vec2(local.x - float(i), 1.0 - local.y);
+  return Glyph(code, g, charSize * cameraScale);
+}
+
+vec4 SampleScreen(vec2 uv)
+{
+  // 缩小时交给硬件的三线性过滤 (mipmap 按需上传)
+  if (filterMode == 0 || filterMode == 1 || sampleScale < 1.0)
+    return texture(uTexture, uv);
+  if (filterMode == 2) return Bicubic(uv);
+  if (filterMode == 3) return Lanczos(uv);
+  return PixelArt(uv);
+}
+
+void main()
+{
+  FragColor = SampleScreen(TexCoord);
+
+  // 放得够大时在截图像素之间压暗一条网格线，再大就写上每个像素的值
+  vec2 texel = TexCoord * screenshotSize;
+  if (cameraScale >= gridScale.x && all(greaterThanEqual(texel, vec2(0.0))) &&
+      all(lessThan(texel, screenshotSize))) {
+    vec2 f = fract(texel);
+    if (any(lessThan(f * cameraScale, vec2(1.0)))) FragColor.rgb *= 0.6;
+    if (cameraScale >= gridScale.y) {
+      vec3 color = Fetch(ivec2(texel)).rgb;
+      float ink = dot(color, vec3(0.2126, 0.7152, 0.0722)) > 0.5 ? 0.0 : 1.0;
+      FragColor.rgb = mix(FragColor.rgb, vec3(ink), HexLabel(color, f));
+    }
+  }
+}
+)";
+
+//? 下面两个 pass 和截图用同一个 vertexShader，盖住的范围和截图一样
+
+//? 手电筒: 在截图上盖一层 (GL_BLEND 开着)，圆里不画
+//? 混合后是 color * (1 - s)^2 + clear * s，和原来截图先 mix(color, 0, s)
+//? 再按 alpha = 1 - s 叠到清屏色上一样 (软件渲染也是这么算的)
+std::string flashlightFragShader = R"(
+#version 330 core
+
+out vec4 FragColor;
+
 uniform vec2 mousePos;
 uniform float flShadow;
 uniform float flRadius;
 uniform float cameraScale;
 uniform vec2 windowSize;
+uniform vec4 viewport;
+
+void main()
+{
+  vec2 cursor = vec2(mousePos.x, windowSize.y - mousePos.y);
+  vec2 fragCoord = gl_FragCoord.xy + viewport.xy; // 桌面坐标
+  if (length(cursor - fragCoord) < flRadius * cameraScale) discard;
+
+  float s = flShadow;
+  FragColor = vec4(vec3(0.1) / (2.0 - s), s * (2.0 - s));
+}
+)";
+
+//? 选区描一圈屏幕上 1 像素宽的边，其余像素不画
+std::string selectionFragShader = R"(
+#version 330 core
+
+in vec2 TexCoord;
+out vec4 FragColor;
+
+uniform float cameraScale;
+uniform vec2 screenshotSize;
+uniform vec4 selection; // 截图坐标 x0 y0 x1 y1
+
+void main()
+{
+  vec2 texel = TexCoord * screenshotSize;
+  float edge = 1.0 / cameraScale;
+  bool outer = all(greaterThanEqual(texel, selection.xy - edge)) &&
+               all(lessThan(texel, selection.zw + edge));
+  bool inner = all(greaterThanEqual(texel, selection.xy)) &&
+               all(lessThan(texel, selection.zw));
+  if (!outer || inner) discard;
+  FragColor = vec4(1.0, 0.8, 0.0, 1.0);
+}
+)";
+
+//? 盖满整个目标的三角形: 放大镜用 glScissor 裁，颜色变换和边缘强调读上一个 pass
+std::string fullscreenVertShader = R"(
+#version 330 core
+
+void main()
+{
+    vec2 pos = vec2((gl_VertexID << 1) & 2, gl_VertexID & 2);
+    gl_Position = vec4(pos * 2.0 - 1.0, 0.0, 1.0);
+}
+)";
+
+std::string loupeFragShader = R"(
+#version 330 core
+
+out vec4 FragColor;
+
+uniform sampler2D uTexture;
+uniform vec2 screenshotSize;
+uniform vec4 viewport;
+uniform vec4 loupeRect;    // 桌面坐标 (y 向上) x0 y0 x1 y1，含边框
+uniform vec2 loupeCenter;  // 正中那格的截图像素
+uniform float loupeZoom;
+uniform float loupeBorder;
+uniform int loupeCells;
+
+void main()
+{
+  vec2 local = gl_FragCoord.xy + viewport.xy - loupeRect.xy - loupeBorder;
+  vec2 inner = loupeRect.zw - loupeRect.xy - 2.0 * loupeBorder;
+  if (any(lessThan(local, vec2(0.0))) || any(greaterThanEqual(local, inner))) {
+    FragColor = vec4(0.9, 0.9, 0.9, 1.0);
+    return;
+  }
+
+  ivec2 cell = ivec2(floor(local / loupeZoom));
+  ivec2 texel = ivec2(loupeCenter) + cell - loupeCells / 2;
+  vec4 color = vec4(0.1, 0.1, 0.1, 1.0);  // 截图外面和清屏色一样
+  if (all(greaterThanEqual(texel, ivec2(0))) &&
+      all(lessThan(texel, ivec2(screenshotSize))))
+    color = vec4(texelFetch(uTexture, texel, 0).rgb, 1.0);
+
+  // 每格左边和下边压暗一条当网格线，正中那格描一圈选区的颜色
+  vec2 inCell = local - vec2(cell) * loupeZoom;
+  bool edge = any(lessThan(inCell, vec2(1.0)));
+  if (edge) color.rgb *= 0.6;
+  if (cell == ivec2(loupeCells / 2) &&
+      (edge || any(greaterThanEqual(inCell, vec2(loupeZoom - 1.0)))))
+    color = vec4(1.0, 0.8, 0.0, 1.0);
+  FragColor = color;
+}
+)";
+
+//? 边缘强调: 对上一个 pass 的结果按亮度做 Sobel，边缘染成品红
+//? 输入和目标一样大，直接按 gl_FragCoord 取
+std::string edgeFragShader = R"(
+#version 330 core
+
+out vec4 FragColor;
+
+uniform sampler2D uInput;
+uniform ivec2 inputSize;
+
+float Luma(ivec2 p)
+{
+  vec3 c = texelFetch(uInput, clamp(p, ivec2(0), inputSize - 1), 0).rgb;
+  return dot(c, vec3(0.2126, 0.7152, 0.0722));
+}
 
 void main()
 {
+  ivec2 p = ivec2(gl_FragCoord.xy);
+  float tl = Luma(p + ivec2(-1, 1)), t = Luma(p + ivec2(0, 1));
+  float tr = Luma(p + ivec2(1, 1)), l = Luma(p + ivec2(-1, 0));
+  float r = Luma(p + ivec2(1, 0)), bl = Luma(p + ivec2(-1, -1));
+  float b = Luma(p + ivec2(0, -1)), br = Luma(p + ivec2(1, -1));
+  float gx = (tr + 2.0 * r + br) - (tl + 2.0 * l + bl);
+  float gy = (tl + 2.0 * t + tr) - (bl + 2.0 * b + br);
+
+  vec3 color = texelFetch(uInput, p, 0).rgb;
+  float edge = smoothstep(0.1, 0.4, length(vec2(gx, gy)));
+  FragColor = vec4(mix(color, vec3(1.0, 0.0, 1.0), edge), 1.0);
+}
+)";
+
+//? 格点在 0 和 1 上，换算到纹素中心再让硬件做三线性插值
+std::string colorFragShader = R"(
+#version 330 core
+
+out vec4 FragColor;
 
-  vec4 cursor = vec4(mousePos.x,windowSize.y - mousePos.y,0.0,1.0);
+uniform sampler2D uInput;
+uniform sampler3D lut;
+uniform float lutSize;
 
-  FragColor = mix(
-      texture(uTexture,TexCoord),
-      vec4(0.0,0.0,0.0,0.0),
-      length(cursor - gl_FragCoord) < (flRadius * cameraScale) ? 0.0 : flShadow
-      );
+void main()
+{
+  vec3 c = texelFetch(uInput, ivec2(gl_FragCoord.xy), 0).rgb;
+  vec3 uvw = c * ((lutSize - 1.0) / lutSize) + 0.5 / lutSize;
+  FragColor = vec4(texture(lut, uvw).rgb, 1.0);
 }
 )";
 
 std::string textVertShader = R"(
 #version 330 core
 layout (location = 0) in vec4 vertex; // <vec2 pos, vec2 tex>
+
+layout (location = 1) in vec3 aColor;
 out vec2 TexCoords;
+out vec3 TextColor;
 
 uniform mat4 projection;
 
@@ -204,32 +534,41 @@ void main()
 {
     gl_Position = projection * vec4(vertex.xy, 0.0, 1.0);
     TexCoords = vertex.zw;
+    TextColor = aColor;
 }
 )";
 
 std::string textfragmentShader = R"(
 #version 330 core
 in vec2 TexCoords;
+in vec3 TextColor;
 out vec4 color;
 
 uniform sampler2D text;
-uniform vec3 textColor;
+
+// 图集是距离场: 128/255 是字形边缘，用屏幕空间导数做一个像素宽的过渡
+const float edge = 128.0 / 255.0;
 
 void main()
 {
-    vec4 sampled = vec4(1.0, 1.0, 1.0, texture(text, TexCoords).r);
-    color = vec4(textColor, 1.0) * sampled;
+    float dist = texture(text, TexCoords).r;
+    float width = 0.5 * fwidth(dist);
+    color = vec4(TextColor, smoothstep(edge - width, edge + width, dist));
 }
 
 )";
 
 //& >>>>>>>>>>>> state
-HWND overlay;
-COLORREF color;
-POINT mouse_pos;
-POINT last_pos;
+Vec2i mouse_pos;  // 桌面坐标，y 向下
+Vec2i last_pos;
+
+int virtualWidth, virtualHeight;
 
-int virtualLeft, virtualTop, virtualWidth, virtualHeight;
+//? 每台显示器一个输出，各自按刷新率调 AppFrame；场景 (相机、手电筒、取色)
+//? 只有一份，按两次调用之间真实经过的时间推进
+std::vector<AppOutput> outputs;
+int currentOutput;
+double lastFrameSeconds = -1.0;
 
 FlashLight flashLight;
 Camera camera;
@@ -237,107 +576,340 @@ Camera camera;
 bool isDragging;
 float dt;
 
+//& HUD 文字: 内置 8x8 点阵，非 ASCII 且点阵里没有的字符才用 FreeType
+unsigned int pixel_height = 16;
 #ifdef FREETYPE
-std::map<GLchar, Character> Characters;
-FT_UInt pixel_height = 16;
+FT_Library ft;
+FT_Face face;  // 只在缓存未命中时才加载
+bool faceLoaded;
+std::string fontPath;
+#endif
 GLuint textVAO, textVBO;
 GLuint shader_txt;
-#endif
+//? 所有字形放在一张图集里，一帧的文字攒成一个顶点流，一次 draw call 画完
+//? 图集存的是 SDF_PIXEL_HEIGHT 大小的距离场，任意缩放都靠 shader 保持锐利
+GLuint glyphAtlas;
+const int atlasWidth = SDF_CELL * ATLAS_COLUMNS;
+const int atlasHeight = SDF_CELL * ((128 + GLYPH_CACHE_SLOTS) / ATLAS_COLUMNS);
+
+//? 顶点写进常驻映射的环形缓冲 (不支持就用不同步的 glMapBufferRange)
+//? 每段画完放一个 fence，轮到它再写之前等 GPU 用完
+GLfloat* textRingMapped;  // 常驻映射的指针，没有就是 nullptr
+GLsync textRingFences[TEXT_RING_REGIONS];
+int textRingRegion;
+GLsizei textDrawCount;
+
+//? 常驻 HUD: 每块文字的顶点排好后留着，输入值 (key) 不变就直接复用
+//? 块里的 vector 只清不释放，稳定后每帧没有内存分配也不用排版
+struct HudKey {
+  uint64_t hash = 14695981039346656037ull;  // FNV-1a
+
+  template <typename T>
+  HudKey& operator<<(const T& value) {
+    const unsigned char* p = (const unsigned char*)&value;
+    for (size_t i = 0; i < sizeof(T); i++) {
+      hash = (hash ^ p[i]) * 1099511628211ull;
+    }
+    return *this;
+  }
+};
+
+struct HudBlock {
+  bool valid;
+  uint64_t key;
+  std::vector<GLfloat> vertices;
+  std::vector<int> glyphSlots;  // 用到的缓存格子，复用时要续命
+};
+
+enum HudBlockId {
+  HUD_COLOR,
+  HUD_RULER,
+  HUD_REGION,
+  HUD_PROFILER,
+  HUD_BLOCK_COUNT
+};
+HudBlock hudBlocks[HUD_BLOCK_COUNT];
+bool hudDirty = true;  // 有块重排过，要重新写环形缓冲
+
+//? ASCII 直接查数组；其他码位放在图集后面的缓存格子里，满了淘汰最久没用的
+Character asciiGlyphs[128];
+struct GlyphSlot {
+  uint32_t codepoint;
+  uint32_t lastUsed;  // 最后一次使用的帧号，0 表示空格子
+  Character ch;
+};
+GlyphSlot glyphSlots[GLYPH_CACHE_SLOTS];
+std::unordered_map<uint32_t, int> glyphSlotIndex;
+uint32_t glyphFrame = 1;
+
+//& 每帧计数，P 键显示
+struct FrameStats {
+  int drawCalls;
+  int bufferUploads;
+  int uniformUpdates;
+  float cpuMs;
+  float waitMs;  // 等前面的帧完成用掉的时间
+};
+FrameStats frameStats, lastFrameStats;
+bool showProfiler;
+bool firstFramePresented;
 
 //& opengl
-HDC g_hdc = NULL;
-HGLRC g_glrc = NULL;
 GLuint shader_img;
+GLuint shader_flashlight, shader_selection;  // 和 shader_img 共用截图四边形
 GLuint screen_texture;
 GLuint screenVBO, screenVAO, screenEBO;
 
+//? uniform 的位置链接后只查一次；program 会一直记着 uniform 的值，
+//? 和上次提交的一样就不再调 glUniform*
+struct CachedUniform {
+  GLint location = -1;
+  GLfloat value[4];
+  int size;  // 0 表示还没提交过
+};
+//? 截图四边形上的三个 program 各一份，shader 里没有的 uniform 位置是 -1
+struct ScreenUniforms {
+  CachedUniform cameraScale, sampleScale, flShadow, flRadius;
+  CachedUniform cameraPos, mousePos, selection, filterMode, viewport;
+} screenUniforms, flashlightUniforms, selectionUniforms;
+//? 文字的投影跟着输出走，只在换了输出时重设
+GLint textProjection;
+int textProjectionOutput = -1;
+
+//? 每帧末尾放一个 fence，开始画第 N 帧前等第 N - MAX_FRAMES_IN_FLIGHT 帧，
+//? 驱动不能把帧越攒越多，输入到画面的延迟有上限
+//? 每个输出一个环: 各台显示器按自己的刷新率呈现，只等自己的帧
+struct FrameFences {
+  GLsync fences[MAX_FRAMES_IN_FLIGHT];
+  int index;
+};
+std::vector<FrameFences> frameFences;
+
+//& 软件渲染: 没有可用的 OpenGL 3.3 (或命令行带 --software) 时在 CPU 上画
+//? 画进平台层给的缓冲 (DIB section / XShm)，不碰任何 gl 函数
+bool softwareRender;
+unsigned char* softPixels;  // 第 0 行 (最下面一行)，BGRA
+int softPitch;              // 行距字节数，自上而下的缓冲是负数
+std::vector<unsigned char> atlasPixels;  // 字形图集的 CPU 副本
+
+//& 截图的放大过滤方式，M 键切换
+enum FilterMode {
+  FILTER_NEAREST,
+  FILTER_BILINEAR,
+  FILTER_BICUBIC,   // Catmull-Rom
+  FILTER_LANCZOS,   // Lanczos-3
+  FILTER_PIXELART,  // EPX
+  FILTER_MODE_COUNT
+};
+const char* filterModeNames[FILTER_MODE_COUNT] = {
+    "NEAREST", "BILINEAR", "BICUBIC", "LANCZOS3", "PIXEL ART"};
+FilterMode filterMode = FILTER_NEAREST;
+GLint screenMinFilter, screenMagFilter;
+float screenMinLod;
+
+//? mipmap 由后台线程在 CPU 上生成 (和第 0 级上传同时进行)
+//? 缩小且不是 NEAREST 时才开始上传，从最粗的一级往细的传，每帧有预算
+#define MIP_UPLOAD_BUDGET (8 << 20)  // 每帧最多上传的字节数 (至少一级)
+std::thread mipBuilder;
+std::atomic<bool> mipsBuilt;
+std::vector<unsigned char*> mipData;  // 第 i 级在 mipData[i - 1]，上传后释放
+int mipLevelCount;
+int mipUploadedFrom;  // 已经上传的最细一级，1 表示全部到齐
+bool mipsAllocated;
+
+//& 渲染图里的 pass，按执行顺序；软件渲染不用渲染图
+//? 截图 -> 颜色变换 -> 边缘强调 -> 拉伸 (动态分辨率) 可能经过池里的纹理，
+//? 后面几个都直接叠在输出上
+enum PassId {
+  PASS_SCREEN,      // 截图 (放大过滤、像素网格)
+  PASS_COLOR,       // T 键切换的颜色变换
+  PASS_EDGES,       // E 键开关
+  PASS_UPSCALE,     // 降了分辨率才有
+  PASS_FLASHLIGHT,  // 阴影完全褪掉就跳过
+  PASS_SELECTION,
+  PASS_LOUPE,
+  PASS_HUD,
+  PASS_COUNT
+};
+bool showEdges;
+GLuint shader_edges;
+CachedUniform edgeInputSize;
+
+//& 颜色变换: 截图画完后整屏查一次 3D LUT，各种模式只是表不一样
+//? 表由后台线程生成，主线程看到 lutBuilt 后 join，上传到另一张 3D 纹理
+//? 再换过去，换的那一帧之前一直用旧表，不等线程
+//? 切得比生成快时，生成完发现已经不是当前的模式就扔掉重来
+//? 软件渲染不做颜色变换
+ColorTransform colorTransform = TRANSFORM_NONE;  // 选中的
+ColorTransform lutTransform = TRANSFORM_NONE;    // 正在显示的
+ColorTransform lutBuilding = TRANSFORM_NONE;     // 后台在生成的，NONE 是空闲
+std::thread lutBuilder;
+std::atomic<bool> lutBuilt;
+std::vector<unsigned char> lutData;  // 正在显示的表，取色查它
+std::vector<unsigned char> lutNext;  // 后台线程写这个
+GLuint lutTextures[2];
+int lutTextureIndex;
+GLuint shader_color;
+
+//? 每种过滤方式的 GPU 耗时，来自截图 pass 的计时 (tag 是过滤方式)
+//? 降了分辨率的帧按像素数折算成全分辨率的耗时
+float filterGpuMs[FILTER_MODE_COUNT];
+
+//& 动态分辨率: 相机在动 (甩出去的惯性、拖动、滚轮缩放) 时截图先画进
+//? 池里小一点的纹理，再由拉伸 pass 用 glBlitFramebuffer 线性拉伸到窗口，
+//? 后面的 pass 和 HUD 还是全分辨率
+//? 控制器是闭环的: 上面实测的全分辨率耗时超出预算就按
+//? sqrt(预算 / 耗时) 缩小每边；停下来的第一帧直接回到全分辨率
+float dynresScale = 1.0f;  // 本帧用的缩放
+bool cameraMoving;
+
+//& 放大镜: L 键开关，跟着光标的一小块，固定倍数并画出像素格子
+//? 直接读 screen_texture，不另外截图也不另外上传；在输出上
+//? 用 glScissor 只画这一块，一次 draw call
+bool showLoupe;
+GLuint shader_loupe;
+struct LoupeUniforms {
+  CachedUniform viewport, rect, center;
+} loupeUniforms;
+
+//& 截图常驻内存: BGRA, 自下而上的行序 (和纹理一致)，取色直接查这里
+unsigned char* screenPixels;
+
 unsigned char pixel[4];
+
+//& 取色区域
+const int sampleSizes[] = {3, 5, 7, 9, 15, 21, 32, 48, SAMPLE_MAX_SIZE};
+const int sampleSizeCount = sizeof(sampleSizes) / sizeof(sampleSizes[0]);
+SampleMode sampleMode = SAMPLE_POINT;
+int sampleSizeIndex = 0;
+
+//& 右键框选区域，坐标是截图坐标 (和 screenPixels 一样自下而上)
+bool isSelecting;
+bool hasRegion;
+Vec2f selectStart, selectEnd;
+float selectionRect[4];  // 传给 shader 的外包矩形，全 0 表示没有选区
+RegionStats regionStats;
+int regionVersion;  // 每次重新统计加一，HUD 靠它判断要不要重排
+//? 统计在后台线程里算 (8K 整屏要上百毫秒)，主线程每帧看一眼，算好了才显示
+//? 还在算时又松开了右键就记下新的选区，这次算完再开始；
+//? 开始新的框选或者重置以后，还没算完的那次结果就不要了
+std::thread regionBuilder;
+std::atomic<bool> regionBuilt;
+bool regionBuilding;
+bool regionFound;  // 后台线程写，regionBuilt 之后主线程读
+RegionStats regionNext;
+bool regionQueued;
+int regionQueuedRect[4];  // 截图坐标 x0 y0 x1 y1
+int regionRequest;        // 每次松开右键、开始框选、重置加一
+int regionBuildRequest;   // 正在算的是哪一次
+
+//& 标尺: D 键切换，打开时右键拖出的框量宽高，不做区域统计
+//? 两端每帧都吸附到截图里最近的边 (落在像素边界上)，没有边就取最近的像素边界
+//? 梯度场在后台线程里按截图算一次，算好之前不吸附
+//? 框可以只有一个方向有长度，这时画成一条线
+#define SNAP_RADIUS 8       // 吸附范围，屏幕像素
+#define SNAP_MAX_RADIUS 64  // 缩小很多时的上限，截图像素
+bool rulerMode;
+bool hasRuler;
+int rulerSize[2];  // 截图像素
+std::thread gradientBuilder;
+std::atomic<bool> gradientReady;
+GradientField gradientField;
 //& >>>>>>>>>>>> function
-LRESULT CALLBACK WindowProc(HWND hwnd, UINT uMsg, WPARAM wParam, LPARAM lParam);
 void checkCompileErrors(GLuint shader, const std::string& type);
-void RGBtoHSV(int r, int g, int b, float& h, float& s, float& v);
-HBITMAP CaptureScreenToBitmap(int width, int height);
-unsigned char* BitmapToMem(HBITMAP hbm, int width, int height);
 
 GLuint createShader(std::string& vert, std::string& frag);
-void RenderScreen_raw();
+bool InitContext();
+void InitGLResources();
+void InitUniform(CachedUniform& u, GLuint program, const char* name);
+void InitScreenProgram(GLuint program, ScreenUniforms& u);
+void InitRenderGraph();
+void RenderFrame();
+void RenderScreenPass(const RenderTarget* input, const RenderTarget& target);
+void RenderColorPass(const RenderTarget* input, const RenderTarget& target);
+void RenderEdgePass(const RenderTarget* input, const RenderTarget& target);
+void RenderUpscalePass(const RenderTarget* input, const RenderTarget& target);
+void RenderFlashlightPass(const RenderTarget* input,
+                          const RenderTarget& target);
+void RenderSelectionPass(const RenderTarget* input,
+                         const RenderTarget& target);
+void RenderScreen_soft();
+void UpdateScreenSampler();
+void StartMipBuilder(const unsigned char* pixels, int width, int height);
+void UploadScreenMips();
+void UpdateColorLut();
+void PickPixel(float x, float y);
+void RenderText(HudBlock& block, const char* text, GLfloat x, GLfloat y,
+                GLfloat scale, Vec3f color);
+void RenderTextf(HudBlock& block, GLfloat x, GLfloat y, GLfloat scale,
+                 Vec3f color, const char* fmt, ...);
+bool BeginHudBlock(HudBlock& block, const HudKey& key);
+void InitTextRing();
+void FlushText();
+int GetCachedGlyph(uint32_t codepoint);
+void BakeBitmapGlyph(const unsigned char rows[8], unsigned char* cell,
+                     int pitch, Character& ch);
+void SetGlyphCell(Character& ch, int index);
+uint32_t DecodeUtf8(const char*& it, const char* end);
 #ifdef FREETYPE
-void RenderText(std::string& text, GLfloat x, GLfloat y, GLfloat scale,
-                Vec3f color);
+bool LoadFace();
+bool RasterizeSdfGlyph(uint32_t codepoint, unsigned char* cell, int pitch,
+                       Character& ch);
 #endif
+Vec2f WindowToImage(float x, float y);
+void UpdateSelection(bool finished);
+void UpdateRegionStats();
+Vec2f SnapToEdges(Vec2f p);
+void OutputRect(const AppOutput& output, float rect[4]);
+float ChooseRenderScale();
+float ScreenSampleScale();
+void RenderLoupe();
+void LoupeRect(int rect[4]);
 
 void RenderBegin() {
-  glViewport(0, 0, virtualWidth, virtualHeight);
+  if (softwareRender) return;  // 每个像素都会重画，不用清屏
+
+  FrameFences& ring = frameFences[currentOutput];
+  GLsync& fence = ring.fences[ring.index];
+  if (fence) {
+    auto waitStart = std::chrono::steady_clock::now();
+    glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000);
+    glDeleteSync(fence);
+    fence = 0;
+    std::chrono::duration<float, std::milli> wait =
+        std::chrono::steady_clock::now() - waitStart;
+    frameStats.waitMs = wait.count();
+  }
+
+  const AppOutput& output = outputs[currentOutput];
+  glBindFramebuffer(GL_FRAMEBUFFER, PlatformFramebuffer());
+  glViewport(0, 0, output.width, output.height);
   glClearColor(0.1, 0.1, 0.1, 1);
   glClear(GL_COLOR_BUFFER_BIT);
 }
 
-void RenderEnd() { SwapBuffers(g_hdc); }
+void RenderEnd() {
+  if (softwareRender) {
+    PlatformPresentSoftware();
+    return;
+  }
+  PlatformSwapBuffers();
+  FrameFences& ring = frameFences[currentOutput];
+  ring.fences[ring.index] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+  ring.index = (ring.index + 1) % MAX_FRAMES_IN_FLIGHT;
+}
 
 template <class T>
 T file_path(T const& path, T const& delims = "/\\") {
   return path.substr(0, path.find_last_of(delims));
 }
 
-int WINAPI wWinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance,
-                    LPWSTR pCmdLine, int nCmdShow) {
-  SetProcessDpiAwareness(PROCESS_PER_MONITOR_DPI_AWARE);
-  HANDLE hMutex = ::CreateMutex(NULL, TRUE, MUTEX_NAME);
-  if (hMutex != NULL) {
-    if (GetLastError() == ERROR_ALREADY_EXISTS) {
-      HWND handle = FindWindow(WIN_CLASS_NAME, NULL);
-      if (handle != NULL) {
-        ShowWindow(handle, SW_SHOWNORMAL);
-        SetForegroundWindow(handle);
-        return false;
-      }
-    }
-  } else {
-    MessageBoxA(NULL, "failed to execuate program", "Error",
-                MB_OK | MB_ICONERROR);
-    return false;
-  }
-
-  virtualLeft = GetSystemMetrics(SM_XVIRTUALSCREEN);
-  virtualTop = GetSystemMetrics(SM_YVIRTUALSCREEN);
-  virtualWidth = GetSystemMetrics(SM_CXVIRTUALSCREEN);
-  virtualHeight = GetSystemMetrics(SM_CYVIRTUALSCREEN);
-
-  WNDCLASSEX wcex;
-  wcex.cbSize = sizeof(wcex);
-  wcex.style = CS_HREDRAW | CS_VREDRAW;
-  wcex.lpfnWndProc = WindowProc;
-  wcex.cbClsExtra = 0;
-  wcex.cbWndExtra = 0;
-  wcex.hInstance = hInstance;
-  wcex.hIcon = LoadIcon(NULL, IDI_APPLICATION);
-  wcex.hCursor = LoadCursor(NULL, IDC_ARROW);
-  wcex.hbrBackground = (HBRUSH)CreateSolidBrush(RGB(0, 0, 0));
-  wcex.lpszMenuName = NULL;
-  wcex.lpszClassName = WIN_CLASS_NAME;
-  wcex.hIconSm = LoadIcon(NULL, IDI_APPLICATION);
-
-  RegisterClassEx(&wcex);
-
-  RegisterHotKey(NULL, 1, MOD_CONTROL | MOD_SHIFT, VK_F12);
-
-  overlay = CreateWindowEx(WS_EX_TOPMOST, WIN_CLASS_NAME, L"", WS_POPUP, 0, 0,
-                           virtualWidth, virtualHeight, NULL, NULL,
-                           GetModuleHandle(NULL), NULL);
-
-  // todo 怎么用 overlay 实现
-  // SetLayeredWindowAttributes(overlay, RGB(0, 0, 0), 0, LWA_COLORKEY);
-  // SetLayeredWindowAttributes(overlay, 0, 255, LWA_ALPHA);
-
-  if (overlay == NULL) {
-    MessageBoxA(NULL, "fail to create window failed", "Error",
-                MB_OK | MB_ICONERROR);
-    return false;
-  }
-
-  ShowWindow(overlay, nCmdShow);
-  SetWindowPos(overlay, HWND_TOP, 0, 0, 0, 0, SWP_NOMOVE | SWP_NOSIZE);
-  SetFocus(overlay);
+bool AppInit(int width, int height, const AppOutput* outputList,
+             int outputCount, bool forceSoftware) {
+  virtualWidth = width;
+  virtualHeight = height;
+  outputs.assign(outputList, outputList + outputCount);
+  frameFences.assign(outputCount, FrameFences());
 
   camera.scale = 1.0f;
   camera.deltaScale = 0.0f;
@@ -346,153 +918,620 @@ int WINAPI wWinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance,
   flashLight.isEnabled = false;
   dt = (float)1 / rate;
 
-  SetTimer(overlay, REFRESH_TIMER_ID, 16, NULL);
-
-  //& <<<<<<<<<<<<<<<<<<<<<<<<<<<<<< init opengl
-  g_hdc = GetDC(overlay);
-  PIXELFORMATDESCRIPTOR pfd = {sizeof(PIXELFORMATDESCRIPTOR)};
-  pfd.nVersion = 1;
-  pfd.dwFlags = PFD_DRAW_TO_WINDOW | PFD_SUPPORT_OPENGL | PFD_DOUBLEBUFFER;
-  pfd.iPixelType = PFD_TYPE_RGBA;
-  pfd.cColorBits = 32;
-  pfd.cAlphaBits = 8;
-  pfd.cDepthBits = 24;
-  int pf = ChoosePixelFormat(g_hdc, &pfd);
-  SetPixelFormat(g_hdc, pf, &pfd);
-
-  g_glrc = wglCreateContext(g_hdc);
-
-  assert(g_glrc != NULL && g_hdc != NULL);
-  wglMakeCurrent(g_hdc, g_glrc);
-
-  if (!gladLoadGL()) {
-    MessageBoxA(NULL, "failed to run gladLoadGL", "Error",
-                MB_OK | MB_ICONERROR);
+  screenPixels = PlatformCaptureScreen(virtualWidth, virtualHeight);
+  if (!screenPixels) {
+    PlatformShowError("Error", "failed to capture screen");
     return false;
   }
+  //? 先用最便宜的办法把截图贴出来，GL 在后面慢慢初始化，
+  //? 用户看到的是画面已经定住
+  PlatformShowCapture(screenPixels, virtualWidth, virtualHeight);
+  StartupTraceMark("first blit");
 
-  shader_img = createShader(vertexShader, fragmentShader);
+  //& <<<<<<<<<<<<<<<<<<<<<<<<<<<<<< init opengl
+  //? 建不出 3.3 的上下文 (远程桌面、虚拟机、只有 GDI Generic) 就退回软件渲染
+  softwareRender = forceSoftware || !InitContext();
 
-  glGenTextures(1, &screen_texture);
-  glGenBuffers(1, &screenVBO);
-  glGenVertexArrays(1, &screenVAO);
-  glGenBuffers(1, &screenEBO);
+  //& for text
+  // https://learnopengl-cn.github.io/06%20In%20Practice/02%20Text%20Rendering/
+#ifdef FREETYPE
+  fontPath = file_path(PlatformExeDir()) + "/fonts/Px437_Acer_VGA_8x8.ttf";
+#endif
 
-  // clang-format off
-  float vertices[] = {
-      0,                    0,  0,  0,  0,     // top left
-      (float)virtualWidth,  0,  0,  1,  0,     // top right
-      0, (float)virtualHeight,  0,  0,  1,     // bottom left
-      (float)virtualWidth,  (float)virtualHeight, 0,  1,  1 // bottom right
-  };
-  unsigned int indices[] = {
-    0,1,2,
-    1,2,3
-  };
-  // clang-format on
+  //? ASCII 的距离场由内置点阵直接生成，每个字形一格，各线程写不同的格子
+  //? 后面的缓存格子留给按需加载的字形
+  atlasPixels.assign(atlasWidth * atlasHeight, 0);
+  ParallelFor(0, 128, [&](int begin, int end) {
+    for (int c = begin; c < end; c++) {
+      unsigned char* cell = atlasPixels.data() +
+                            (c / ATLAS_COLUMNS) * SDF_CELL * atlasWidth +
+                            (c % ATLAS_COLUMNS) * SDF_CELL;
+      BakeBitmapGlyph(font8x8Ascii[c], cell, atlasWidth, asciiGlyphs[c]);
+      SetGlyphCell(asciiGlyphs[c], c);
+    }
+  });
+  StartupTraceMark("font atlas");
+
+  gradientBuilder = std::thread([] {
+    ParallelMarkBackgroundThread();
+    ComputeGradientField(screenPixels, virtualWidth, virtualHeight,
+                         gradientField);
+    gradientReady.store(true, std::memory_order_release);
+  });
+
+  if (softwareRender) {
+    softPixels =
+        PlatformCreateSoftwareTarget(virtualWidth, virtualHeight, &softPitch);
+    if (!softPixels) {
+      PlatformShowError("Error", "failed to create render target");
+      return false;
+    }
+  } else {
+    InitGLResources();
+  }
+  //& >>>>>>>>>>>>>>>>>>>>>>>>>>>>>> init opengl
+  return true;
+}
 
-  glBindVertexArray(screenVAO);
-  glBindBuffer(GL_ARRAY_BUFFER, screenVBO);
-  glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
+void AppShutdown() {
+  if (softwareRender) {
+    PlatformDestroySoftwareTarget();
+  } else {
+    glDeleteBuffers(1, &screenVBO);
+    glDeleteBuffers(1, &screenEBO);
+    glDeleteVertexArrays(1, &screenVAO);
+    glDeleteBuffers(1, &textVBO);
+    glDeleteVertexArrays(1, &textVAO);
+    glDeleteTextures(1, &glyphAtlas);
+    glDeleteTextures(2, lutTextures);
+    RenderGraphRelease();
+    PlatformDestroyContext();
+  }
 
-  glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, screenEBO);
-  glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(indices), indices,
-               GL_STATIC_DRAW);
+  if (mipBuilder.joinable()) mipBuilder.join();
+  if (lutBuilder.joinable()) lutBuilder.join();
+  if (regionBuilder.joinable()) regionBuilder.join();
+  if (gradientBuilder.joinable()) gradientBuilder.join();
+  for (unsigned char* level : mipData) delete[] level;
+  delete[] screenPixels;
 
-  glVertexAttribPointer(0, 3, GL_FLOAT, false, 5 * sizeof(float), (void*)0);
-  glEnableVertexAttribArray(0);
+#ifdef FREETYPE
+  if (faceLoaded) {
+    FT_Done_Face(face);
+    FT_Done_FreeType(ft);
+  }
+#endif
+}
 
-  glVertexAttribPointer(1, 2, GL_FLOAT, false, 5 * sizeof(float),
-                        (void*)(3 * sizeof(float)));
-  glEnableVertexAttribArray(1);
+void AppKeyUp(int key) {
+  switch (key) {
+    case 'F':
+      flashLight.isEnabled = !flashLight.isEnabled;
+      break;
+    case 'R':
+      camera.scale = 1.0f;
+      camera.deltaScale = 0.0f;
+      camera.position = Vec2f(0.0f, 0.0f);
+      camera.velocity = Vec2f(0.0f, 0.0f);
+
+      flashLight.radius = 100.0f;
+      flashLight.deltaRadius = 0.0f;
+      flashLight.isEnabled = false;
+
+      hasRegion = false;
+      regionRequest++;
+      hasRuler = false;
+      isSelecting = false;
+      memset(selectionRect, 0, sizeof(selectionRect));
+      break;
+    case 'C':
+      if (hasRegion) {
+        char text[BUF_SIZE];
+        FormatRegionStats(regionStats, text, sizeof(text));
+        PlatformCopyText(text);
+      } else if (hasRuler) {
+        char text[BUF_SIZE];
+        snprintf(text, sizeof(text), "%dx%d", rulerSize[0], rulerSize[1]);
+        PlatformCopyText(text);
+      }
+      break;
+    case 'D':
+      rulerMode = !rulerMode;
+      hasRegion = false;
+      regionRequest++;
+      hasRuler = false;
+      isSelecting = false;
+      memset(selectionRect, 0, sizeof(selectionRect));
+      break;
+    case 'E':
+      showEdges = !showEdges;
+      break;
+    case 'L':
+      showLoupe = !showLoupe;
+      break;
+    case 'T':
+      if (!softwareRender) {
+        colorTransform =
+            (ColorTransform)((colorTransform + 1) % TRANSFORM_COUNT);
+      }
+      break;
+    case 'P':
+      showProfiler = !showProfiler;
+      break;
+    case 'M':
+      filterMode = (FilterMode)((filterMode + 1) % FILTER_MODE_COUNT);
+      break;
+    case 'S':
+      sampleMode = (SampleMode)((sampleMode + 1) % SAMPLE_MODE_COUNT);
+      break;
+    case '[':
+      if (sampleSizeIndex > 0) sampleSizeIndex--;
+      break;
+    case ']':
+      if (sampleSizeIndex < sampleSizeCount - 1) sampleSizeIndex++;
+      break;
+    case APP_KEY_ESCAPE:
+      PlatformQuit();
+      break;
+    default:
+      break;
+  }
+}
 
-  auto hbitmap = CaptureScreenToBitmap(virtualWidth, virtualHeight);
-  auto data = BitmapToMem(hbitmap, virtualWidth, virtualHeight);
+void AppMouseButton(AppButton button, bool down, int x, int y) {
+  if (button == APP_BUTTON_LEFT) {
+    isDragging = down;
+    return;
+  }
+  if (down) {
+    isSelecting = true;
+    hasRegion = false;
+    regionRequest++;
+    hasRuler = false;
+    selectStart = WindowToImage(x + 0.5f, y + 0.5f);
+    selectEnd = selectStart;
+  } else if (isSelecting) {
+    selectEnd = WindowToImage(x + 0.5f, y + 0.5f);
+    UpdateSelection(true);
+  }
+}
 
-  glBindTexture(GL_TEXTURE_2D, screen_texture);
+void AppMouseWheel(int delta, bool shift, bool control) {
+  if (flashLight.isEnabled && shift) {
+    flashLight.deltaRadius += ((delta > 0) ? 1 : -1) * INITIAL_FL_DELTA_RADIUS;
+    return;
+  }
+  if (flashLight.isEnabled && control) {
+    flashLight.deltaRadius += ((delta > 0) ? 1 : -1) * INITIAL_FL_DELTA_RADIUS;
+  }
+  camera.deltaScale += delta * wheelScale;
+  camera.scalePivot = Vec2f((float)mouse_pos.x, (float)mouse_pos.y);
+}
 
-  glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, virtualWidth, virtualHeight, 0,
-               GL_BGRA, GL_UNSIGNED_BYTE, data);
-  glGenerateMipmap(GL_TEXTURE_2D);
+void AppFrame(int output, double seconds) {
+  auto frameStart = std::chrono::steady_clock::now();
+  frameStats = FrameStats();
+  currentOutput = output;
+
+  //? 第一帧按 rate 算；两个输出同一时刻进来时第二个不推进，
+  //? 卡了很久之后也不一步跳太远
+  dt = lastFrameSeconds < 0 ? (float)(1.0 / rate)
+                            : (float)fmin(seconds - lastFrameSeconds, 0.1);
+  lastFrameSeconds = seconds;
+
+  if (dt > 0) {
+    PlatformGetCursor(&mouse_pos.x, &mouse_pos.y);
+
+    bool dragged = false;
+    if (last_pos.x != mouse_pos.x || last_pos.y != mouse_pos.y) {
+      if (isDragging) {
+        //? 放大后偏移移动量减小
+        float dx = (last_pos.x - mouse_pos.x) / camera.scale;
+        float dy = (last_pos.y - mouse_pos.y) / camera.scale;
+
+        camera.position += Vec2f(dx, dy);
+        camera.velocity = Vec2f(dx / dt, dy / dt);
+        dragged = true;
+      }
+      last_pos.x = mouse_pos.x;
+      last_pos.y = mouse_pos.y;
+    }
 
-  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_BORDER);
-  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_BORDER);
+    camera.update(Vec2f(virtualWidth, virtualHeight), dt, isDragging);
+    cameraMoving = dragged || camera.isMoving(isDragging);
+    flashLight.update(dt);
 
-  glBindTexture(GL_TEXTURE_2D, 0);  // 解绑
-  glBindVertexArray(0);             // 解绑
+    // 取像素中心，和本帧画面用的是同一个相机
+    PickPixel(mouse_pos.x + 0.5f, mouse_pos.y + 0.5f);
+    if (isSelecting) {
+      selectEnd = WindowToImage(mouse_pos.x + 0.5f, mouse_pos.y + 0.5f);
+      UpdateSelection(false);
+    }
+  }
+  UpdateRegionStats();
 
-  DeleteObject(hbitmap);
-  delete data;
+  RenderBegin();
+  if (!softwareRender) {
+    dynresScale = ChooseRenderScale();
+    UpdateColorLut();
+  }
 
-  // these may not be modified
-  float ratio[2] = {(float)virtualWidth, (float)virtualHeight};
-  glUseProgram(shader_img);
-  glUniform2fv(glGetUniformLocation(shader_img, "uResolution"), 1, ratio);
-  glUniform2fv(glGetUniformLocation(shader_img, "windowSize"), 1, ratio);
+  //? HUD 按块缓存排好的顶点，key 是这块用到的输入值，值不变就不重排
+  //? 放在主显示器 (第 0 个输出) 的角上，坐标是桌面坐标 (y 向上)
+  const AppOutput& primary = outputs[0];
+  float hudLeft = (float)primary.x;
+  float hudBottom = (float)(virtualHeight - primary.y - primary.height);
+  float hudTop = hudBottom + primary.height;
+  float tx = hudLeft + 25.0f;
+  float ty = hudBottom + 20.0f;
+  float scale = 1.0f;
+  float padding = pixel_height * scale * 2;
+
+  int r = pixel[0];
+  int g = pixel[1];
+  int b = pixel[2];
+  HudKey colorKey;
+  colorKey << flashLight.isEnabled << r << g << b << lutTransform
+           << sampleMode << sampleSizeIndex << tx << ty;
+  if (BeginHudBlock(hudBlocks[HUD_COLOR], colorKey) &&
+      flashLight.isEnabled) {
+    HudBlock& block = hudBlocks[HUD_COLOR];
+    float rgb[3] = {r / 255.0f, g / 255.0f, b / 255.0f};
+    float hsv[3], linear[3], oklab[3], oklch[3];
+    RgbToHsv(PixelSpan(rgb), 1, PixelSpan(hsv));
+    SrgbToLinear(PixelSpan(rgb), 1, PixelSpan(linear));
+    LinearToOklab(PixelSpan(linear), 1, PixelSpan(oklab));
+    OklabToOklch(PixelSpan(oklab), 1, PixelSpan(oklch));
+
+    Vec3f color = Vec3f(rgb[0], rgb[1], rgb[2]);
+    float y = ty;
+
+    RenderTextf(block, tx, y, scale, color, "RGB: %d %d %d", r, g, b);
+    y += padding;
+    RenderTextf(block, tx, y, scale, color, "HEX: #%02X%02X%02X", r, g,
+                b);
+    y += padding;
+    RenderTextf(block, tx, y, scale, color, "HSV: (%.0f°, %.0f%%, %.0f%%)",
+                hsv[0], hsv[1] * 100, hsv[2] * 100);
+    y += padding;
+    RenderTextf(block, tx, y, scale, color, "OKLCH: (%.2f, %.3f, %.0f°)",
+                oklch[0], oklch[1], oklch[2]);
+    y += padding;
+
+    if (sampleMode != SAMPLE_POINT) {
+      int n = sampleSizes[sampleSizeIndex];
+      RenderTextf(block, tx, y, scale, color, "AREA: %s %dx%d",
+                  SampleModeName(sampleMode), n, n);
+      y += padding;
+    }
 
-#ifdef FREETYPE
-  //& for text
-  // https://learnopengl-cn.github.io/06%20In%20Practice/02%20Text%20Rendering/
-  char pathBuf[BUF_SIZE] = {};
-  GetModuleFileNameA(NULL, pathBuf, BUF_SIZE);
-  std::string path(pathBuf);
+    // 变换后的颜色用和画面一样的表算，字也用这个颜色
+    if (lutTransform != TRANSFORM_NONE) {
+      unsigned char mapped[3];
+      LookupColorLut(lutData.data(), LUT_SIZE, pixel, mapped);
+      Vec3f mappedColor =
+          Vec3f(mapped[0] / 255.0f, mapped[1] / 255.0f, mapped[2] / 255.0f);
+      RenderTextf(block, tx, y, scale, mappedColor, "%s: #%02X%02X%02X",
+                  ColorTransformName(lutTransform), mapped[0], mapped[1],
+                  mapped[2]);
+    }
+  }
+  if (flashLight.isEnabled) {
+    int lines = 4 + (sampleMode != SAMPLE_POINT) +
+                (lutTransform != TRANSFORM_NONE);
+    ty += padding * lines;
+  }
 
-  auto exePath = file_path(path);
-  auto fontPath = file_path(exePath) + "\\fonts\\Px437_Acer_VGA_8x8.ttf";
-  FT_Library ft;
-  FT_Face face;
+  bool showRuler = rulerMode && (isSelecting || hasRuler);
+  HudKey rulerKey;
+  rulerKey << showRuler << rulerSize[0] << rulerSize[1] << tx << ty;
+  if (BeginHudBlock(hudBlocks[HUD_RULER], rulerKey) && showRuler) {
+    HudBlock& block = hudBlocks[HUD_RULER];
+    Vec3f orange = Vec3f(1.0f, 0.8f, 0.0f);  // 和选框一样的颜色
+    RenderTextf(block, tx, ty, scale, orange, "RULER: %d x %d (%.1f)",
+                rulerSize[0], rulerSize[1],
+                hypotf((float)rulerSize[0], (float)rulerSize[1]));
+  }
+  if (showRuler) ty += padding;
+
+  HudKey regionKey;
+  regionKey << hasRegion << regionVersion << tx << ty;
+  if (BeginHudBlock(hudBlocks[HUD_REGION], regionKey) && hasRegion) {
+    HudBlock& block = hudBlocks[HUD_REGION];
+    Vec3f white = Vec3f(1.0f, 1.0f, 1.0f);
+    const RegionStats& rs = regionStats;
+
+    // 自下而上: 主色在下，汇总在上
+    for (int k = rs.dominantCount - 1; k >= 0; k--) {
+      const unsigned char* c = rs.dominant[k];
+      Vec3f color = Vec3f(c[0] / 255.0f, c[1] / 255.0f, c[2] / 255.0f);
+      RenderTextf(block, tx, ty, scale, color, "#%02X%02X%02X %4.1f%%",
+                  c[0], c[1], c[2], rs.dominantShare[k] * 100);
+      ty += padding;
+    }
+    RenderTextf(block, tx, ty, scale, white, "STD: %.1f %.1f %.1f",
+                rs.stddev[0], rs.stddev[1], rs.stddev[2]);
+    ty += padding;
+    RenderTextf(block, tx, ty, scale, white, "MEAN: %.0f %.0f %.0f",
+                rs.mean[0], rs.mean[1], rs.mean[2]);
+    ty += padding;
+    RenderTextf(block, tx, ty, scale, white, "REGION: %dx%d", rs.width,
+                rs.height);
+  }
 
-  if (FT_Init_FreeType(&ft)) {
-    MessageBoxA(NULL, "ERROR::FREETYPE: Could not init FreeType Library",
-                "Error", MB_OK | MB_ICONERROR);
-    return 1;
+  // 显示的是上一帧的计数，按显示精度做 key
+  HudKey profilerKey;
+  float gpuMs = filterGpuMs[filterMode];
+  profilerKey << showProfiler << (int)(lastFrameStats.cpuMs * 100)
+              << lastFrameStats.drawCalls << lastFrameStats.bufferUploads
+              << lastFrameStats.uniformUpdates
+              << (int)(lastFrameStats.waitMs * 100) << filterMode
+              << (int)(gpuMs * 1000) << (int)(dynresScale * 100)
+              << cameraMoving << hudTop;
+  if (!softwareRender) {
+    for (int i = 0; i < RenderGraphPassCount(); i++) {
+      const RenderPass& pass = RenderGraphPass(i);
+      profilerKey << pass.enabled << (int)(pass.gpuMs * 1000);
+    }
+    profilerKey << RenderGraphPoolSize();
   }
-  if (FT_New_Face(ft, fontPath.c_str(), 0, &face)) {
-    std::string msgerr("failed to load font:");
-    msgerr += fontPath;
-    MessageBoxA(NULL, msgerr.c_str(), "ERROR", MB_OK | MB_ICONERROR);
-    return 1;
+  if (BeginHudBlock(hudBlocks[HUD_PROFILER], profilerKey) &&
+      showProfiler) {
+    HudBlock& block = hudBlocks[HUD_PROFILER];
+    Vec3f yellow = Vec3f(1.0f, 1.0f, 0.0f);
+    float y = hudTop - 20.0f - pixel_height * scale;
+    RenderTextf(block, tx, y, scale, yellow,
+                "CPU: %.2fms DRAW: %d UPLOAD: %d UNIFORM: %d",
+                lastFrameStats.cpuMs, lastFrameStats.drawCalls,
+                lastFrameStats.bufferUploads, lastFrameStats.uniformUpdates);
+    if (softwareRender) {
+      RenderTextf(block, tx, y - padding, scale, yellow,
+                  "FILTER: %s SOFTWARE",
+                  filterModeNames[filterMode == FILTER_NEAREST
+                                      ? FILTER_NEAREST
+                                      : FILTER_BILINEAR]);
+    } else {
+      RenderTextf(block, tx, y - padding, scale, yellow,
+                  "FILTER: %s GPU: %.3fms WAIT: %.2fms",
+                  filterModeNames[filterMode], gpuMs, lastFrameStats.waitMs);
+      RenderTextf(block, tx, y - padding * 2, scale, yellow,
+                  "RES: %d%% %s BUDGET: %.1fms", (int)(dynresScale * 100),
+                  cameraMoving ? "MOTION" : "REST", DYNRES_BUDGET_MS);
+      // 上一帧打开的 pass 各自的耗时
+      float py = y - padding * 3;
+      for (int i = 0; i < RenderGraphPassCount(); i++) {
+        const RenderPass& pass = RenderGraphPass(i);
+        if (!pass.enabled) continue;
+        RenderTextf(block, tx, py, scale, yellow, "PASS %s: %.3fms",
+                    pass.name, pass.gpuMs);
+        py -= padding;
+      }
+      RenderTextf(block, tx, py, scale, yellow, "POOL: %d TARGETS",
+                  RenderGraphPoolSize());
+    }
   }
 
-  FT_Set_Pixel_Sizes(face, 0, pixel_height);
+  RenderFrame();
+  RenderEnd();
+  //? 第一帧提交以后启动过程才算结束 (GL 的上传和编译是异步的)
+  if (!firstFramePresented) {
+    firstFramePresented = true;
+    StartupTraceMark("first swap");
+    StartupTraceEnd();
+  }
 
-  shader_txt = createShader(textVertShader, textfragmentShader);
+  std::chrono::duration<float, std::milli> frameTime =
+      std::chrono::steady_clock::now() - frameStart;
+  frameStats.cpuMs = frameTime.count();
+  lastFrameStats = frameStats;
+}
 
-  glPixelStorei(GL_UNPACK_ALIGNMENT, 1);  // 禁用字节对齐限制
+void checkCompileErrors(GLuint shader, const std::string& type) {
+  GLint success;
+  char infoLog[2048] = {};
 
-  for (GLubyte c = 0; c < 128; c++) {
-    if (FT_Load_Char(face, c, FT_LOAD_RENDER)) {
-      continue;
-    }
+  if (type != "PROGRAM") {
+    glGetShaderiv(shader, GL_COMPILE_STATUS, &success);
+    if (!success) {
+      glGetShaderInfoLog(shader, sizeof(infoLog), NULL, infoLog);
 
-    GLuint txture;
-    glGenTextures(1, &txture);
-    glBindTexture(GL_TEXTURE_2D, txture);
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_RED, face->glyph->bitmap.width,
-                 face->glyph->bitmap.rows, 0, GL_RED, GL_UNSIGNED_BYTE,
-                 face->glyph->bitmap.buffer);
+      std::string msg = "Shader Compilation Error (" + type + ")\n\n";
+      msg += infoLog;
 
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+      PlatformShowError("GLSL Error", msg.c_str());
+    }
+  } else {
+    glGetProgramiv(shader, GL_LINK_STATUS, &success);
+    if (!success) {
+      glGetProgramInfoLog(shader, sizeof(infoLog), NULL, infoLog);
 
-    Character character = {
-        txture, Vec2i(face->glyph->bitmap.width, face->glyph->bitmap.rows),
-        Vec2i(face->glyph->bitmap_left, face->glyph->bitmap_top),
-        face->glyph->advance.x};
+      std::string msg = "Program Linking Error (" + type + ")\n\n";
+      msg += infoLog;
 
-    Characters.insert(std::pair<GLchar, Character>(c, character));
+      PlatformShowError("GLSL Error", msg.c_str());
+    }
   }
+}
 
-  glBindTexture(GL_TEXTURE_2D, 0);  // 解绑
-
-  FT_Done_Face(face);
-  FT_Done_FreeType(ft);
-
-  glEnable(GL_BLEND);
+GLuint createShader(std::string& vert, std::string& frag) {
+  GLuint vertex, fragment;
+  // vertex shader
+  vertex = glCreateShader(GL_VERTEX_SHADER);
+  const char* vertSrc = vert.c_str();
+  glShaderSource(vertex, 1, &vertSrc, NULL);
+  glCompileShader(vertex);
+
+  checkCompileErrors(vertex, "VERTEX");
+  // fragment Shader
+  const char* fragSrc = frag.c_str();
+  fragment = glCreateShader(GL_FRAGMENT_SHADER);
+  glShaderSource(fragment, 1, &fragSrc, NULL);
+  glCompileShader(fragment);
+  checkCompileErrors(fragment, "FRAGMENT");
+  // shader Program
+  GLuint ID = glCreateProgram();
+  glAttachShader(ID, vertex);
+  glAttachShader(ID, fragment);
+  glLinkProgram(ID);
+  checkCompileErrors(ID, "PROGRAM");
+
+  // delete the shaders as they're linked into our program now and no longer
+  // necessary
+  glDeleteShader(vertex);
+  glDeleteShader(fragment);
+  return ID;
+}
+
+//? 有 3.3 以上的上下文返回 true，失败时把建了一半的清理掉
+bool InitContext() {
+  if (!PlatformCreateContext()) return false;
+  if (LoadGL(PlatformGetProcAddress, 3, 3)) {
+    StartupTraceMark("loader");
+    return true;
+  }
+  PlatformDestroyContext();
+  return false;
+}
+
+//? 截图纹理、字形图集和各自的顶点缓冲；截图和图集已经在内存里
+void InitGLResources() {
+  shader_img = createShader(vertexShader, fragmentShader);
+  StartupTraceMark("screen shader");
+
+  glGenTextures(1, &screen_texture);
+  glGenBuffers(1, &screenVBO);
+  glGenVertexArrays(1, &screenVAO);
+  glGenBuffers(1, &screenEBO);
+
+  // clang-format off
+  float vertices[] = {
+      0,                    0,  0,  0,  0,     // top left
+      (float)virtualWidth,  0,  0,  1,  0,     // top right
+      0, (float)virtualHeight,  0,  0,  1,     // bottom left
+      (float)virtualWidth,  (float)virtualHeight, 0,  1,  1 // bottom right
+  };
+  unsigned int indices[] = {
+    0,1,2,
+    1,2,3
+  };
+  // clang-format on
+
+  glBindVertexArray(screenVAO);
+  glBindBuffer(GL_ARRAY_BUFFER, screenVBO);
+  glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
+
+  glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, screenEBO);
+  glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(indices), indices,
+               GL_STATIC_DRAW);
+
+  glVertexAttribPointer(0, 3, GL_FLOAT, false, 5 * sizeof(float), (void*)0);
+  glEnableVertexAttribArray(0);
+
+  glVertexAttribPointer(1, 2, GL_FLOAT, false, 5 * sizeof(float),
+                        (void*)(3 * sizeof(float)));
+  glEnableVertexAttribArray(1);
+
+  // 第 0 级上传的同时，后台线程生成其余各级
+  StartMipBuilder(screenPixels, virtualWidth, virtualHeight);
+
+  glBindTexture(GL_TEXTURE_2D, screen_texture);
+
+  glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, virtualWidth, virtualHeight, 0,
+               GL_BGRA, GL_UNSIGNED_BYTE, screenPixels);
+  StartupTraceMark("upload");
+
+  screenMinFilter = GL_NEAREST;
+  screenMagFilter = GL_NEAREST;
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, screenMinFilter);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, screenMagFilter);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_BORDER);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_BORDER);
+
+  glBindTexture(GL_TEXTURE_2D, 0);  // 解绑
+  glBindVertexArray(0);             // 解绑
+
+  // these may not be modified
+  float ratio[2] = {(float)virtualWidth, (float)virtualHeight};
+  InitScreenProgram(shader_img, screenUniforms);
+  float gridScale[2] = {GRID_MIN_SCALE, LABEL_MIN_SCALE};
+  glUniform2fv(glGetUniformLocation(shader_img, "gridScale"), 1, gridScale);
+  glUniform1i(glGetUniformLocation(shader_img, "glyphAtlas"), 1);
+  float glyphLayout[4] = {SDF_CELL, SDF_SPREAD, 8 * FONT_TEXEL_SCALE,
+                          ATLAS_COLUMNS};
+  glUniform4fv(glGetUniformLocation(shader_img, "glyphLayout"), 1,
+               glyphLayout);
+
+  shader_flashlight = createShader(vertexShader, flashlightFragShader);
+  InitScreenProgram(shader_flashlight, flashlightUniforms);
+  shader_selection = createShader(vertexShader, selectionFragShader);
+  InitScreenProgram(shader_selection, selectionUniforms);
+
+  shader_edges = createShader(fullscreenVertShader, edgeFragShader);
+  glUseProgram(shader_edges);
+  glUniform1i(glGetUniformLocation(shader_edges, "uInput"), 0);
+  InitUniform(edgeInputSize, shader_edges, "inputSize");
+
+  shader_color = createShader(fullscreenVertShader, colorFragShader);
+  glUseProgram(shader_color);
+  glUniform1i(glGetUniformLocation(shader_color, "uInput"), 0);
+  glUniform1i(glGetUniformLocation(shader_color, "lut"), 2);
+  glUniform1f(glGetUniformLocation(shader_color, "lutSize"), LUT_SIZE);
+
+  //? 两张一样大的表轮流用，生成好的传到没在用的那张
+  glGenTextures(2, lutTextures);
+  for (GLuint texture : lutTextures) {
+    glBindTexture(GL_TEXTURE_3D, texture);
+    glTexImage3D(GL_TEXTURE_3D, 0, GL_RGBA8, LUT_SIZE, LUT_SIZE, LUT_SIZE, 0,
+                 GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+    glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
+  }
+  glBindTexture(GL_TEXTURE_3D, 0);
+  lutData.resize(LUT_SIZE * LUT_SIZE * LUT_SIZE * 4);
+  lutNext.resize(lutData.size());
+
+  shader_loupe = createShader(fullscreenVertShader, loupeFragShader);
+  glUseProgram(shader_loupe);
+  glUniform2fv(glGetUniformLocation(shader_loupe, "screenshotSize"), 1, ratio);
+  glUniform1i(glGetUniformLocation(shader_loupe, "uTexture"), 0);
+  glUniform1f(glGetUniformLocation(shader_loupe, "loupeZoom"), LOUPE_ZOOM);
+  glUniform1f(glGetUniformLocation(shader_loupe, "loupeBorder"), LOUPE_BORDER);
+  glUniform1i(glGetUniformLocation(shader_loupe, "loupeCells"), LOUPE_CELLS);
+  InitUniform(loupeUniforms.viewport, shader_loupe, "viewport");
+  InitUniform(loupeUniforms.rect, shader_loupe, "loupeRect");
+  InitUniform(loupeUniforms.center, shader_loupe, "loupeCenter");
+
+  shader_txt = createShader(textVertShader, textfragmentShader);
+  StartupTraceMark("text shader");
+  //? 投影在 FlushText 里按输出设置，采样器固定用 0 号纹理单元
+  glUseProgram(shader_txt);
+  glUniform1i(glGetUniformLocation(shader_txt, "text"), 0);
+  textProjection = glGetUniformLocation(shader_txt, "projection");
+
+  glPixelStorei(GL_UNPACK_ALIGNMENT, 1);  // 禁用字节对齐限制
+
+  glGenTextures(1, &glyphAtlas);
+  glBindTexture(GL_TEXTURE_2D, glyphAtlas);
+  glTexImage2D(GL_TEXTURE_2D, 0, GL_RED, atlasWidth, atlasHeight, 0, GL_RED,
+               GL_UNSIGNED_BYTE, atlasPixels.data());
+
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+  glBindTexture(GL_TEXTURE_2D, 0);  // 解绑
+
+  //? 截图 shader 的像素值标签从 1 号纹理单元读图集，别处不用这个单元，
+  //? 绑一次就一直有效 (缓存格子的更新写的是同一个纹理对象)
+  glActiveTexture(GL_TEXTURE1);
+  glBindTexture(GL_TEXTURE_2D, glyphAtlas);
+  glActiveTexture(GL_TEXTURE0);
+
+  glEnable(GL_BLEND);
   glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
 
   glGenVertexArrays(1, &textVAO);
@@ -500,380 +1539,497 @@ int WINAPI wWinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance,
 
   glBindVertexArray(textVAO);
   glBindBuffer(GL_ARRAY_BUFFER, textVBO);
-  glBufferData(GL_ARRAY_BUFFER, sizeof(GLfloat) * 6 * 4, NULL, GL_DYNAMIC_DRAW);
+  InitTextRing();
 
-  glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, 4 * sizeof(GLfloat), 0);
+  glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE,
+                        TEXT_VERTEX_FLOATS * sizeof(GLfloat), 0);
   glEnableVertexAttribArray(0);
+  glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE,
+                        TEXT_VERTEX_FLOATS * sizeof(GLfloat),
+                        (void*)(4 * sizeof(GLfloat)));
+  glEnableVertexAttribArray(1);
 
   glBindVertexArray(0);  // 解绑
 
-#endif
-  //& >>>>>>>>>>>>>>>>>>>>>>>>>>>>>> init opengl
+  InitRenderGraph();
+}
 
-  MSG msg = {};
-  while (true) {
-    while (PeekMessage(&msg, NULL, 0, 0, PM_REMOVE)) {
-      if (msg.message == WM_QUIT) {
-        KillTimer(overlay, REFRESH_TIMER_ID);
-        wglMakeCurrent(NULL, NULL);
-        wglDeleteContext(g_glrc);
-        ReleaseDC(overlay, g_hdc);
+//? 截图四边形上的 program: 固定不变的 uniform 设一次，其余的查好位置
+void InitScreenProgram(GLuint program, ScreenUniforms& u) {
+  float ratio[2] = {(float)virtualWidth, (float)virtualHeight};
+  glUseProgram(program);
+  glUniform2fv(glGetUniformLocation(program, "uResolution"), 1, ratio);
+  glUniform2fv(glGetUniformLocation(program, "windowSize"), 1, ratio);
+  glUniform2fv(glGetUniformLocation(program, "screenshotSize"), 1, ratio);
+  glUniform1i(glGetUniformLocation(program, "uTexture"), 0);
+
+  InitUniform(u.cameraScale, program, "cameraScale");
+  InitUniform(u.sampleScale, program, "sampleScale");
+  InitUniform(u.flShadow, program, "flShadow");
+  InitUniform(u.flRadius, program, "flRadius");
+  InitUniform(u.cameraPos, program, "cameraPos");
+  InitUniform(u.mousePos, program, "mousePos");
+  InitUniform(u.selection, program, "selection");
+  InitUniform(u.filterMode, program, "filterMode");
+  InitUniform(u.viewport, program, "viewport");
+}
 
-        glDeleteBuffers(1, &screenVBO);
-        glDeleteBuffers(1, &screenEBO);
-        glDeleteVertexArrays(1, &screenVAO);
+//? 按 PassId 的顺序加 pass，各帧只改开关和尺寸
+void InitRenderGraph() {
+  RenderGraphAddPass("SCREEN", RenderScreenPass);
+  RenderGraphAddPass("COLOR", RenderColorPass);
+  RenderGraphAddPass("EDGES", RenderEdgePass);
+  RenderGraphAddPass("UPSCALE", RenderUpscalePass);
+  RenderGraphAddPass("FLASHLIGHT", RenderFlashlightPass);
+  RenderGraphAddPass("SELECTION", RenderSelectionPass);
+  RenderGraphAddPass("LOUPE", [](const RenderTarget*, const RenderTarget&) {
+    RenderLoupe();
+  });
+  RenderGraphAddPass("HUD", [](const RenderTarget*, const RenderTarget&) {
+    FlushText();
+  });
+
+  RenderGraphPass(PASS_COLOR).readsInput = true;
+  RenderGraphPass(PASS_EDGES).readsInput = true;
+  RenderGraphPass(PASS_UPSCALE).readsInput = true;
+  RenderGraphPass(PASS_SCREEN).onTimed = [](float ms, int tag, float area) {
+    float sample = ms / area;
+    float& filterMs = filterGpuMs[tag];
+    filterMs = filterMs == 0.0f ? sample : filterMs * 0.9f + sample * 0.1f;
+  };
+}
 
-#ifdef FREETYPE
-        glDeleteBuffers(1, &textVBO);
-        glDeleteVertexArrays(1, &textVAO);
-#endif
+void InitUniform(CachedUniform& u, GLuint program, const char* name) {
+  u.location = glGetUniformLocation(program, name);
+  u.size = 0;
+}
 
-        return 0;
-      }
-      if (msg.message == WM_HOTKEY && msg.wParam == 1) {
-        PostQuitMessage(0);
-        continue;
-      }
-      TranslateMessage(&msg);
-      DispatchMessage(&msg);
-    }
+//? 和上次的值比较，变了才记下来并返回 true
+bool UniformChanged(CachedUniform& u, const GLfloat* value, int size) {
+  if (u.size == size && memcmp(u.value, value, size * sizeof(GLfloat)) == 0) {
+    return false;
   }
+  memcpy(u.value, value, size * sizeof(GLfloat));
+  u.size = size;
+  frameStats.uniformUpdates++;
+  return true;
+}
 
-  return 0;
+void SetUniform(CachedUniform& u, GLfloat v) {
+  if (UniformChanged(u, &v, 1)) glUniform1f(u.location, v);
 }
 
-LRESULT CALLBACK WindowProc(HWND hwnd, UINT uMsg, WPARAM wParam,
-                            LPARAM lParam) {
-  switch (uMsg) {
-    case WM_CREATE: {
-      return 0;
-    }
-    case WM_DESTROY: {
-      PostQuitMessage(0);
-      return 0;
-    }
-    case WM_KEYUP: {
-      switch (wParam) {
-        case 'F':
-          flashLight.isEnabled = !flashLight.isEnabled;
-          break;
-        case 'R':
-          camera.scale = 1.0f;
-          camera.deltaScale = 0.0f;
-          camera.position = Vec2f(0.0f, 0.0f);
-          camera.velocity = Vec2f(0.0f, 0.0f);
-
-          flashLight.radius = 100.0f;
-          flashLight.deltaRadius = 0.0f;
-          flashLight.isEnabled = false;
-          SetFocus(overlay);
-          break;
-        case VK_ESCAPE:
-          PostQuitMessage(0);
-          return 0;
-        default:
-          break;
-      }
-      return 0;
-    }
-    case WM_LBUTTONDOWN: {
-      isDragging = true;
-      return 0;
-    }
-    case WM_LBUTTONUP: {
-      isDragging = false;
-      return 0;
-    }
-    case WM_MOUSEWHEEL: {
-      auto wheelSpeed = GET_WHEEL_DELTA_WPARAM(wParam);
-      auto fwKeys = GET_KEYSTATE_WPARAM(wParam);
-      float delta = wheelSpeed * wheelScale;
-      if (flashLight.isEnabled && fwKeys & MK_SHIFT) {
-        flashLight.deltaRadius +=
-            ((wheelSpeed > 0) ? 1 : -1) * INITIAL_FL_DELTA_RADIUS;
-        return 0;
-      }
-      if (flashLight.isEnabled && fwKeys & MK_CONTROL) {
-        flashLight.deltaRadius +=
-            ((wheelSpeed > 0) ? 1 : -1) * INITIAL_FL_DELTA_RADIUS;
-      }
-      camera.deltaScale += delta;
-      camera.scalePivot = Vec2f((float)mouse_pos.x, (float)mouse_pos.y);
-      return 0;
-    }
-    case WM_PAINT: {
-      PAINTSTRUCT ps;
-      //! 这里必须要手动绘制一下，不然peekmessage不会处理wm_paint事件
-      BeginPaint(hwnd, &ps);
-      EndPaint(hwnd, &ps);
-      return 0;
-    }
-    case WM_TIMER: {
-      GetCursorPos(&mouse_pos);
-      ScreenToClient(overlay, &mouse_pos);
-
-      // 计算从屏幕坐标到原始截图坐标的变换
-      // 考虑相机的缩放和平移
-      // float screenCenterX = virtualWidth * 0.5f;
-      // float screenCenterY = virtualHeight * 0.5f;
-      //
-      // float screenRelX = (mouse_pos.x - screenCenterX) / camera.scale;
-      // float screenRelY = (mouse_pos.y - screenCenterY) / camera.scale;
-      //
-      // int originalX = (int)(screenRelX + camera.position.x + screenCenterX);
-      // int originalY = (int)(screenRelY + camera.position.y + screenCenterY);
-      //
-      // // 确保坐标在有效范围内
-      // originalX = (originalX < 0)               ? 0
-      //             : (originalX >= virtualWidth) ? virtualWidth - 1
-      //                                           : originalX;
-      // originalY = (originalY < 0)                ? 0
-      //             : (originalY >= virtualHeight) ? virtualHeight - 1
-      //                                            : originalY;
-      // color =
-      //     GetPixel(g_hdc, originalX, originalY);  // 单屏幕时正确，双屏有问题
-      // color = GetPixel(g_hdc, mouse_pos.x,
-      //                  mouse_pos.y);  // 双屏幕正确，单屏幕有问题
-
-      if (last_pos.x != mouse_pos.x || last_pos.y != mouse_pos.y) {
-        if (isDragging) {
-          //? 放大后偏移移动量减小
-          float dx = (last_pos.x - mouse_pos.x) / camera.scale;
-          float dy = (last_pos.y - mouse_pos.y) / camera.scale;
-
-          camera.position += Vec2f(dx, dy);
-          camera.velocity = Vec2f(dx * rate, dy * rate);
-        }
-        last_pos.x = mouse_pos.x;
-        last_pos.y = mouse_pos.y;
-      }
+void SetUniform(CachedUniform& u, GLint v) {
+  GLfloat f = (GLfloat)v;  // 只用来比较，小整数转 float 没有损失
+  if (UniformChanged(u, &f, 1)) glUniform1i(u.location, v);
+}
 
-      camera.update(Vec2f(virtualWidth, virtualHeight), dt, isDragging);
-      flashLight.update(dt);
+void SetUniform2(CachedUniform& u, const GLfloat* v) {
+  if (UniformChanged(u, v, 2)) glUniform2fv(u.location, 1, v);
+}
 
-      RenderBegin();
-      RenderScreen_raw();
+void SetUniform2(CachedUniform& u, const GLint* v) {
+  GLfloat f[2] = {(GLfloat)v[0], (GLfloat)v[1]};
+  if (UniformChanged(u, f, 2)) glUniform2i(u.location, v[0], v[1]);
+}
 
-#ifdef FREETYPE
-      if (flashLight.isEnabled) {
-        // auto r = GetRValue(color);
-        // auto g = GetGValue(color);
-        // auto b = GetBValue(color);
-        int r = pixel[0];
-        int g = pixel[1];
-        int b = pixel[2];
-
-        float h, s, v;
-        RGBtoHSV(r, g, b, h, s, v);
-        int sz;
-        sz = std::snprintf(nullptr, 0, "RGB: %d %d %d", r, g, b);
-        std::string textbuf(sz + 1, '\0');
-        std::sprintf(textbuf.data(), "RGB: %d %d %d", r, g, b);
-        float tx = 25.0f;
-        float ty = 20.0f;
-        float scale = 1.0f;
-        float padding = pixel_height * scale * 2;
-
-        Vec3f color = Vec3f(r / 255.0f, g / 255.0f, b / 255.0f);
-
-        RenderText(textbuf, tx, ty, scale, color);
-
-        sz = std::snprintf(nullptr, 0, "HEX: #%02X%02X%02X", r, g, b);
-        textbuf.resize(sz + 1);
-        std::sprintf(textbuf.data(), "HEX: #%02X%02X%02X", r, g, b);
-
-        ty += padding;
-        RenderText(textbuf, tx, ty, scale, color);
-
-        sz = std::snprintf(nullptr, 0, "HSV: (%.0f°, %.0f%%, %.0f%%)", h,
-                           s * 100, v * 100);
-        textbuf.resize(sz + 1);
-        std::sprintf(textbuf.data(), "HSV: (%.0f°, %.0f%%, %.0f%%)", h, s * 100,
-                     v * 100);
-        ty += padding;
-        RenderText(textbuf, tx, ty, scale, color);
-      }
-#endif
-      RenderEnd();
+void SetUniform4(CachedUniform& u, const GLfloat* v) {
+  if (UniformChanged(u, v, 4)) glUniform4fv(u.location, 1, v);
+}
 
-      int glX = mouse_pos.x;
-      int glY = virtualHeight - 1 - mouse_pos.y;
-      glReadBuffer(GL_FRONT);
-      glReadPixels(glX, glY, 1, 1, GL_RGBA, GL_UNSIGNED_BYTE, pixel);
+//? 软件渲染按固定的顺序画；GL 按这一帧的状态开关各个 pass，交给渲染图
+void RenderFrame() {
+  if (softwareRender) {
+    RenderScreen_soft();
+    RenderLoupe();
+    FlushText();
+    return;
+  }
 
-      return 0;
-    }
-    case WM_ERASEBKGND: {
-      return 1;
-    }
+  //? 降分辨率时截图画进池里的纹理，由拉伸 pass 放大到输出
+  const AppOutput& output = outputs[currentOutput];
+  RenderPass& screen = RenderGraphPass(PASS_SCREEN);
+  screen.width = (int)ceilf(output.width * dynresScale);
+  screen.height = (int)ceilf(output.height * dynresScale);
+  screen.tag = filterMode;
+  RenderGraphPass(PASS_COLOR).enabled = lutTransform != TRANSFORM_NONE;
+  RenderGraphPass(PASS_EDGES).enabled = showEdges;
+  RenderGraphPass(PASS_UPSCALE).enabled = dynresScale < 1.0f;
+  RenderGraphPass(PASS_FLASHLIGHT).enabled = flashLight.shadow > 0.0f;
+  const float* sel = selectionRect;
+  bool hasSelection = sel[2] > sel[0] || sel[3] > sel[1];
+  RenderGraphPass(PASS_SELECTION).enabled = hasSelection;
+  RenderGraphPass(PASS_LOUPE).enabled = showLoupe;
+  bool hasText = false;
+  for (const HudBlock& block : hudBlocks) {
+    hasText = hasText || !block.vertices.empty();
   }
-  return DefWindowProc(hwnd, uMsg, wParam, lParam);
+  RenderGraphPass(PASS_HUD).enabled = hasText;
+
+  RenderGraphExecute(PlatformFramebuffer(), output.width, output.height);
 }
 
-void RGBtoHSV(int r, int g, int b, float& h, float& s, float& v) {
-  float rd = r / 255.0;
-  float gd = g / 255.0;
-  float bd = b / 255.0;
+//? 截图四边形的相机和输出，三个 program 的 vertexShader 一样
+void SetScreenQuadUniforms(ScreenUniforms& u) {
+  float cameraPos[2] = {camera.position.x, camera.position.y};
+  float viewport[4];
+  OutputRect(outputs[currentOutput], viewport);
+  SetUniform(u.cameraScale, camera.scale);
+  SetUniform(u.sampleScale, ScreenSampleScale());
+  SetUniform2(u.cameraPos, cameraPos);
+  SetUniform4(u.viewport, viewport);
+}
 
-  float maxv = fmax(rd, fmax(gd, bd));
-  float minv = fmin(rd, fmin(gd, bd));
-  float delta = maxv - minv;
+void RenderScreenPass(const RenderTarget*, const RenderTarget&) {
+  glUseProgram(shader_img);
 
-  if (delta < 1e-6)
-    h = 0;
-  else if (maxv == rd)
-    h = fmod(((gd - bd) / delta), 6.0);
-  else if (maxv == gd)
-    h = ((bd - rd) / delta) + 2.0;
-  else
-    h = ((rd - gd) / delta) + 4.0;
+  glActiveTexture(GL_TEXTURE0);
+  glBindVertexArray(screenVAO);
+  glBindTexture(GL_TEXTURE_2D, screen_texture);
+  UpdateScreenSampler();
 
-  h *= 60;
-  if (h < 0) h += 360;
+  SetScreenQuadUniforms(screenUniforms);
+  SetUniform(screenUniforms.filterMode, (GLint)filterMode);
+
+  glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT,
+                 (void*)(0 * sizeof(unsigned int)));
+  frameStats.drawCalls++;
 
-  s = (maxv == 0) ? 0 : (delta / maxv);
-  v = maxv;
+  glBindVertexArray(0);             // 解绑
+  glBindTexture(GL_TEXTURE_2D, 0);  // 解绑
 }
 
-HBITMAP CaptureScreenToBitmap(int width, int height) {
-  HDC hScreen = GetDC(NULL);
-  HDC hMemDC = CreateCompatibleDC(hScreen);
+void RenderColorPass(const RenderTarget* input, const RenderTarget&) {
+  if (!input) return;
+  glUseProgram(shader_color);
+  glActiveTexture(GL_TEXTURE2);
+  glBindTexture(GL_TEXTURE_3D, lutTextures[lutTextureIndex]);
+  glActiveTexture(GL_TEXTURE0);
+  glBindVertexArray(screenVAO);  // 顶点由 gl_VertexID 算，只是要绑一个 VAO
+  glBindTexture(GL_TEXTURE_2D, input->texture);
 
-  HBITMAP hBitmap = CreateCompatibleBitmap(hScreen, width, height);
-  SelectObject(hMemDC, hBitmap);
+  glDrawArrays(GL_TRIANGLES, 0, 3);
+  frameStats.drawCalls++;
 
-  //? 复制屏幕到 hBitmap
-  BitBlt(hMemDC, 0, 0, width, height, hScreen, 0, 0, SRCCOPY);
+  glBindVertexArray(0);             // 解绑
+  glBindTexture(GL_TEXTURE_2D, 0);  // 解绑
+}
+
+void RenderEdgePass(const RenderTarget* input, const RenderTarget&) {
+  if (!input) return;
+  glUseProgram(shader_edges);
+  GLint inputSize[2] = {input->width, input->height};
+  SetUniform2(edgeInputSize, inputSize);
+  glActiveTexture(GL_TEXTURE0);
+  glBindVertexArray(screenVAO);  // 顶点由 gl_VertexID 算，只是要绑一个 VAO
+  glBindTexture(GL_TEXTURE_2D, input->texture);
 
-  DeleteDC(hMemDC);
-  ReleaseDC(NULL, hScreen);
+  glDrawArrays(GL_TRIANGLES, 0, 3);
+  frameStats.drawCalls++;
 
-  return hBitmap;
+  glBindVertexArray(0);             // 解绑
+  glBindTexture(GL_TEXTURE_2D, 0);  // 解绑
 }
 
-unsigned char* BitmapToMem(HBITMAP hbm, int width, int height) {
-  BITMAP bm;
-  GetObject(hbm, sizeof(BITMAP), &bm);
-  BITMAPINFOHEADER bi = {};
-  bi.biSize = sizeof(BITMAPINFOHEADER);
-  bi.biWidth = bm.bmWidth;
-  bi.biHeight = bm.bmHeight;
-  bi.biPlanes = 1;
-  bi.biBitCount = 32;
-  bi.biCompression = BI_RGB;
-  assert(width == bm.bmWidth && height == bm.bmHeight);
-  size_t size = bm.bmWidth * bm.bmHeight * 4;
-  unsigned char* data = new unsigned char[size];
+void RenderUpscalePass(const RenderTarget* input, const RenderTarget& target) {
+  if (!input) return;
+  glBindFramebuffer(GL_READ_FRAMEBUFFER, input->framebuffer);
+  glBlitFramebuffer(0, 0, input->width, input->height, 0, 0, target.width,
+                    target.height, GL_COLOR_BUFFER_BIT, GL_LINEAR);
+}
+
+void RenderFlashlightPass(const RenderTarget*, const RenderTarget&) {
+  glUseProgram(shader_flashlight);
+  glBindVertexArray(screenVAO);
 
-  HDC hdc = GetDC(NULL);
-  GetDIBits(hdc, hbm, 0, height, data, (BITMAPINFO*)&bi, DIB_RGB_COLORS);
-  ReleaseDC(NULL, hdc);
-  return data;
+  float mousePos[2] = {(float)mouse_pos.x, (float)mouse_pos.y};
+  ScreenUniforms& u = flashlightUniforms;
+  SetScreenQuadUniforms(u);
+  SetUniform(u.flShadow, flashLight.shadow);
+  SetUniform(u.flRadius, flashLight.radius);
+  SetUniform2(u.mousePos, mousePos);
+
+  glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, (void*)0);
+  frameStats.drawCalls++;
+  glBindVertexArray(0);  // 解绑
 }
 
-void checkCompileErrors(GLuint shader, const std::string& type) {
-  GLint success;
-  char infoLog[2048];
-  ZeroMemory(infoLog, sizeof(infoLog));
+void RenderSelectionPass(const RenderTarget*, const RenderTarget&) {
+  glUseProgram(shader_selection);
+  glBindVertexArray(screenVAO);
 
-  if (type != "PROGRAM") {
-    glGetShaderiv(shader, GL_COMPILE_STATUS, &success);
-    if (!success) {
-      glGetShaderInfoLog(shader, sizeof(infoLog), NULL, infoLog);
+  SetScreenQuadUniforms(selectionUniforms);
+  SetUniform4(selectionUniforms.selection, selectionRect);
 
-      std::string msg = "Shader Compilation Error (" + type + ")\n\n";
-      msg += infoLog;
+  glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, (void*)0);
+  frameStats.drawCalls++;
+  glBindVertexArray(0);  // 解绑
+}
 
-      MessageBoxA(NULL, msg.c_str(), "GLSL Error", MB_OK | MB_ICONERROR);
-    }
-  } else {
-    glGetProgramiv(shader, GL_LINK_STATUS, &success);
-    if (!success) {
-      glGetProgramInfoLog(shader, sizeof(infoLog), NULL, infoLog);
+//? 和渲染图画出来的一样，除 NEAREST 以外的过滤都按双线性画
+void RenderScreen_soft() {
+  SoftScreenParams params;
+  params.image = screenPixels;
+  params.width = virtualWidth;
+  params.height = virtualHeight;
+  params.cameraX = camera.position.x;
+  params.cameraY = camera.position.y;
+  params.cameraScale = camera.scale;
+  params.bilinear = filterMode != FILTER_NEAREST;
+  params.cursorX = (float)mouse_pos.x;
+  params.cursorY = (float)(virtualHeight - mouse_pos.y);
+  params.flRadius = flashLight.radius;
+  params.flShadow = flashLight.shadow;
+  params.selection = selectionRect;
+  float rect[4];
+  OutputRect(outputs[currentOutput], rect);
+  params.clip[0] = (int)rect[0];
+  params.clip[1] = (int)rect[1];
+  params.clip[2] = (int)(rect[0] + rect[2]);
+  params.clip[3] = (int)(rect[1] + rect[3]);
+  SoftRenderScreen(params, softPixels, softPitch);
+}
 
-      std::string msg = "Program Linking Error (" + type + ")\n\n";
-      msg += infoLog;
+//? 停着就是 1；在动时超预算马上降下去，回升每帧最多一档，
+//? 不会因为一两次计时偏低就在两档之间来回跳
+float ChooseRenderScale() {
+  if (!cameraMoving) return 1.0f;
+  float fullMs = filterGpuMs[filterMode];
+  float scale = 1.0f;
+  if (fullMs > DYNRES_BUDGET_MS) {
+    scale = sqrtf(DYNRES_BUDGET_MS / fullMs);
+    scale = floorf(scale * DYNRES_STEPS) / DYNRES_STEPS;
+    scale = fmax(scale, DYNRES_MIN_SCALE);
+  }
+  return fmin(scale, dynresScale + 1.0f / DYNRES_STEPS);
+}
 
-      MessageBoxA(NULL, msg.c_str(), "GLSL Error", MB_OK | MB_ICONERROR);
+//? 截图一个像素在画的目标上占几个像素: 降了分辨率时比 camera.scale 小，
+//? 放大一倍多一点的画面也可能其实是在缩小采样
+float ScreenSampleScale() { return camera.scale * dynresScale; }
+
+//? 放大镜在桌面上的 x0 y0 x1 y1 (y 向上)，默认在光标右下，
+//? 放不下就翻到光标另一边，不跨出光标所在的输出
+void LoupeRect(int rect[4]) {
+  const AppOutput* output = &outputs[0];
+  for (const AppOutput& o : outputs) {
+    if (mouse_pos.x >= o.x && mouse_pos.x < o.x + o.width &&
+        mouse_pos.y >= o.y && mouse_pos.y < o.y + o.height) {
+      output = &o;
+      break;
     }
   }
+  int x = mouse_pos.x + LOUPE_OFFSET;
+  int y = mouse_pos.y + LOUPE_OFFSET;  // 先按 y 向下算
+  if (x + LOUPE_SIZE > output->x + output->width) {
+    x = mouse_pos.x - LOUPE_OFFSET - LOUPE_SIZE;
+  }
+  if (y + LOUPE_SIZE > output->y + output->height) {
+    y = mouse_pos.y - LOUPE_OFFSET - LOUPE_SIZE;
+  }
+  rect[0] = x;
+  rect[1] = virtualHeight - y - LOUPE_SIZE;
+  rect[2] = x + LOUPE_SIZE;
+  rect[3] = virtualHeight - y;
 }
 
-GLuint createShader(std::string& vert, std::string& frag) {
-  GLuint vertex, fragment;
-  // vertex shader
-  vertex = glCreateShader(GL_VERTEX_SHADER);
-  const char* vertSrc = vert.c_str();
-  glShaderSource(vertex, 1, &vertSrc, NULL);
-  glCompileShader(vertex);
+//? 正中那格就是 PickPixel 取的像素；只画和当前输出重叠的部分
+void RenderLoupe() {
+  if (!showLoupe) return;
+  int rect[4];
+  LoupeRect(rect);
+  Vec2f p = WindowToImage(mouse_pos.x + 0.5f, mouse_pos.y + 0.5f);
+  int centerX = (int)floorf(p.x), centerY = (int)floorf(p.y);
+
+  float viewport[4];
+  OutputRect(outputs[currentOutput], viewport);
+  int clip[4] = {std::max(rect[0], (int)viewport[0]),
+                 std::max(rect[1], (int)viewport[1]),
+                 std::min(rect[2], (int)(viewport[0] + viewport[2])),
+                 std::min(rect[3], (int)(viewport[1] + viewport[3]))};
+  if (clip[0] >= clip[2] || clip[1] >= clip[3]) return;
+
+  if (softwareRender) {
+    SoftLoupeParams params;
+    params.image = screenPixels;
+    params.width = virtualWidth;
+    params.height = virtualHeight;
+    memcpy(params.rect, rect, sizeof(params.rect));
+    params.centerX = centerX;
+    params.centerY = centerY;
+    params.cells = LOUPE_CELLS;
+    params.zoom = LOUPE_ZOOM;
+    params.border = LOUPE_BORDER;
+    SoftRenderLoupe(params, softPixels, softPitch, clip);
+    return;
+  }
 
-  checkCompileErrors(vertex, "VERTEX");
-  // fragment Shader
-  const char* fragSrc = frag.c_str();
-  fragment = glCreateShader(GL_FRAGMENT_SHADER);
-  glShaderSource(fragment, 1, &fragSrc, NULL);
-  glCompileShader(fragment);
-  checkCompileErrors(fragment, "FRAGMENT");
-  // shader Program
-  GLuint ID = glCreateProgram();
-  glAttachShader(ID, vertex);
-  glAttachShader(ID, fragment);
-  glLinkProgram(ID);
-  checkCompileErrors(ID, "PROGRAM");
+  glEnable(GL_SCISSOR_TEST);
+  glScissor(clip[0] - (int)viewport[0], clip[1] - (int)viewport[1],
+            clip[2] - clip[0], clip[3] - clip[1]);
+  glUseProgram(shader_loupe);
+  glBindVertexArray(screenVAO);  // 顶点由 gl_VertexID 算，只是要绑一个 VAO
+  glActiveTexture(GL_TEXTURE0);
+  glBindTexture(GL_TEXTURE_2D, screen_texture);
 
-  // delete the shaders as they're linked into our program now and no longer
-  // necessary
-  glDeleteShader(vertex);
-  glDeleteShader(fragment);
-  return ID;
-}
+  float loupeRect[4] = {(float)rect[0], (float)rect[1], (float)rect[2],
+                        (float)rect[3]};
+  float center[2] = {(float)centerX, (float)centerY};
+  SetUniform4(loupeUniforms.viewport, viewport);
+  SetUniform4(loupeUniforms.rect, loupeRect);
+  SetUniform2(loupeUniforms.center, center);
 
-void RenderScreen_raw() {
-  // draw screen
-  glUseProgram(shader_img);
+  glDrawArrays(GL_TRIANGLES, 0, 3);
+  frameStats.drawCalls++;
+  glDisable(GL_SCISSOR_TEST);
 
-  glActiveTexture(GL_TEXTURE0);
-  glBindVertexArray(screenVAO);
-  glBindTexture(GL_TEXTURE_2D, screen_texture);
+  glBindVertexArray(0);             // 解绑
+  glBindTexture(GL_TEXTURE_2D, 0);  // 解绑
+}
 
-  float cameraPos[2] = {camera.position.x, camera.position.y};
-  float mousePos[2] = {(float)mouse_pos.x, (float)mouse_pos.y};
+//? 输出在桌面上的 x y w h，换成 OpenGL 的 y 向上 (和 viewport uniform 一样)
+void OutputRect(const AppOutput& output, float rect[4]) {
+  rect[0] = (float)output.x;
+  rect[1] = (float)(virtualHeight - output.y - output.height);
+  rect[2] = (float)output.width;
+  rect[3] = (float)output.height;
+}
 
-  glUniform1f(glGetUniformLocation(shader_img, "cameraScale"), camera.scale);
-  glUniform1f(glGetUniformLocation(shader_img, "flShadow"), flashLight.shadow);
-  glUniform1f(glGetUniformLocation(shader_img, "flRadius"), flashLight.radius);
+//? 和 vertexShader 相反的变换: 窗口坐标 -> 截图坐标 (未取整)
+//? x: ndc = ((aPos.x - cameraPos.x) / W * 2 - 1) * scale
+//? y: 窗口 Y 轴向下，先翻成 OpenGL 的向上，aPos.y 就是 screenPixels 的行号
+//? 不经过 GPU，取到的是截图原值，不受手电筒阴影和缩放的影响
+//? 区域采样见 picker.cpp，中心就是光标下的源像素
+Vec2f WindowToImage(float x, float y) {
+  float halfW = virtualWidth * 0.5f;
+  float halfH = virtualHeight * 0.5f;
+
+  return Vec2f((x - halfW) / camera.scale + halfW + camera.position.x,
+               ((virtualHeight - y) - halfH) / camera.scale + halfH -
+                   camera.position.y);
+}
 
-  glUniform2fv(glGetUniformLocation(shader_img, "cameraPos"), 1, cameraPos);
-  glUniform2fv(glGetUniformLocation(shader_img, "mousePos"), 1, mousePos);
-  glUniform1i(glGetUniformLocation(shader_img, "uTexture"), 0);
+void PickPixel(float x, float y) {
+  Vec2f p = WindowToImage(x, y);
+  int ix = (int)floorf(p.x);
+  int iy = (int)floorf(p.y);
 
-  glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT,
-                 (void*)(0 * sizeof(unsigned int)));
+  // 截图外面是 GL_CLAMP_TO_BORDER 的黑色
+  if (ix < 0 || ix >= virtualWidth || iy < 0 || iy >= virtualHeight) {
+    memset(pixel, 0, sizeof(pixel));
+    return;
+  }
 
-  glBindVertexArray(0);             // 解绑
-  glBindTexture(GL_TEXTURE_2D, 0);  // 解绑
+  SampleArea(screenPixels, virtualWidth, virtualHeight, ix, iy,
+             sampleSizes[sampleSizeIndex], sampleMode, pixel);
+  pixel[3] = 255;
 }
 
-#ifdef FREETYPE
-void RenderText(std::string& text, GLfloat x, GLfloat y, GLfloat scale,
-                Vec3f color) {
-  // 激活对应的渲染状态
-  glUseProgram(shader_txt);
+//? 选区取两个端点所在像素的外包矩形，松开右键时才统计
+void UpdateSelection(bool finished) {
+  if (rulerMode) {
+    Vec2f a = SnapToEdges(selectStart);
+    Vec2f b = SnapToEdges(selectEnd);
+    selectionRect[0] = fmin(a.x, b.x);
+    selectionRect[1] = fmin(a.y, b.y);
+    selectionRect[2] = fmax(a.x, b.x);
+    selectionRect[3] = fmax(a.y, b.y);
+    rulerSize[0] = (int)(selectionRect[2] - selectionRect[0]);
+    rulerSize[1] = (int)(selectionRect[3] - selectionRect[1]);
+    if (finished) {
+      isSelecting = false;
+      hasRuler = true;
+    }
+    return;
+  }
 
-  glActiveTexture(GL_TEXTURE0);
-  glBindVertexArray(textVAO);
-  Mat4 projection = ortho(0, virtualWidth, 0, virtualHeight);
+  float x0 = floorf(fmin(selectStart.x, selectEnd.x));
+  float y0 = floorf(fmin(selectStart.y, selectEnd.y));
+  float x1 = floorf(fmax(selectStart.x, selectEnd.x)) + 1;
+  float y1 = floorf(fmax(selectStart.y, selectEnd.y)) + 1;
+
+  selectionRect[0] = x0;
+  selectionRect[1] = y0;
+  selectionRect[2] = x1;
+  selectionRect[3] = y1;
+
+  if (finished) {
+    isSelecting = false;
+    regionQueued = true;
+    regionQueuedRect[0] = (int)x0;
+    regionQueuedRect[1] = (int)y0;
+    regionQueuedRect[2] = (int)x1;
+    regionQueuedRect[3] = (int)y1;
+    regionRequest++;
+  }
+}
 
-  glUniform1i(glGetUniformLocation(shader_txt, "text"), 0);
-  glUniform3f(glGetUniformLocation(shader_txt, "textColor"), color.x, color.y,
-              color.z);
-  glUniformMatrix4fv(glGetUniformLocation(shader_txt, "projection"), 1,
-                     GL_FALSE, projection.m);
+//? 每帧调一次: 收下算好的统计，有排着的选区就开始算
+void UpdateRegionStats() {
+  if (regionBuilding) {
+    if (!regionBuilt.load(std::memory_order_acquire)) return;
+    regionBuilder.join();
+    regionBuilding = false;
+    if (regionBuildRequest == regionRequest) {
+      regionStats = regionNext;
+      hasRegion = regionFound;
+      regionVersion++;
+    }
+  }
+  if (!regionQueued) return;
+
+  regionQueued = false;
+  regionBuilding = true;
+  regionBuildRequest = regionRequest;
+  regionBuilt.store(false, std::memory_order_relaxed);
+  int x0 = regionQueuedRect[0], y0 = regionQueuedRect[1];
+  int x1 = regionQueuedRect[2], y1 = regionQueuedRect[3];
+  regionBuilder = std::thread([=] {
+    ParallelMarkBackgroundThread();
+    regionFound = ComputeRegionStats(screenPixels, virtualWidth,
+                                     virtualHeight, x0, y0, x1, y1,
+                                     regionNext);
+    regionBuilt.store(true, std::memory_order_release);
+  });
+}
 
-  // 遍历文本中所有的字符
-  std::string::const_iterator c;
-  for (c = text.begin(); c != text.end(); c++) {
-    Character ch = Characters[*c];
+//? 横竖两个方向分别沿穿过 p 的那一行 / 一列找边，范围按当前缩放换算
+Vec2f SnapToEdges(Vec2f p) {
+  Vec2f snapped = Vec2f(roundf(p.x), roundf(p.y));
+  if (!gradientReady.load(std::memory_order_acquire)) return snapped;
+
+  int radius = std::min((int)ceilf(SNAP_RADIUS / camera.scale),
+                        SNAP_MAX_RADIUS);
+  int column = (int)floorf(p.x);
+  int row = (int)floorf(p.y);
+  int x = SnapEdgeX(gradientField, p.x, row, radius);
+  int y = SnapEdgeY(gradientField, column, p.y, radius);
+  if (x >= 0) snapped.x = (float)x;
+  if (y >= 0) snapped.y = (float)y;
+  return snapped;
+}
+
+//? 只把字形的顶点追加到 HUD 块里，真正的绘制在 FlushText
+void RenderText(HudBlock& block, const char* text, GLfloat x, GLfloat y,
+                GLfloat scale, Vec3f color) {
+  // 图集按 SDF_PIXEL_HEIGHT 生成，换算到 pixel_height 再乘 HUD 缩放
+  scale *= (GLfloat)pixel_height / SDF_PIXEL_HEIGHT;
+
+  // 遍历文本中所有的字符 (UTF-8)
+  const char* end = text + strlen(text);
+  while (text != end) {
+    uint32_t codepoint = DecodeUtf8(text, end);
+    const Character* glyph = &asciiGlyphs['?'];
+    if (codepoint < 128) {
+      glyph = &asciiGlyphs[codepoint];
+    } else {
+      int slot = GetCachedGlyph(codepoint);
+      if (slot >= 0) {
+        glyph = &glyphSlots[slot].ch;
+        block.glyphSlots.push_back(slot);
+      }
+    }
+    const Character& ch = *glyph;
 
     GLfloat xpos = x + ch.Bearing.x * scale;
     GLfloat ypos = y - (ch.Size.y - ch.Bearing.y) * scale;
@@ -881,30 +2037,452 @@ void RenderText(std::string& text, GLfloat x, GLfloat y, GLfloat scale,
     GLfloat w = ch.Size.x * scale;
     GLfloat h = ch.Size.y * scale;
 
-    // 对每个字符更新VBO
+    GLfloat u0 = ch.UVMin.x, v0 = ch.UVMin.y;
+    GLfloat u1 = ch.UVMax.x, v1 = ch.UVMax.y;
+
     // clang-format off
-    GLfloat vertices[6][4] = {
-        {xpos, ypos + h, 0.0, 0.0},
-        {xpos, ypos, 0.0, 1.0},
-        {xpos + w, ypos, 1.0, 1.0},
-        {xpos, ypos + h, 0.0, 0.0},
-        {xpos + w, ypos, 1.0, 1.0},
-        {xpos + w, ypos + h, 1.0, 0.0}};
+    GLfloat vertices[6][TEXT_VERTEX_FLOATS] = {
+        {xpos,     ypos + h, u0, v0, color.x, color.y, color.z},
+        {xpos,     ypos,     u0, v1, color.x, color.y, color.z},
+        {xpos + w, ypos,     u1, v1, color.x, color.y, color.z},
+        {xpos,     ypos + h, u0, v0, color.x, color.y, color.z},
+        {xpos + w, ypos,     u1, v1, color.x, color.y, color.z},
+        {xpos + w, ypos + h, u1, v0, color.x, color.y, color.z}};
     // clang-format on
 
-    // 在四边形上绘制字形纹理
-    glBindTexture(GL_TEXTURE_2D, ch.TextureID);
-    // 更新VBO内存的内容
-    glBindBuffer(GL_ARRAY_BUFFER, textVBO);
-    glBufferSubData(GL_ARRAY_BUFFER, 0, sizeof(vertices), vertices);
-    glBindBuffer(GL_ARRAY_BUFFER, 0);
-    // 绘制四边形
-    glDrawArrays(GL_TRIANGLES, 0, 6);
+    block.vertices.insert(block.vertices.end(), &vertices[0][0],
+                          &vertices[0][0] + sizeof(vertices) / sizeof(GLfloat));
+
     // 更新位置到下一个字形的原点，注意单位是1/64像素
     x += (ch.Advance >> 6) *
          scale;  // 位偏移6个单位来获取单位为像素的值 (2^6 = 64)
   }
+}
+
+//? key 变了就清空这块并返回 true，调用方重新排版；没变返回 false
+bool BeginHudBlock(HudBlock& block, const HudKey& key) {
+  if (block.valid && block.key == key.hash) return false;
+  block.valid = true;
+  block.key = key.hash;
+  block.vertices.clear();
+  block.glyphSlots.clear();
+  hudDirty = true;
+  return true;
+}
+
+void InitTextRing() {
+  GLsizeiptr bytes =
+      TEXT_RING_REGIONS * TEXT_RING_REGION_FLOATS * sizeof(GLfloat);
+
+  if (GLVersionAtLeast(4, 4) && GLHas(GLOPT_glBufferStorage)) {
+    GLbitfield flags =
+        GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+    glBufferStorage(GL_ARRAY_BUFFER, bytes, nullptr, flags);
+    textRingMapped =
+        (GLfloat*)glMapBufferRange(GL_ARRAY_BUFFER, 0, bytes, flags);
+  }
+  if (!textRingMapped) {
+    glBufferData(GL_ARRAY_BUFFER, bytes, nullptr, GL_STREAM_DRAW);
+  }
+}
+
+//? 只有 HUD 块重排过才把所有块写进环形缓冲的下一段，否则直接画上次那段
+void FlushText() {
+  glyphFrame++;  // 之后取的字形算下一帧
+
+  // 复用的块不会再调 GetCachedGlyph，替它们把缓存格子标成下一帧用过
+  for (HudBlock& block : hudBlocks) {
+    for (int slot : block.glyphSlots) glyphSlots[slot].lastUsed = glyphFrame;
+  }
+
+  if (softwareRender) {
+    float rect[4];
+    OutputRect(outputs[currentOutput], rect);
+    int clip[4] = {(int)rect[0], (int)rect[1], (int)(rect[0] + rect[2]),
+                   (int)(rect[1] + rect[3])};
+    for (const HudBlock& block : hudBlocks) {
+      SoftRenderText(block.vertices.data(),
+                     (int)(block.vertices.size() / TEXT_VERTEX_FLOATS),
+                     atlasPixels.data(), atlasWidth, atlasHeight, softPixels,
+                     softPitch, clip);
+    }
+    return;
+  }
+
+  glBindBuffer(GL_ARRAY_BUFFER, textVBO);
+  if (hudDirty) {
+    hudDirty = false;
+    textRingRegion = (textRingRegion + 1) % TEXT_RING_REGIONS;
+    GLsync& fence = textRingFences[textRingRegion];
+    if (fence) {
+      glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000);
+      glDeleteSync(fence);
+      fence = 0;
+    }
+
+    GLintptr offset = textRingRegion * TEXT_RING_REGION_FLOATS;
+    GLfloat* dst;
+    if (textRingMapped) {
+      dst = textRingMapped + offset;
+    } else {
+      // 这段的 fence 已经等过，不用让驱动再同步
+      dst = (GLfloat*)glMapBufferRange(
+          GL_ARRAY_BUFFER, offset * sizeof(GLfloat),
+          TEXT_RING_REGION_FLOATS * sizeof(GLfloat),
+          GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT |
+              GL_MAP_UNSYNCHRONIZED_BIT);
+    }
+
+    size_t count = 0;
+    for (const HudBlock& block : hudBlocks) {
+      // 超出一段的字形直接丢掉
+      size_t room = TEXT_RING_REGION_FLOATS - count;
+      size_t n = block.vertices.size() < room ? block.vertices.size() : room;
+      if (dst) memcpy(dst + count, block.vertices.data(), n * sizeof(GLfloat));
+      count += n;
+    }
+    if (!textRingMapped) glUnmapBuffer(GL_ARRAY_BUFFER);
+    textDrawCount = (GLsizei)(count / TEXT_VERTEX_FLOATS);
+    frameStats.bufferUploads++;
+  }
+  glBindBuffer(GL_ARRAY_BUFFER, 0);
+  if (textDrawCount == 0) return;
+
+  // 激活对应的渲染状态
+  glUseProgram(shader_txt);
+  if (textProjectionOutput != currentOutput) {
+    float rect[4];
+    OutputRect(outputs[currentOutput], rect);
+    Mat4 projection =
+        ortho(rect[0], rect[0] + rect[2], rect[1], rect[1] + rect[3]);
+    glUniformMatrix4fv(textProjection, 1, GL_FALSE, projection.m);
+    textProjectionOutput = currentOutput;
+    frameStats.uniformUpdates++;
+  }
+
+  glActiveTexture(GL_TEXTURE0);
+  glBindVertexArray(textVAO);
+  glBindTexture(GL_TEXTURE_2D, glyphAtlas);
+
+  glDrawArrays(GL_TRIANGLES,
+               textRingRegion * TEXT_RING_REGION_FLOATS / TEXT_VERTEX_FLOATS,
+               textDrawCount);
+  frameStats.drawCalls++;
+
+  // 这段每帧都可能被画，fence 换成最新的一次
+  GLsync& fence = textRingFences[textRingRegion];
+  if (fence) glDeleteSync(fence);
+  fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+
   glBindVertexArray(0);
   glBindTexture(GL_TEXTURE_2D, 0);
 }
+
+void RenderTextf(HudBlock& block, GLfloat x, GLfloat y, GLfloat scale,
+                 Vec3f color, const char* fmt, ...) {
+  char buf[BUF_SIZE];
+  va_list args;
+  va_start(args, fmt);
+  vsnprintf(buf, sizeof(buf), fmt, args);
+  va_end(args);
+
+  RenderText(block, buf, x, y, scale, color);
+}
+
+//? 取一个码位，非法序列返回 U+FFFD 并只吃掉一个字节
+uint32_t DecodeUtf8(const char*& it, const char* end) {
+  unsigned char b = (unsigned char)*it++;
+  if (b < 0x80) return b;
+
+  int extra;
+  uint32_t codepoint;
+  if ((b & 0xE0) == 0xC0) {
+    extra = 1;
+    codepoint = b & 0x1F;
+  } else if ((b & 0xF0) == 0xE0) {
+    extra = 2;
+    codepoint = b & 0x0F;
+  } else if ((b & 0xF8) == 0xF0) {
+    extra = 3;
+    codepoint = b & 0x07;
+  } else {
+    return 0xFFFD;
+  }
+
+  const char* p = it;
+  for (int i = 0; i < extra; i++) {
+    if (p == end || ((unsigned char)*p & 0xC0) != 0x80) return 0xFFFD;
+    codepoint = (codepoint << 6) | ((unsigned char)*p++ & 0x3F);
+  }
+  it = p;
+  return codepoint;
+}
+
+//? 缓存未命中时把字形生成进最久没用的格子，只更新这一格的纹理
+//? 先找内置点阵，没有的才交给 FreeType
+//? 本帧已经用过的格子不能淘汰 (顶点已经指向它)，这时返回 -1 退回 '?'
+int GetCachedGlyph(uint32_t codepoint) {
+  auto found = glyphSlotIndex.find(codepoint);
+  if (found != glyphSlotIndex.end()) {
+    GlyphSlot& slot = glyphSlots[found->second];
+    slot.lastUsed = glyphFrame;
+    return found->second;
+  }
+
+  int victim = 0;
+  for (int i = 1; i < GLYPH_CACHE_SLOTS; i++) {
+    if (glyphSlots[i].lastUsed < glyphSlots[victim].lastUsed) victim = i;
+  }
+  GlyphSlot& slot = glyphSlots[victim];
+  if (slot.lastUsed == glyphFrame) return -1;
+
+  // 整格重新生成再上传，顺便清掉旧字形
+  static unsigned char cell[SDF_CELL * SDF_CELL];
+  memset(cell, 0, sizeof(cell));
+  Character ch;
+  const Font8x8Glyph* embedded = nullptr;
+  for (int i = 0; i < font8x8Latin1Count; i++) {
+    if (font8x8Latin1[i].codepoint == codepoint) embedded = &font8x8Latin1[i];
+  }
+  if (embedded) {
+    BakeBitmapGlyph(embedded->rows, cell, SDF_CELL, ch);
+  } else {
+#ifdef FREETYPE
+    if (!LoadFace() || !RasterizeSdfGlyph(codepoint, cell, SDF_CELL, ch)) {
+      return -1;
+    }
+#else
+    return -1;
+#endif
+  }
+  if (slot.lastUsed != 0) glyphSlotIndex.erase(slot.codepoint);
+
+  int index = 128 + victim;
+  SetGlyphCell(ch, index);
+  int cellX = (index % ATLAS_COLUMNS) * SDF_CELL;
+  int cellY = (index / ATLAS_COLUMNS) * SDF_CELL;
+  for (int row = 0; row < SDF_CELL; row++) {
+    memcpy(&atlasPixels[(cellY + row) * atlasWidth + cellX],
+           cell + row * SDF_CELL, SDF_CELL);
+  }
+  if (!softwareRender) {
+    glBindTexture(GL_TEXTURE_2D, glyphAtlas);
+    glTexSubImage2D(GL_TEXTURE_2D, 0, cellX, cellY, SDF_CELL, SDF_CELL,
+                    GL_RED, GL_UNSIGNED_BYTE, cell);
+    glBindTexture(GL_TEXTURE_2D, 0);
+    frameStats.bufferUploads++;
+  }
+
+  slot.codepoint = codepoint;
+  slot.lastUsed = glyphFrame;
+  slot.ch = ch;
+  glyphSlotIndex[codepoint] = victim;
+  return victim;
+}
+
+//? 点阵的每个点放大成 FONT_TEXEL_SCALE 个图集像素，四周留 SDF_SPREAD
+void BakeBitmapGlyph(const unsigned char rows[8], unsigned char* cell,
+                     int pitch, Character& ch) {
+  BuildBitmapDistanceField(rows, FONT_TEXEL_SCALE, SDF_SPREAD, SDF_SPREAD,
+                           cell, pitch);
+  int size = 8 * FONT_TEXEL_SCALE + SDF_SPREAD * 2;
+  ch.Size = Vec2i(size, size);
+  ch.Bearing = Vec2i(-SDF_SPREAD,
+                     FONT8X8_ASCENDER * FONT_TEXEL_SCALE + SDF_SPREAD);
+  ch.Advance = (8 * FONT_TEXEL_SCALE) << 6;
+}
+
+void SetGlyphCell(Character& ch, int index) {
+  int x0 = (index % ATLAS_COLUMNS) * SDF_CELL;
+  int y0 = (index / ATLAS_COLUMNS) * SDF_CELL;
+  ch.UVMin = Vec2f((float)x0 / atlasWidth, (float)y0 / atlasHeight);
+  ch.UVMax = Vec2f((float)(x0 + ch.Size.x) / atlasWidth,
+                   (float)(y0 + ch.Size.y) / atlasHeight);
+}
+
+#ifdef FREETYPE
+//? 第一次需要生成距离场时才初始化 FreeType，失败后不再重试
+bool LoadFace() {
+  static bool failed = false;
+  if (faceLoaded) return true;
+  if (failed) return false;
+
+  if (FT_Init_FreeType(&ft)) {
+    failed = true;
+    return false;
+  }
+  if (FT_New_Face(ft, fontPath.c_str(), 0, &face)) {
+    FT_Done_FreeType(ft);
+    failed = true;
+    return false;
+  }
+  FT_Set_Pixel_Sizes(face, 0, SDF_PIXEL_HEIGHT * SDF_OVERSAMPLE);
+  faceLoaded = true;
+  return true;
+}
+
+static int FloorDiv(int a, int b) {
+  return a >= 0 ? a / b : -((-a + b - 1) / b);
+}
+
+//? 按 SDF_OVERSAMPLE 倍光栅化，对齐到距离场的像素网格，四周留 SDF_SPREAD
+//? 距离场写进 cell (行距 pitch)，度量单位是图集里的像素
+bool RasterizeSdfGlyph(uint32_t codepoint, unsigned char* cell, int pitch,
+                       Character& ch) {
+  if (FT_Load_Char(face, codepoint, FT_LOAD_RENDER)) return false;
+  FT_GlyphSlot glyph = face->glyph;
+  FT_Bitmap& bm = glyph->bitmap;
+
+  const int os = SDF_OVERSAMPLE;
+  int left = FloorDiv(glyph->bitmap_left, os);
+  int top = -FloorDiv(-glyph->bitmap_top, os);
+  int offX = SDF_SPREAD * os + glyph->bitmap_left - left * os;
+  int offY = SDF_SPREAD * os + top * os - glyph->bitmap_top;
+  int w = (int)fmin((offX + (int)bm.width + os - 1) / os + SDF_SPREAD,
+                    SDF_CELL - 1);
+  int h = (int)fmin((offY + (int)bm.rows + os - 1) / os + SDF_SPREAD,
+                    SDF_CELL - 1);
+
+  static std::vector<unsigned char> coverage;
+  coverage.assign(w * os * h * os, 0);
+  int copyW = (int)fmin(bm.width, w * os - offX);
+  int copyH = (int)fmin(bm.rows, h * os - offY);
+  for (int row = 0; row < copyH; row++) {
+    memcpy(coverage.data() + (offY + row) * w * os + offX,
+           bm.buffer + row * bm.pitch, copyW);
+  }
+  BuildDistanceField(coverage.data(), w, h, os, SDF_SPREAD, cell, pitch);
+
+  ch.Size = Vec2i(w, h);
+  ch.Bearing = Vec2i(left - SDF_SPREAD, top + SDF_SPREAD);
+  ch.Advance = glyph->advance.x / os;
+  return true;
+}
 #endif
+
+//? 按过滤方式设置截图纹理的采样参数，缩小 (按动态分辨率后的倍数算) 且不是
+//? NEAREST 时才上传 mipmap
+//? BICUBIC/LANCZOS/PIXEL ART 放大时在 shader 里用 texelFetch，不受这里影响
+void UpdateScreenSampler() {
+  bool minifying = ScreenSampleScale() < 1.0f && filterMode != FILTER_NEAREST;
+  if (minifying) UploadScreenMips();
+  bool hasMips = mipUploadedFrom <= mipLevelCount;
+
+  GLint minFilter = GL_NEAREST, magFilter = GL_NEAREST;
+  if (filterMode != FILTER_NEAREST) {
+    minFilter = hasMips ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR;
+    magFilter = GL_LINEAR;
+  }
+  if (minFilter != screenMinFilter) {
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, minFilter);
+    screenMinFilter = minFilter;
+  }
+  if (magFilter != screenMagFilter) {
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, magFilter);
+    screenMagFilter = magFilter;
+  }
+
+  // 细的几级还没到时，缩小只能用已经到了的粗的几级
+  // 放大时必须是 0，否则 LOD 被抬高会当成缩小来采样
+  float minLod = 0.0f;
+  if (minifying && hasMips && mipUploadedFrom > 1) minLod = mipUploadedFrom;
+  if (minLod != screenMinLod) {
+    glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MIN_LOD, minLod);
+    screenMinLod = minLod;
+  }
+}
+
+void StartMipBuilder(const unsigned char* pixels, int width, int height) {
+  mipLevelCount = MipLevelCount(width, height);
+  mipUploadedFrom = mipLevelCount + 1;
+  mipData.assign(mipLevelCount, nullptr);
+  for (int level = 1; level <= mipLevelCount; level++) {
+    mipData[level - 1] =
+        new unsigned char[MipSize(width, level) * MipSize(height, level) * 4];
+  }
+
+  mipBuilder = std::thread([=] {
+    ParallelMarkBackgroundThread();
+    const unsigned char* src = pixels;
+    for (int level = 1; level <= mipLevelCount; level++) {
+      DownsampleBox2x2(src, MipSize(width, level - 1),
+                       MipSize(height, level - 1), mipData[level - 1]);
+      src = mipData[level - 1];
+    }
+    mipsBuilt.store(true, std::memory_order_release);
+  });
+}
+
+//? 从最粗的一级往细的传，每帧不超过 MIP_UPLOAD_BUDGET 字节
+//? 各级的存储第一次用到时一起分配，这样随时都是完整的纹理
+void UploadScreenMips() {
+  if (mipUploadedFrom <= 1) return;
+  if (!mipsBuilt.load(std::memory_order_acquire)) return;
+
+  if (!mipsAllocated) {
+    for (int level = 1; level <= mipLevelCount; level++) {
+      glTexImage2D(GL_TEXTURE_2D, level, GL_RGBA,
+                   MipSize(virtualWidth, level), MipSize(virtualHeight, level),
+                   0, GL_BGRA, GL_UNSIGNED_BYTE, nullptr);
+    }
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, mipLevelCount);
+    mipsAllocated = true;
+  }
+
+  size_t uploaded = 0;
+  while (mipUploadedFrom > 1) {
+    int level = mipUploadedFrom - 1;
+    int width = MipSize(virtualWidth, level);
+    int height = MipSize(virtualHeight, level);
+    size_t bytes = (size_t)width * height * 4;
+    if (uploaded > 0 && uploaded + bytes > MIP_UPLOAD_BUDGET) break;
+
+    glTexSubImage2D(GL_TEXTURE_2D, level, 0, 0, width, height, GL_BGRA,
+                    GL_UNSIGNED_BYTE, mipData[level - 1]);
+    delete[] mipData[level - 1];
+    mipData[level - 1] = nullptr;
+    uploaded += bytes;
+    mipUploadedFrom = level;
+    frameStats.bufferUploads++;
+  }
+  if (mipUploadedFrom == 1) mipBuilder.join();
+}
+
+//? 每帧调一次: 收下生成好的表，需要的话开始生成下一张
+//? 拉伸用的亮度分布在后台线程里从截图算，截图在程序结束前不会变
+void UpdateColorLut() {
+  if (lutBuilding != TRANSFORM_NONE) {
+    if (!lutBuilt.load(std::memory_order_acquire)) return;
+    lutBuilder.join();
+    if (lutBuilding == colorTransform) {
+      lutData.swap(lutNext);
+      lutTextureIndex ^= 1;
+      glBindTexture(GL_TEXTURE_3D, lutTextures[lutTextureIndex]);
+      glTexSubImage3D(GL_TEXTURE_3D, 0, 0, 0, 0, LUT_SIZE, LUT_SIZE, LUT_SIZE,
+                      GL_RGBA, GL_UNSIGNED_BYTE, lutData.data());
+      glBindTexture(GL_TEXTURE_3D, 0);
+      lutTransform = lutBuilding;
+      frameStats.bufferUploads++;
+    }
+    lutBuilding = TRANSFORM_NONE;
+  }
+
+  if (colorTransform == TRANSFORM_NONE) {
+    lutTransform = TRANSFORM_NONE;
+    return;
+  }
+  if (lutTransform == colorTransform) return;
+
+  lutBuilding = colorTransform;
+  lutBuilt.store(false, std::memory_order_relaxed);
+  ColorTransform transform = colorTransform;
+  unsigned char* out = lutNext.data();
+  lutBuilder = std::thread([=] {
+    LutImageStats stats = {};
+    if (transform == TRANSFORM_STRETCH) {
+      stats = ComputeLutImageStats(screenPixels, virtualWidth, virtualHeight);
+    }
+    BuildColorLut(transform, stats, LUT_SIZE, out);
+    lutBuilt.store(true, std::memory_order_release);
+  });
+}
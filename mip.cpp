@@ -0,0 +1,80 @@
+#include "mip.h"
+
+#include "parallel.h"
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+int MipLevelCount(int width, int height) {
+  int size = width > height ? width : height;
+  int levels = 0;
+  while (size > 1) {
+    size >>= 1;
+    levels++;
+  }
+  return levels;
+}
+
+//? 一行输出: 上下两行源像素 2x2 求平均，四舍五入
+static void DownsampleRow(const unsigned char* row0, const unsigned char* row1,
+                          int srcWidth, unsigned char* dst, int dstWidth) {
+  int x = 0;
+#ifdef __SSE2__
+  // 一次 4 个输出像素 (8 个源像素)，16 位通道上先竖着加再横着两两相加
+  if (srcWidth >= 2) {
+    __m128i zero = _mm_setzero_si128();
+    __m128i round = _mm_set1_epi16(2);
+    for (; x + 4 <= dstWidth && 2 * x + 8 <= srcWidth; x += 4) {
+      __m128i a0 = _mm_loadu_si128((const __m128i*)(row0 + x * 8));
+      __m128i a1 = _mm_loadu_si128((const __m128i*)(row0 + x * 8 + 16));
+      __m128i b0 = _mm_loadu_si128((const __m128i*)(row1 + x * 8));
+      __m128i b1 = _mm_loadu_si128((const __m128i*)(row1 + x * 8 + 16));
+
+      // 每个寄存器两个像素: p0p1 p2p3 p4p5 p6p7
+      __m128i p01 = _mm_add_epi16(_mm_unpacklo_epi8(a0, zero),
+                                  _mm_unpacklo_epi8(b0, zero));
+      __m128i p23 = _mm_add_epi16(_mm_unpackhi_epi8(a0, zero),
+                                  _mm_unpackhi_epi8(b0, zero));
+      __m128i p45 = _mm_add_epi16(_mm_unpacklo_epi8(a1, zero),
+                                  _mm_unpacklo_epi8(b1, zero));
+      __m128i p67 = _mm_add_epi16(_mm_unpackhi_epi8(a1, zero),
+                                  _mm_unpackhi_epi8(b1, zero));
+
+      // 相邻两个像素相加: (p0 + p1, p2 + p3) 和 (p4 + p5, p6 + p7)
+      __m128i s0 = _mm_add_epi16(_mm_unpacklo_epi64(p01, p23),
+                                 _mm_unpackhi_epi64(p01, p23));
+      __m128i s1 = _mm_add_epi16(_mm_unpacklo_epi64(p45, p67),
+                                 _mm_unpackhi_epi64(p45, p67));
+      s0 = _mm_srli_epi16(_mm_add_epi16(s0, round), 2);
+      s1 = _mm_srli_epi16(_mm_add_epi16(s1, round), 2);
+      _mm_storeu_si128((__m128i*)(dst + x * 4), _mm_packus_epi16(s0, s1));
+    }
+  }
+#endif
+  for (; x < dstWidth; x++) {
+    int x0 = 2 * x < srcWidth ? 2 * x : srcWidth - 1;
+    int x1 = 2 * x + 1 < srcWidth ? 2 * x + 1 : srcWidth - 1;
+    for (int c = 0; c < 4; c++) {
+      int sum = row0[x0 * 4 + c] + row0[x1 * 4 + c] + row1[x0 * 4 + c] +
+                row1[x1 * 4 + c];
+      dst[x * 4 + c] = (unsigned char)((sum + 2) >> 2);
+    }
+  }
+}
+
+void DownsampleBox2x2(const unsigned char* src, int srcWidth, int srcHeight,
+                      unsigned char* dst) {
+  int dstWidth = MipSize(srcWidth, 1);
+  int dstHeight = MipSize(srcHeight, 1);
+  size_t srcStride = (size_t)srcWidth * 4;
+
+  ParallelFor(0, dstHeight, [&](int begin, int end) {
+    for (int y = begin; y < end; y++) {
+      int y0 = 2 * y < srcHeight ? 2 * y : srcHeight - 1;
+      int y1 = 2 * y + 1 < srcHeight ? 2 * y + 1 : srcHeight - 1;
+      DownsampleRow(src + y0 * srcStride, src + y1 * srcStride, srcWidth,
+                    dst + (size_t)y * dstWidth * 4, dstWidth);
+    }
+  });
+}
@@ -0,0 +1,16 @@
+#pragma once
+
+//& 截图的 mipmap 金字塔: CPU 上用 2x2 盒式滤波逐级缩小 (BGRA)
+//? 各级尺寸和 OpenGL 一致: max(1, 上一级 / 2)，奇数边长时最后一行/列不参与
+
+//? 不含第 0 级的级数
+int MipLevelCount(int width, int height);
+
+inline int MipSize(int size, int level) {
+  size >>= level;
+  return size > 0 ? size : 1;
+}
+
+//? dst 是 src 缩小一级的结果，按行交给 ParallelFor
+void DownsampleBox2x2(const unsigned char* src, int srcWidth, int srcHeight,
+                      unsigned char* dst);
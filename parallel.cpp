@@ -0,0 +1,158 @@
+#include "parallel.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace {
+
+struct Job {
+  const std::function<void(int, int)>* fn;
+  int workers;  // 编号小于它的工作线程才参与
+  int end;
+  int chunk;
+  std::atomic<int> next;
+  std::atomic<int> remaining;
+};
+
+//? 工作线程是 detach 的，进程退出时还阻塞在条件变量上；
+//? 这些对象故意不析构，否则析构会等待这些线程
+struct Pool {
+  std::mutex runMutex;  // 一次一个任务
+  std::mutex jobMutex;
+  std::condition_variable jobReady;
+  std::condition_variable jobDone;
+  Job* currentJob = nullptr;
+  int busyWorkers = 0;  // 还拿着 currentJob 的工作线程
+  unsigned generation = 0;
+  std::atomic<int> foregroundWaiting{0};  // 排队等 runMutex 的前台调用
+};
+
+//? 后台线程的 ParallelFor 最多切成这么多段，一段一段地占线程池
+#define BACKGROUND_SLICES 16
+
+std::once_flag poolOnce;
+Pool* pool;
+int workerCount = 1;
+std::atomic<int> workerLimit{0};
+thread_local bool backgroundThread;
+
+// 抢下一块来跑，返回是否还有活
+bool RunChunk(Job* job) {
+  int b = job->next.fetch_add(job->chunk);
+  if (b >= job->end) return false;
+  int e = b + job->chunk < job->end ? b + job->chunk : job->end;
+  (*job->fn)(b, e);
+  if (job->remaining.fetch_sub(e - b) == e - b) {
+    std::lock_guard<std::mutex> lock(pool->jobMutex);
+    pool->jobDone.notify_all();
+  }
+  return true;
+}
+
+void WorkerLoop(int index) {
+  unsigned seen = 0;
+  while (true) {
+    Job* job;
+    {
+      std::unique_lock<std::mutex> lock(pool->jobMutex);
+      pool->jobReady.wait(lock, [&] { return pool->generation != seen; });
+      seen = pool->generation;
+      job = pool->currentJob;
+      if (job && index >= job->workers) job = nullptr;
+      if (job) pool->busyWorkers++;
+    }
+    if (job) {
+      while (RunChunk(job)) {
+      }
+      std::lock_guard<std::mutex> lock(pool->jobMutex);
+      pool->busyWorkers--;
+      pool->jobDone.notify_all();
+    }
+  }
+}
+
+void StartPool() {
+  pool = new Pool();
+  unsigned n = std::thread::hardware_concurrency();
+  workerCount = n > 1 ? (int)n : 1;
+  for (int i = 1; i < workerCount; i++) {
+    std::thread(WorkerLoop, i).detach();
+  }
+}
+
+//? 调用线程已经拿着 runMutex: 把 [begin, end) 交给线程池，自己也参与
+void RunJob(int begin, int end, int workers,
+            const std::function<void(int, int)>& fn) {
+  int count = end - begin;
+
+  // 每个线程分几块，块之间负载不均时可以互相补位
+  Job job;
+  job.fn = &fn;
+  job.workers = workers;
+  job.end = end;
+  job.chunk = count / (workers * 4);
+  if (job.chunk < 1) job.chunk = 1;
+  job.next = begin;
+  job.remaining = count;
+
+  {
+    std::lock_guard<std::mutex> lock(pool->jobMutex);
+    pool->currentJob = &job;
+    pool->generation++;
+  }
+  pool->jobReady.notify_all();
+
+  while (RunChunk(&job)) {
+  }
+
+  std::unique_lock<std::mutex> lock(pool->jobMutex);
+  // job 在栈上，要等所有工作线程都放手
+  pool->jobDone.wait(lock, [&] {
+    return job.remaining.load() == 0 && pool->busyWorkers == 0;
+  });
+  pool->currentJob = nullptr;
+}
+
+}  // namespace
+
+int ParallelWorkerCount() {
+  std::call_once(poolOnce, StartPool);
+  int limit = workerLimit.load();
+  return limit > 0 && limit < workerCount ? limit : workerCount;
+}
+
+void ParallelSetWorkerLimit(int limit) { workerLimit = limit; }
+
+void ParallelFor(int begin, int end,
+                 const std::function<void(int, int)>& fn) {
+  if (begin >= end) return;
+  int workers = ParallelWorkerCount();
+
+  int count = end - begin;
+  if (workers == 1 || count == 1) {
+    fn(begin, end);
+    return;
+  }
+
+  if (!backgroundThread) {
+    pool->foregroundWaiting++;
+    std::lock_guard<std::mutex> run(pool->runMutex);
+    pool->foregroundWaiting--;
+    RunJob(begin, end, workers, fn);
+    return;
+  }
+
+  // 后台: 每段开始前先让排着队的前台调用过去，前台最多等一段
+  int slice = (count + BACKGROUND_SLICES - 1) / BACKGROUND_SLICES;
+  if (slice < workers) slice = workers;
+  for (int b = begin; b < end; b += slice) {
+    while (pool->foregroundWaiting.load() > 0) std::this_thread::yield();
+    std::lock_guard<std::mutex> run(pool->runMutex);
+    RunJob(b, end - b < slice ? end : b + slice, workers, fn);
+  }
+}
+
+void ParallelMarkBackgroundThread() { backgroundThread = true; }
@@ -0,0 +1,21 @@
+#pragma once
+
+#include <functional>
+
+//& 常驻线程池，按区间切块并行
+//? [begin, end) 切成若干块交给工作线程，调用线程也参与，全部完成后返回
+//? 同一时刻只跑一个任务，其他线程的调用会排队；fn 里不能再调用 ParallelFor
+void ParallelFor(int begin, int end,
+                 const std::function<void(int begin, int end)>& fn);
+
+//? 工作线程数 (含调用线程)，设了上限时是上限
+int ParallelWorkerCount();
+
+//? 之后的 ParallelFor 最多用几个线程 (含调用线程)，0 表示不限
+//? 给基准测试量多线程的伸缩用
+void ParallelSetWorkerLimit(int limit);
+
+//? 把调用线程标成后台线程: 之后它调用的 ParallelFor 仍然用整个线程池，
+//? 但切成几段分别提交，每段之前先让其他线程排着队的 ParallelFor 过去
+//? (mipmap、梯度场这类后台任务不会让渲染的 ParallelFor 等完整个任务)
+void ParallelMarkBackgroundThread();
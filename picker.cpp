@@ -0,0 +1,475 @@
+#include "picker.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <vector>
+
+#include "parallel.h"
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+//? x86 上用 GCC/Clang 的 target 属性单独编一份 AVX2 内核，运行时按 CPU 选用，
+//? 其余代码仍按基线 (SSE2) 编译，老机器上照常运行
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define PICKER_AVX2
+#include <immintrin.h>
+#endif
+
+const char* SampleModeName(SampleMode mode) {
+  switch (mode) {
+    case SAMPLE_POINT:
+      return "POINT";
+    case SAMPLE_MEAN:
+      return "MEAN";
+    case SAMPLE_MEDIAN:
+      return "MEDIAN";
+    case SAMPLE_TRIMMED:
+      return "TRIMMED";
+    default:
+      return "?";
+  }
+}
+
+//? 一行 BGRA 逐通道求和, sum 按 B G R A 排列
+static void SumRow(const unsigned char* row, int count, uint32_t sum[4]) {
+  int i = 0;
+#ifdef __SSE2__
+  // 一行最多 64 像素，每个 16 位通道最多累加 32 * 255，不会溢出
+  __m128i zero = _mm_setzero_si128();
+  __m128i acc = _mm_setzero_si128();
+  for (; i + 4 <= count; i += 4) {
+    __m128i px = _mm_loadu_si128((const __m128i*)(row + i * 4));
+    acc = _mm_add_epi16(acc, _mm_unpacklo_epi8(px, zero));
+    acc = _mm_add_epi16(acc, _mm_unpackhi_epi8(px, zero));
+  }
+  // 两个像素的 16 位通道 -> 32 位后合并
+  __m128i acc32 = _mm_add_epi32(_mm_unpacklo_epi16(acc, zero),
+                                _mm_unpackhi_epi16(acc, zero));
+  uint32_t lanes[4];
+  _mm_storeu_si128((__m128i*)lanes, acc32);
+  for (int c = 0; c < 4; c++) sum[c] += lanes[c];
+#endif
+  for (; i < count; i++) {
+    for (int c = 0; c < 4; c++) sum[c] += row[i * 4 + c];
+  }
+}
+
+#ifdef PICKER_AVX2
+__attribute__((target("avx2"))) static void SumRowAvx2(
+    const unsigned char* row, int count, uint32_t sum[4]) {
+  int i = 0;
+  // 一次 8 个像素，每个 16 位通道最多累加 16 * 255
+  const __m256i zero = _mm256_setzero_si256();
+  __m256i acc = _mm256_setzero_si256();
+  for (; i + 8 <= count; i += 8) {
+    __m256i px = _mm256_loadu_si256((const __m256i*)(row + i * 4));
+    acc = _mm256_add_epi16(acc, _mm256_unpacklo_epi8(px, zero));
+    acc = _mm256_add_epi16(acc, _mm256_unpackhi_epi8(px, zero));
+  }
+  __m256i acc32 = _mm256_add_epi32(_mm256_unpacklo_epi16(acc, zero),
+                                   _mm256_unpackhi_epi16(acc, zero));
+  __m128i total = _mm_add_epi32(_mm256_castsi256_si128(acc32),
+                                _mm256_extracti128_si256(acc32, 1));
+  uint32_t lanes[4];
+  _mm_storeu_si128((__m128i*)lanes, total);
+  for (int c = 0; c < 4; c++) sum[c] += lanes[c];
+  for (; i < count; i++) {
+    for (int c = 0; c < 4; c++) sum[c] += row[i * 4 + c];
+  }
+}
+#endif
+
+typedef void (*SumRowFunc)(const unsigned char* row, int count,
+                           uint32_t sum[4]);
+
+struct SumRowKernel {
+  SumRowFunc fn;
+  const char* name;
+};
+
+static SumRowKernel ChooseSumRow() {
+#ifdef PICKER_AVX2
+  // 静态初始化时还没跑 libgcc 的构造函数，先手动初始化 CPU 信息
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx2")) return {SumRowAvx2, "AVX2"};
+#endif
+#ifdef __SSE2__
+  return {SumRow, "SSE2"};
+#else
+  return {SumRow, "scalar"};
+#endif
+}
+
+static const SumRowKernel sumRow = ChooseSumRow();
+
+const char* SampleKernelName() { return sumRow.name; }
+
+//? 直方图里第 k 小的值 (k 从 0 开始)
+static int HistogramNth(const uint32_t hist[256], uint32_t k) {
+  uint32_t acc = 0;
+  for (int v = 0; v < 256; v++) {
+    acc += hist[v];
+    if (acc > k) return v;
+  }
+  return 255;
+}
+
+//? 直方图中排在 [lo, hi) 之间的值的平均
+static int HistogramRangeMean(const uint32_t hist[256], uint32_t lo,
+                              uint32_t hi) {
+  uint64_t sum = 0;
+  uint32_t pos = 0;
+  for (int v = 0; v < 256 && pos < hi; v++) {
+    uint32_t begin = pos;
+    uint32_t end = pos + hist[v];
+    pos = end;
+    if (end <= lo) continue;
+    if (begin < lo) begin = lo;
+    if (end > hi) end = hi;
+    sum += (uint64_t)v * (end - begin);
+  }
+  return (int)((sum + (hi - lo) / 2) / (hi - lo));
+}
+
+bool SampleArea(const unsigned char* bgra, int width, int height, int cx,
+                int cy, int size, SampleMode mode, unsigned char rgb[3]) {
+  if (mode == SAMPLE_POINT) size = 1;
+  if (size > SAMPLE_MAX_SIZE) size = SAMPLE_MAX_SIZE;
+
+  int x0 = cx - size / 2;
+  int y0 = cy - size / 2;
+  int x1 = x0 + size;
+  int y1 = y0 + size;
+  if (x0 < 0) x0 = 0;
+  if (y0 < 0) y0 = 0;
+  if (x1 > width) x1 = width;
+  if (y1 > height) y1 = height;
+
+  if (x0 >= x1 || y0 >= y1) {
+    memset(rgb, 0, 3);
+    return false;
+  }
+
+  int w = x1 - x0;
+  uint32_t count = (uint32_t)w * (y1 - y0);
+
+  if (mode == SAMPLE_POINT || mode == SAMPLE_MEAN) {
+    uint32_t sum[4] = {};
+    for (int y = y0; y < y1; y++) {
+      sumRow.fn(bgra + ((size_t)y * width + x0) * 4, w, sum);
+    }
+    for (int c = 0; c < 3; c++) {
+      rgb[c] = (unsigned char)((sum[2 - c] + count / 2) / count);
+    }
+    return true;
+  }
+
+  //? 中位数和截尾平均都走计数直方图，O(N*N + 256)，比排序快得多
+  uint32_t hist[3][256];
+  memset(hist, 0, sizeof(hist));
+  for (int y = y0; y < y1; y++) {
+    const unsigned char* p = bgra + ((size_t)y * width + x0) * 4;
+    for (int x = 0; x < w; x++, p += 4) {
+      hist[0][p[2]]++;
+      hist[1][p[1]]++;
+      hist[2][p[0]]++;
+    }
+  }
+
+  for (int c = 0; c < 3; c++) {
+    if (mode == SAMPLE_MEDIAN) {
+      rgb[c] = (unsigned char)HistogramNth(hist[c], (count - 1) / 2);
+    } else {
+      uint32_t trim = count / 4;
+      rgb[c] = (unsigned char)HistogramRangeMean(hist[c], trim, count - trim);
+    }
+  }
+  return true;
+}
+
+//& >>>>>>>>>>>> 区域统计
+
+namespace {
+
+//? 每个分片自己的累加器，最后合并，避免线程间写同一块内存
+//? bin 按 B G R 之和、像素数排成 4 个 uint32，和拆开的 BGRA 像素对齐，
+//? 一次 16 字节的加法就能更新一个 bin
+struct RegionPart {
+  uint32_t histogram[3][256];
+  uint32_t bins[REGION_QUANT_BINS][4];
+};
+
+// 一个分片里单个 bin 的 uint32 求和不能溢出: 255 * 像素数 < 2^32
+const uint32_t REGION_PART_MAX_PIXELS = 1u << 23;
+
+struct ColorBin {
+  uint16_t q[3];  // 量化坐标 R G B
+  uint32_t count;
+  uint64_t sum[3];
+};
+
+struct ColorBox {
+  int begin, end;  // bins 里的下标区间
+  uint64_t count;
+};
+
+inline uint32_t QuantIndex(uint32_t bgra) {
+  const int shift = 8 - REGION_QUANT_BITS;
+  const uint32_t mask = (1u << REGION_QUANT_BITS) - 1;
+  uint32_t r = (bgra >> (16 + shift)) & mask;
+  uint32_t g = (bgra >> (8 + shift)) & mask;
+  uint32_t b = (bgra >> shift) & mask;
+  return (r << (REGION_QUANT_BITS * 2)) | (g << REGION_QUANT_BITS) | b;
+}
+
+//? 从 i 开始和 px[i] 相同的像素有几个
+inline int RunLength(const uint32_t* px, int i, int count) {
+  uint32_t value = px[i];
+  int end = i + 1;
+#ifdef __SSE2__
+  const __m128i v = _mm_set1_epi32((int)value);
+  while (end + 4 <= count) {
+    __m128i p = _mm_loadu_si128((const __m128i*)(px + end));
+    int mask = _mm_movemask_epi8(_mm_cmpeq_epi32(p, v));
+    if (mask != 0xffff) {
+      // 第一个不同的像素
+      end += __builtin_ctz(~mask) / 4;
+      return end - i;
+    }
+    end += 4;
+  }
+#endif
+  while (end < count && px[end] == value) end++;
+  return end - i;
+}
+
+//? 截图里大片纯色很多，连续相同的像素合成一段，整段只更新一次直方图和 bin
+void AccumulateRow(const unsigned char* row, int count, RegionPart& part) {
+  const uint32_t* px = (const uint32_t*)row;
+#ifdef __SSE2__
+  const __m128i zero = _mm_setzero_si128();
+  // alpha 通道换成 1，加到 bin 上就是像素数
+  const __m128i alphaMask = _mm_set_epi32(0, -1, -1, -1);
+  const __m128i one = _mm_set_epi32(1, 0, 0, 0);
+#endif
+  int i = 0;
+  while (i < count) {
+    const unsigned char* c = row + i * 4;
+    uint32_t* bin = part.bins[QuantIndex(px[i])];
+    // 噪声一样的区域几乎没有相同的邻居，这里一次比较就走单像素的路径
+    if (i + 1 < count && px[i + 1] == px[i]) {
+      uint32_t run = (uint32_t)RunLength(px, i, count);
+      bin[0] += c[0] * run;
+      bin[1] += c[1] * run;
+      bin[2] += c[2] * run;
+      bin[3] += run;
+      part.histogram[0][c[2]] += run;
+      part.histogram[1][c[1]] += run;
+      part.histogram[2][c[0]] += run;
+      i += run;
+      continue;
+    }
+#ifdef __SSE2__
+    __m128i p = _mm_cvtsi32_si128((int)px[i]);
+    p = _mm_unpacklo_epi16(_mm_unpacklo_epi8(p, zero), zero);
+    p = _mm_or_si128(_mm_and_si128(p, alphaMask), one);
+    __m128i sum = _mm_loadu_si128((const __m128i*)bin);
+    _mm_storeu_si128((__m128i*)bin, _mm_add_epi32(sum, p));
+#else
+    bin[0] += c[0];
+    bin[1] += c[1];
+    bin[2] += c[2];
+    bin[3]++;
+#endif
+    part.histogram[0][c[2]]++;
+    part.histogram[1][c[1]]++;
+    part.histogram[2][c[0]]++;
+    i++;
+  }
+}
+
+//? 把 box 沿跨度最大的通道在加权中位数处一分为二
+bool SplitBox(std::vector<ColorBin>& bins, ColorBox& box, ColorBox& rest) {
+  if (box.end - box.begin < 2) return false;
+
+  int lo[3] = {65535, 65535, 65535}, hi[3] = {0, 0, 0};
+  for (int i = box.begin; i < box.end; i++) {
+    for (int c = 0; c < 3; c++) {
+      lo[c] = std::min(lo[c], (int)bins[i].q[c]);
+      hi[c] = std::max(hi[c], (int)bins[i].q[c]);
+    }
+  }
+  int axis = 0;
+  for (int c = 1; c < 3; c++) {
+    if (hi[c] - lo[c] > hi[axis] - lo[axis]) axis = c;
+  }
+  if (hi[axis] == lo[axis]) return false;
+
+  std::sort(bins.begin() + box.begin, bins.begin() + box.end,
+            [axis](const ColorBin& a, const ColorBin& b) {
+              return a.q[axis] < b.q[axis];
+            });
+
+  uint64_t half = box.count / 2;
+  uint64_t acc = 0;
+  int mid = box.begin;
+  while (mid < box.end - 1 && acc + bins[mid].count <= half) {
+    acc += bins[mid].count;
+    mid++;
+  }
+  if (mid == box.begin) {
+    acc += bins[mid].count;
+    mid++;
+  }
+
+  rest.begin = mid;
+  rest.end = box.end;
+  rest.count = box.count - acc;
+  box.end = mid;
+  box.count = acc;
+  return true;
+}
+
+}  // namespace
+
+bool ComputeRegionStats(const unsigned char* bgra, int width, int height,
+                        int x0, int y0, int x1, int y1, RegionStats& stats) {
+  memset(&stats, 0, sizeof(stats));
+  if (x0 > x1) std::swap(x0, x1);
+  if (y0 > y1) std::swap(y0, y1);
+  x0 = std::max(x0, 0);
+  y0 = std::max(y0, 0);
+  x1 = std::min(x1, width);
+  y1 = std::min(y1, height);
+  if (x0 >= x1 || y0 >= y1) return false;
+
+  int w = x1 - x0;
+  int rows = y1 - y0;
+  stats.x = x0;
+  stats.y = height - y1;  // bgra 自下而上
+  stats.width = w;
+  stats.height = rows;
+  stats.count = (uint32_t)w * rows;
+
+  //? 分片数 >= 线程数；单片像素过多时再细分，保证 bin 求和不溢出
+  int parts = ParallelWorkerCount();
+  int minParts = (int)((stats.count + REGION_PART_MAX_PIXELS - 1) /
+                       REGION_PART_MAX_PIXELS);
+  parts = std::max(parts, minParts);
+  parts = std::min(parts, rows);
+
+  std::unique_ptr<RegionPart[]> partial(new RegionPart[parts]);
+  ParallelFor(0, parts, [&](int begin, int end) {
+    for (int p = begin; p < end; p++) {
+      RegionPart& part = partial[p];
+      memset(&part, 0, sizeof(part));
+      int r0 = y0 + (int)((int64_t)rows * p / parts);
+      int r1 = y0 + (int)((int64_t)rows * (p + 1) / parts);
+      for (int y = r0; y < r1; y++) {
+        AccumulateRow(bgra + ((size_t)y * width + x0) * 4, w, part);
+      }
+    }
+  });
+
+  //& 合并
+  std::vector<ColorBin> bins;
+  for (uint32_t q = 0; q < REGION_QUANT_BINS; q++) {
+    ColorBin bin = {};
+    for (int p = 0; p < parts; p++) {
+      const uint32_t* sum = partial[p].bins[q];
+      bin.count += sum[3];
+      for (int c = 0; c < 3; c++) bin.sum[c] += sum[2 - c];
+    }
+    if (bin.count == 0) continue;
+    bin.q[0] = (uint16_t)(q >> (REGION_QUANT_BITS * 2));
+    const uint32_t mask = (1u << REGION_QUANT_BITS) - 1;
+    bin.q[1] = (uint16_t)((q >> REGION_QUANT_BITS) & mask);
+    bin.q[2] = (uint16_t)(q & mask);
+    bins.push_back(bin);
+  }
+  for (int p = 0; p < parts; p++) {
+    for (int c = 0; c < 3; c++) {
+      for (int v = 0; v < 256; v++) {
+        stats.histogram[c][v] += partial[p].histogram[c][v];
+      }
+    }
+  }
+
+  //& 均值和方差直接从直方图算
+  for (int c = 0; c < 3; c++) {
+    double sum = 0, sq = 0;
+    for (int v = 0; v < 256; v++) {
+      sum += (double)v * stats.histogram[c][v];
+      sq += (double)v * v * stats.histogram[c][v];
+    }
+    double mean = sum / stats.count;
+    double var = sq / stats.count - mean * mean;
+    stats.mean[c] = (float)mean;
+    stats.stddev[c] = (float)sqrt(var > 0 ? var : 0);
+  }
+
+  //& median cut: 先切成较多的箱子，再按像素数取前 k 个作为主色
+  const int boxLimit = REGION_TOP_K * 4;
+  std::vector<ColorBox> boxes;
+  boxes.push_back({0, (int)bins.size(), stats.count});
+  while ((int)boxes.size() < boxLimit) {
+    // 总是切像素最多且还能切的那个
+    int pick = -1;
+    for (int i = 0; i < (int)boxes.size(); i++) {
+      if (boxes[i].end - boxes[i].begin < 2) continue;
+      if (pick < 0 || boxes[i].count > boxes[pick].count) pick = i;
+    }
+    if (pick < 0) break;
+    ColorBox rest;
+    if (!SplitBox(bins, boxes[pick], rest)) {
+      // 所有 bin 同一坐标，标记为不可再分
+      boxes[pick].end = boxes[pick].begin + 1;
+      continue;
+    }
+    boxes.push_back(rest);
+  }
+
+  std::sort(boxes.begin(), boxes.end(),
+            [](const ColorBox& a, const ColorBox& b) {
+              return a.count > b.count;
+            });
+
+  for (const ColorBox& box : boxes) {
+    if (stats.dominantCount == REGION_TOP_K || box.count == 0) break;
+    // 箱子的平均色会被混进来的杂色拉偏，取箱子里最重的 bin 的均值作为代表
+    const ColorBin* peak = &bins[box.begin];
+    for (int i = box.begin + 1; i < box.end; i++) {
+      if (bins[i].count > peak->count) peak = &bins[i];
+    }
+    int k = stats.dominantCount++;
+    for (int c = 0; c < 3; c++) {
+      stats.dominant[k][c] =
+          (unsigned char)((peak->sum[c] + peak->count / 2) / peak->count);
+    }
+    stats.dominantShare[k] = (float)box.count / stats.count;
+  }
+  return true;
+}
+
+int FormatRegionStats(const RegionStats& stats, char* buf, size_t size) {
+  int n = snprintf(buf, size,
+                   "region: x=%d y=%d w=%d h=%d pixels=%u\n"
+                   "mean: %.1f %.1f %.1f\n"
+                   "stddev: %.1f %.1f %.1f\n",
+                   stats.x, stats.y, stats.width, stats.height, stats.count,
+                   stats.mean[0], stats.mean[1], stats.mean[2],
+                   stats.stddev[0], stats.stddev[1], stats.stddev[2]);
+  for (int k = 0; k < stats.dominantCount && n >= 0 && (size_t)n < size; k++) {
+    const unsigned char* c = stats.dominant[k];
+    n += snprintf(buf + n, size - n, "dominant %d: #%02X%02X%02X %.1f%%\n",
+                  k + 1, c[0], c[1], c[2], stats.dominantShare[k] * 100.0f);
+  }
+  if (n < 0) return 0;
+  return (size_t)n < size ? n : (int)size - 1;
+}
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+//& 取色采样: 在截图 (BGRA) 上按区域取一个代表色
+
+enum SampleMode {
+  SAMPLE_POINT,    // 单个像素
+  SAMPLE_MEAN,     // N x N 平均
+  SAMPLE_MEDIAN,   // N x N 逐通道中位数
+  SAMPLE_TRIMMED,  // N x N 去掉两端各 1/4 后的平均
+  SAMPLE_MODE_COUNT
+};
+
+#define SAMPLE_MIN_SIZE 3
+#define SAMPLE_MAX_SIZE 64
+
+const char* SampleModeName(SampleMode mode);
+
+//? (cx, cy) 是区域中心在图像里的坐标，区域超出图像的部分会被裁掉
+//? rgb 输出 R G B; 区域完全在图像外时返回 false, rgb 置 0
+bool SampleArea(const unsigned char* bgra, int width, int height, int cx,
+                int cy, int size, SampleMode mode, unsigned char rgb[3]);
+
+//? 求和内核在启动时按 CPU 选择 ("AVX2" / "SSE2" / "scalar")，给基准打印用
+const char* SampleKernelName();
+
+//& 区域统计: 框选一块截图，算直方图、均值方差和主色
+
+#define REGION_TOP_K 5
+#define REGION_QUANT_BITS 5  // 主色聚类用的 3D 直方图每通道位数
+#define REGION_QUANT_BINS (1 << (REGION_QUANT_BITS * 3))
+
+struct RegionStats {
+  int x, y, width, height;  // 图像坐标，y 自上而下
+  uint32_t count;
+  uint32_t histogram[3][256];  // R G B 各自的直方图
+  float mean[3];
+  float stddev[3];
+  int dominantCount;
+  unsigned char dominant[REGION_TOP_K][3];
+  float dominantShare[REGION_TOP_K];  // 占比 0~1
+};
+
+//? [x0, x1) x [y0, y1) 是 bgra 里的行列 (行序和 bgra 一致)，会裁到图像内
+//? 按行切给线程池；主色用量化后的 3D 直方图做 median cut
+bool ComputeRegionStats(const unsigned char* bgra, int width, int height,
+                        int x0, int y0, int x1, int y1, RegionStats& stats);
+
+//? 导出成多行文本，返回写入的长度 (不含结尾的 0)
+int FormatRegionStats(const RegionStats& stats, char* buf, size_t size);
@@ -0,0 +1,72 @@
+#pragma once
+
+#include <string>
+
+//& 平台层: 窗口、输入、OpenGL 上下文、截图、剪贴板
+//? main.cpp 是和平台无关的核心，只通过这里和系统打交道
+//? platform_win32.cpp / platform_x11.cpp / platform_egl.cpp 各实现一份
+//? Platform* 并提供入口，再把窗口消息 (或脚本化的输入) 翻译成下面的 App* 调用
+
+//& >>>>>>>>>>>> 核心 (main.cpp) 提供，平台层调用
+#define APP_KEY_ESCAPE 27
+
+enum AppButton { APP_BUTTON_LEFT, APP_BUTTON_RIGHT };
+
+//? 一个输出是一台显示器上的一个窗口，矩形是桌面坐标:
+//? 以虚拟桌面 (也就是截图) 的左上角为原点，y 向下
+struct AppOutput {
+  int x, y, width, height;
+};
+
+//? width / height 是截图 (整个虚拟桌面) 的尺寸，outputs 是各显示器，
+//? 第 0 个是主显示器，HUD 画在它上面；建不出 3.3 的上下文或 forceSoftware
+//? 时用软件渲染。失败时已经报过错，返回 false
+bool AppInit(int width, int height, const AppOutput* outputs, int outputCount,
+             bool forceSoftware);
+void AppShutdown();
+//? 每个输出按自己显示器的刷新率调: 场景推进到 seconds (单调递增)，
+//? 再画 output 这个输出并呈现。调之前平台层已经把它的窗口设为当前
+void AppFrame(int output, double seconds);
+
+//? key 是大写字母、'[' ']' 或 APP_KEY_ESCAPE，其他键不用传
+void AppKeyUp(int key);
+//? 桌面坐标，y 向下
+void AppMouseButton(AppButton button, bool down, int x, int y);
+//? delta 和 WM_MOUSEWHEEL 一样，一格是 120
+void AppMouseWheel(int delta, bool shift, bool control);
+
+//& >>>>>>>>>>>> 平台层提供，核心调用
+//? 所有输出共用一个 OpenGL 上下文 (纹理、buffer、shader 都只有一份)，
+//? 建好后对第 0 个输出设为当前，之后核心自己 LoadGL
+bool PlatformCreateContext();
+void PlatformDestroyContext();
+//? 呈现当前输出
+void PlatformSwapBuffers();
+//? 核心用它加载所有 GL 函数 (glload.h)，1.1 的也要能取到
+void* PlatformGetProcAddress(const char* name);
+//? 核心画到这个 framebuffer: 窗口的是 0，无窗口的后端是当前输出的 FBO
+unsigned int PlatformFramebuffer();
+
+//? 软件渲染的目标: 整个桌面大小，返回第 0 行 (最下面一行) 的地址，
+//? pitch 是行距字节数，自上而下的缓冲就是负数；像素是 BGRA
+//? 每帧只画当前输出的矩形，PlatformPresentSoftware 也只呈现这一块
+unsigned char* PlatformCreateSoftwareTarget(int width, int height,
+                                            int* pitch);
+void PlatformDestroySoftwareTarget();
+void PlatformPresentSoftware();
+
+//? 整个屏幕，new[] 出来的 BGRA，自下而上的行序；alpha 要是 255，
+//? 截图是混合着画的
+unsigned char* PlatformCaptureScreen(int width, int height);
+//? 截完图马上调: 显示所有窗口并把截图原样贴上去 (不经过 GL，第一帧之前先顶着)
+//? 相机初始是单位变换，看起来和第一帧一样
+void PlatformShowCapture(const unsigned char* pixels, int width, int height);
+
+//? 光标的桌面坐标，y 向下
+void PlatformGetCursor(int* x, int* y);
+bool PlatformCopyText(const char* text);
+void PlatformShowError(const char* title, const char* message);
+//? 可执行文件所在的目录，不带结尾的分隔符
+std::string PlatformExeDir();
+//? 处理完当前消息后退出，退出前会调 AppShutdown
+void PlatformQuit();
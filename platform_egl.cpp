@@ -0,0 +1,493 @@
+#include <limits.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <string>
+#include <vector>
+
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+
+#include "glload.h"
+#include "platform.h"
+#include "trace.h"
+
+//& 无窗口的 EGL 后端，给自动化的性能测试用
+//? 用 EGL_MESA_platform_surfaceless (没有就退回默认 display + pbuffer)
+//? 建上下文，画进自己的 FBO；核心和交互版本是同一份 main.cpp，
+//? 画面、文字、手电筒走的都是发布的代码
+//? 截图换成 --image 指定的 BMP 或者生成的测试图，输入是脚本化的:
+//? 光标绕屏幕中心转圈，--keys 和 --wheel 在第一帧前发出去
+//? 每帧不等待，连续跑 --frames 帧，结束时把帧时间统计打印到 stdout
+//? --monitors N 把桌面横着切成 N 台显示器，第 0 台 144Hz、其余 60Hz，
+//? 时间是模拟的: 每次挑最早到期的输出画一帧，和真机的节奏一样
+
+#define PRIMARY_REFRESH_HZ 144.0
+#define SECONDARY_REFRESH_HZ 60.0
+
+EGLDisplay eglDisplay = EGL_NO_DISPLAY;
+EGLContext eglContext = EGL_NO_CONTEXT;
+EGLSurface eglSurface = EGL_NO_SURFACE;
+
+//? 每个输出一个 FBO，当前输出的由 PlatformFramebuffer 交给核心
+struct Monitor {
+  AppOutput rect;
+  double period;  // 秒
+  double next;    // 下一帧到期的模拟时间
+  int frames;
+  GLuint fbo, color;
+};
+std::vector<Monitor> monitors;
+int currentMonitor;
+
+int targetWidth = 1920, targetHeight = 1080;
+unsigned char* sourceImage;  // --image 读进来的，自下而上 BGRA
+int frameIndex, frameCount = 120;
+const char* dumpDir;
+bool running = true;
+
+//? 软件渲染直接画进内存，呈现就是什么都不做
+std::vector<unsigned char> softTarget;
+std::vector<unsigned char> readback;
+
+//? 32 位自下而上的 BMP，和 DIB / 截图的内存布局一样，可以直接写
+bool WriteBmp(const char* path, const unsigned char* pixels, int width,
+              int height) {
+  FILE* f = fopen(path, "wb");
+  if (!f) return false;
+  unsigned int imageSize = (unsigned int)width * height * 4;
+  unsigned char header[54] = {'B', 'M'};
+  auto put32 = [&](int offset, unsigned int v) {
+    for (int i = 0; i < 4; i++) header[offset + i] = (v >> (i * 8)) & 0xff;
+  };
+  put32(2, 54 + imageSize);
+  put32(10, 54);
+  put32(14, 40);
+  put32(18, width);
+  put32(22, height);
+  header[26] = 1;   // planes
+  header[28] = 32;  // bits per pixel
+  put32(34, imageSize);
+  bool ok = fwrite(header, 1, sizeof(header), f) == sizeof(header) &&
+            fwrite(pixels, 1, imageSize, f) == imageSize;
+  fclose(f);
+  return ok;
+}
+
+//? 只认未压缩的 24 / 32 位 BMP，转成自下而上的 BGRA，alpha 补成 255
+unsigned char* ReadBmp(const char* path, int* width, int* height) {
+  FILE* f = fopen(path, "rb");
+  if (!f) return nullptr;
+  unsigned char header[54];
+  unsigned char* pixels = nullptr;
+  if (fread(header, 1, sizeof(header), f) == sizeof(header) &&
+      header[0] == 'B' && header[1] == 'M') {
+    auto get32 = [&](int offset) {
+      return (int)(header[offset] | header[offset + 1] << 8 |
+                   header[offset + 2] << 16 | header[offset + 3] << 24);
+    };
+    int offset = get32(10);
+    int w = get32(18);
+    int h = get32(22);
+    int bpp = header[28];
+    int compression = get32(30);
+    bool topDown = h < 0;
+    h = abs(h);
+    if (w > 0 && h > 0 && (bpp == 24 || bpp == 32) && compression == 0) {
+      int stride = (w * (bpp / 8) + 3) & ~3;
+      std::vector<unsigned char> row(stride);
+      pixels = new unsigned char[(size_t)w * h * 4];
+      fseek(f, offset, SEEK_SET);
+      for (int y = 0; y < h; y++) {
+        if (fread(row.data(), 1, stride, f) != (size_t)stride) {
+          delete[] pixels;
+          pixels = nullptr;
+          break;
+        }
+        int dstY = topDown ? h - 1 - y : y;
+        unsigned char* dst = pixels + (size_t)dstY * w * 4;
+        for (int x = 0; x < w; x++) {
+          memcpy(dst + x * 4, row.data() + x * (bpp / 8), 3);
+          dst[x * 4 + 3] = 255;
+        }
+      }
+      *width = w;
+      *height = h;
+    }
+  }
+  fclose(f);
+  return pixels;
+}
+
+//? 没给图片时的测试图: 两个方向的渐变上叠一层 8px 棋盘格，
+//? 缩放和过滤都有细节可看，每次生成的都一样
+void FillTestPattern(unsigned char* pixels, int width, int height) {
+  for (int y = 0; y < height; y++) {
+    unsigned char* row = pixels + (size_t)y * width * 4;
+    for (int x = 0; x < width; x++) {
+      row[x * 4 + 0] = (unsigned char)(x * 255 / std::max(width - 1, 1));
+      row[x * 4 + 1] = (unsigned char)(y * 255 / std::max(height - 1, 1));
+      row[x * 4 + 2] = ((x / 8 + y / 8) & 1) ? 220 : 30;
+      row[x * 4 + 3] = 255;
+    }
+  }
+}
+
+void PrintUsage() {
+  fprintf(stderr,
+          "usage: colorpicker-headless [--software] [--trace-startup] "
+          "[--frames N] [--size WxH] [--monitors N] [--image file.bmp] "
+          "[--dump dir] [--keys FMP...] [--wheel N]\n");
+}
+
+int main(int argc, char** argv) {
+  bool forceSoftware = false;
+  const char* imagePath = nullptr;
+  const char* keys = "";
+  int wheel = 0;
+  int monitorCount = 1;
+  for (int i = 1; i < argc; i++) {
+    const char* arg = argv[i];
+    const char* value = i + 1 < argc ? argv[i + 1] : nullptr;
+    if (strcmp(arg, "--software") == 0) {
+      forceSoftware = true;
+      continue;
+    }
+    if (strcmp(arg, "--trace-startup") == 0) {
+      StartupTraceBegin();
+      continue;
+    }
+    if (value == nullptr) {
+      PrintUsage();
+      return 1;
+    }
+    i++;
+    if (strcmp(arg, "--frames") == 0) {
+      frameCount = atoi(value);
+    } else if (strcmp(arg, "--size") == 0) {
+      if (sscanf(value, "%dx%d", &targetWidth, &targetHeight) != 2) {
+        PrintUsage();
+        return 1;
+      }
+    } else if (strcmp(arg, "--monitors") == 0) {
+      monitorCount = atoi(value);
+    } else if (strcmp(arg, "--image") == 0) {
+      imagePath = value;
+    } else if (strcmp(arg, "--dump") == 0) {
+      dumpDir = value;
+    } else if (strcmp(arg, "--keys") == 0) {
+      keys = value;
+    } else if (strcmp(arg, "--wheel") == 0) {
+      wheel = atoi(value);
+    } else {
+      PrintUsage();
+      return 1;
+    }
+  }
+
+  if (imagePath) {
+    sourceImage = ReadBmp(imagePath, &targetWidth, &targetHeight);
+    if (!sourceImage) {
+      PlatformShowError("Error", "failed to read image");
+      return 1;
+    }
+  }
+  if (targetWidth <= 0 || targetHeight <= 0 || frameCount <= 0 ||
+      monitorCount <= 0 || monitorCount > targetWidth) {
+    PrintUsage();
+    return 1;
+  }
+
+  //? 只有一个输出时按 60Hz 走，和以前固定步长的结果一样
+  std::vector<AppOutput> rects;
+  for (int i = 0; i < monitorCount; i++) {
+    Monitor monitor = {};
+    int x0 = targetWidth * i / monitorCount;
+    int x1 = targetWidth * (i + 1) / monitorCount;
+    monitor.rect = {x0, 0, x1 - x0, targetHeight};
+    monitor.period = 1.0 / (i == 0 && monitorCount > 1 ? PRIMARY_REFRESH_HZ
+                                                     : SECONDARY_REFRESH_HZ);
+    monitors.push_back(monitor);
+    rects.push_back(monitor.rect);
+  }
+
+  if (!AppInit(targetWidth, targetHeight, rects.data(), monitorCount,
+               forceSoftware)) {
+    return 1;
+  }
+
+  for (const char* k = keys; *k; k++) {
+    int key = *k >= 'a' && *k <= 'z' ? *k - 'a' + 'A' : *k;
+    AppKeyUp(key);
+  }
+  for (int i = 0; i < abs(wheel); i++) {
+    AppMouseWheel(wheel > 0 ? 120 : -120, false, false);
+  }
+
+  std::vector<float> frameMs;
+  frameMs.reserve(frameCount);
+  auto start = std::chrono::steady_clock::now();
+  for (frameIndex = 0; frameIndex < frameCount && running; frameIndex++) {
+    currentMonitor = 0;
+    for (int i = 1; i < monitorCount; i++) {
+      if (monitors[i].next < monitors[currentMonitor].next) currentMonitor = i;
+    }
+    Monitor& monitor = monitors[currentMonitor];
+    double seconds = monitor.next;
+    monitor.next += monitor.period;
+    monitor.frames++;
+
+    auto t0 = std::chrono::steady_clock::now();
+    AppFrame(currentMonitor, seconds);
+    std::chrono::duration<float, std::milli> t =
+        std::chrono::steady_clock::now() - t0;
+    frameMs.push_back(t.count());
+  }
+  std::chrono::duration<float, std::milli> total =
+      std::chrono::steady_clock::now() - start;
+
+  //? 转圈时手电筒和取色每帧都在变，第一帧还包含 mip 的上传，所以看分位数
+  std::vector<float> sorted = frameMs;
+  std::sort(sorted.begin(), sorted.end());
+  auto percentile = [&](float p) {
+    return sorted[std::min((size_t)(p * sorted.size()), sorted.size() - 1)];
+  };
+  printf("renderer: %s\n", eglContext != EGL_NO_CONTEXT ? "gl" : "software");
+  printf("size: %dx%d frames: %d\n", targetWidth, targetHeight,
+         (int)frameMs.size());
+  printf("frame ms: mean %.3f p50 %.3f p95 %.3f max %.3f first %.3f\n",
+         total.count() / frameMs.size(), percentile(0.5f), percentile(0.95f),
+         sorted.back(), frameMs[0]);
+  if (monitorCount > 1) {
+    for (int i = 0; i < monitorCount; i++) {
+      const Monitor& monitor = monitors[i];
+      printf("output %d: %dx%d at %d,%d %.0fHz frames %d\n", i,
+             monitor.rect.width, monitor.rect.height, monitor.rect.x,
+             monitor.rect.y, 1.0 / monitor.period, monitor.frames);
+    }
+  }
+
+  AppShutdown();
+  delete[] sourceImage;
+  return 0;
+}
+
+//? 先要 surfaceless 平台；没有的话默认 display 也行，只是要一个 pbuffer 才能
+//? make current
+bool CreateEglContext() {
+  auto getPlatformDisplay =
+      (PFNEGLGETPLATFORMDISPLAYEXTPROC)eglGetProcAddress(
+          "eglGetPlatformDisplayEXT");
+  if (getPlatformDisplay) {
+    eglDisplay = getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA,
+                                    EGL_DEFAULT_DISPLAY, nullptr);
+  }
+  if (eglDisplay == EGL_NO_DISPLAY) {
+    eglDisplay = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+  }
+  if (eglDisplay == EGL_NO_DISPLAY ||
+      !eglInitialize(eglDisplay, nullptr, nullptr)) {
+    return false;
+  }
+  if (!eglBindAPI(EGL_OPENGL_API)) return false;
+
+  const EGLint configAttribs[] = {EGL_SURFACE_TYPE,
+                                  EGL_PBUFFER_BIT,
+                                  EGL_RENDERABLE_TYPE,
+                                  EGL_OPENGL_BIT,
+                                  EGL_RED_SIZE,
+                                  8,
+                                  EGL_GREEN_SIZE,
+                                  8,
+                                  EGL_BLUE_SIZE,
+                                  8,
+                                  EGL_NONE};
+  EGLConfig config = EGL_NO_CONFIG_KHR;
+  EGLint count = 0;
+  if (!eglChooseConfig(eglDisplay, configAttribs, &config, 1, &count) ||
+      count == 0) {
+    config = EGL_NO_CONFIG_KHR;  // 需要 EGL_KHR_no_config_context
+  }
+
+  const EGLint contextAttribs[] = {EGL_CONTEXT_MAJOR_VERSION,
+                                   3,
+                                   EGL_CONTEXT_MINOR_VERSION,
+                                   3,
+                                   EGL_CONTEXT_OPENGL_PROFILE_MASK,
+                                   EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+                                   EGL_NONE};
+  eglContext =
+      eglCreateContext(eglDisplay, config, EGL_NO_CONTEXT, contextAttribs);
+  if (eglContext == EGL_NO_CONTEXT) return false;
+
+  if (eglMakeCurrent(eglDisplay, EGL_NO_SURFACE, EGL_NO_SURFACE,
+                     eglContext)) {
+    return true;
+  }
+  if (config == EGL_NO_CONFIG_KHR) return false;
+  const EGLint pbufferAttribs[] = {EGL_WIDTH, 1, EGL_HEIGHT, 1, EGL_NONE};
+  eglSurface = eglCreatePbufferSurface(eglDisplay, config, pbufferAttribs);
+  return eglSurface != EGL_NO_SURFACE &&
+         eglMakeCurrent(eglDisplay, eglSurface, eglSurface, eglContext);
+}
+
+bool PlatformCreateContext() {
+  if (!CreateEglContext()) {
+    PlatformDestroyContext();
+    return false;
+  }
+  //? 核心加载之前就要建 FBO，这里先自己加载一遍，两边拿到的是同一套函数
+  if (!LoadGL(PlatformGetProcAddress, 3, 3)) {
+    PlatformDestroyContext();
+    return false;
+  }
+  for (Monitor& monitor : monitors) {
+    glGenRenderbuffers(1, &monitor.color);
+    glBindRenderbuffer(GL_RENDERBUFFER, monitor.color);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, monitor.rect.width,
+                          monitor.rect.height);
+    glGenFramebuffers(1, &monitor.fbo);
+    glBindFramebuffer(GL_FRAMEBUFFER, monitor.fbo);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0,
+                              GL_RENDERBUFFER, monitor.color);
+    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+      PlatformDestroyContext();
+      return false;
+    }
+  }
+  StartupTraceMark("context + fbo");
+  return true;
+}
+
+void PlatformDestroyContext() {
+  if (eglContext != EGL_NO_CONTEXT) {
+    for (Monitor& monitor : monitors) {
+      if (monitor.fbo) glDeleteFramebuffers(1, &monitor.fbo);
+      if (monitor.color) glDeleteRenderbuffers(1, &monitor.color);
+      monitor.fbo = monitor.color = 0;
+    }
+  }
+  if (eglDisplay == EGL_NO_DISPLAY) return;
+  eglMakeCurrent(eglDisplay, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+  if (eglSurface != EGL_NO_SURFACE) eglDestroySurface(eglDisplay, eglSurface);
+  if (eglContext != EGL_NO_CONTEXT) eglDestroyContext(eglDisplay, eglContext);
+  eglTerminate(eglDisplay);
+  eglSurface = EGL_NO_SURFACE;
+  eglContext = EGL_NO_CONTEXT;
+  eglDisplay = EGL_NO_DISPLAY;
+}
+
+//? 当前输出的一帧；多个输出时文件名带上输出的序号
+void DumpFrame(const unsigned char* pixels) {
+  if (!dumpDir) return;
+  const AppOutput& rect = monitors[currentMonitor].rect;
+  char path[PATH_MAX];
+  if (monitors.size() > 1) {
+    snprintf(path, sizeof(path), "%s/frame_%04d_%d.bmp", dumpDir, frameIndex,
+             currentMonitor);
+  } else {
+    snprintf(path, sizeof(path), "%s/frame_%04d.bmp", dumpDir, frameIndex);
+  }
+  if (!WriteBmp(path, pixels, rect.width, rect.height)) {
+    PlatformShowError("Error", "failed to write frame");
+    running = false;
+  }
+}
+
+//? 没有交换链，glFinish 代替 SwapBuffers 的同步，帧时间才包含 GPU 的部分
+void PlatformSwapBuffers() {
+  if (dumpDir) {
+    const Monitor& monitor = monitors[currentMonitor];
+    readback.resize((size_t)monitor.rect.width * monitor.rect.height * 4);
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, monitor.fbo);
+    glPixelStorei(GL_PACK_ALIGNMENT, 4);
+    glReadPixels(0, 0, monitor.rect.width, monitor.rect.height, GL_BGRA,
+                 GL_UNSIGNED_BYTE, readback.data());
+    DumpFrame(readback.data());
+  } else {
+    glFinish();
+  }
+}
+
+void* PlatformGetProcAddress(const char* name) {
+  return (void*)eglGetProcAddress(name);
+}
+
+unsigned int PlatformFramebuffer() { return monitors[currentMonitor].fbo; }
+
+unsigned char* PlatformCreateSoftwareTarget(int width, int height,
+                                            int* pitch) {
+  softTarget.assign((size_t)width * height * 4, 0);
+  *pitch = width * 4;
+  return softTarget.data();
+}
+
+void PlatformDestroySoftwareTarget() {
+  softTarget.clear();
+  softTarget.shrink_to_fit();
+}
+
+//? 从整个桌面的缓冲里切出当前输出 (自下而上，所以从下边开始数)
+void PlatformPresentSoftware() {
+  if (!dumpDir) return;
+  const AppOutput& rect = monitors[currentMonitor].rect;
+  if (monitors.size() == 1) {
+    DumpFrame(softTarget.data());
+    return;
+  }
+  readback.resize((size_t)rect.width * rect.height * 4);
+  int bottom = targetHeight - rect.y - rect.height;
+  for (int y = 0; y < rect.height; y++) {
+    memcpy(&readback[(size_t)y * rect.width * 4],
+           &softTarget[((size_t)(bottom + y) * targetWidth + rect.x) * 4],
+           (size_t)rect.width * 4);
+  }
+  DumpFrame(readback.data());
+}
+
+unsigned char* PlatformCaptureScreen(int width, int height) {
+  unsigned char* data = new unsigned char[(size_t)width * height * 4];
+  if (sourceImage) {
+    memcpy(data, sourceImage, (size_t)width * height * 4);
+  } else {
+    FillTestPattern(data, width, height);
+  }
+  StartupTraceMark("capture");
+  return data;
+}
+
+//? 没有窗口，不用贴
+void PlatformShowCapture(const unsigned char*, int, int) {}
+
+//? 每 120 帧绕中心转一圈，半径是高度的 1/4
+void PlatformGetCursor(int* x, int* y) {
+  float angle = frameIndex * 2.0f * 3.14159265f / 120.0f;
+  float radius = targetHeight * 0.25f;
+  *x = (int)(targetWidth * 0.5f + radius * cosf(angle));
+  *y = (int)(targetHeight * 0.5f + radius * sinf(angle));
+}
+
+bool PlatformCopyText(const char* text) {
+  printf("clipboard: %s\n", text);
+  return true;
+}
+
+void PlatformShowError(const char* title, const char* message) {
+  fprintf(stderr, "%s: %s\n", title, message);
+}
+
+std::string PlatformExeDir() {
+  char pathBuf[PATH_MAX] = {};
+  if (readlink("/proc/self/exe", pathBuf, sizeof(pathBuf) - 1) <= 0) {
+    return ".";
+  }
+  std::string path(pathBuf);
+  return path.substr(0, path.find_last_of('/'));
+}
+
+void PlatformQuit() { running = false; }
@@ -0,0 +1,474 @@
+#include <cassert>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <windows.h>
+#include <libloaderapi.h>
+#include <tchar.h>
+#include <windowsx.h>
+#include <ShellScalingApi.h>
+#include <timeapi.h>
+
+#include "platform.h"
+#include "trace.h"
+
+#define BUF_SIZE 1024
+#define DEFAULT_REFRESH_HZ 60
+
+const wchar_t WIN_CLASS_NAME[] = _T("WHAT_8MTfo7IzrQ");
+const wchar_t MUTEX_NAME[] = _T("WHAT_1JzKDIayja");
+
+//? 每台显示器一个 WS_POPUP 窗口，而不是一个盖住整个虚拟桌面的大窗口:
+//? 每个交换链只有一台显示器大，144Hz 的主屏也不会被 60Hz 的副屏拖慢
+//? 所有窗口用同一个像素格式，同一个 HGLRC 轮流 make current 到各自的 DC，
+//? 纹理、buffer、shader 和 VAO 只有一份，都在这个线程上
+struct Monitor {
+  AppOutput rect;  // 桌面坐标 (相对虚拟桌面左上角)
+  HWND hwnd;
+  HDC hdc;
+  double period;  // 刷新间隔，秒
+  double next;    // 下一帧的时间
+};
+std::vector<Monitor> monitors;
+int currentMonitor;
+POINT virtualOrigin;  // 虚拟桌面左上角的屏幕坐标，可能是负数
+int showCommand;
+HGLRC g_glrc = NULL;
+
+//? 软件渲染画进 DIB section，每帧 BitBlt 到窗口
+HDC softDC;
+HBITMAP softBitmap;
+int softWidth, softHeight;
+
+LRESULT CALLBACK WindowProc(HWND hwnd, UINT uMsg, WPARAM wParam, LPARAM lParam);
+
+//? 主显示器排在第 0 个，HUD 画在它上面
+BOOL CALLBACK AddMonitor(HMONITOR handle, HDC, LPRECT, LPARAM) {
+  MONITORINFOEXW info = {};
+  info.cbSize = sizeof(info);
+  if (!GetMonitorInfoW(handle, &info)) return TRUE;
+
+  Monitor monitor = {};
+  const RECT& rc = info.rcMonitor;
+  monitor.rect.x = rc.left - virtualOrigin.x;
+  monitor.rect.y = rc.top - virtualOrigin.y;
+  monitor.rect.width = rc.right - rc.left;
+  monitor.rect.height = rc.bottom - rc.top;
+  //? 0 和 1 表示硬件默认的刷新率
+  DEVMODEW mode = {};
+  mode.dmSize = sizeof(mode);
+  int hz = DEFAULT_REFRESH_HZ;
+  if (EnumDisplaySettingsW(info.szDevice, ENUM_CURRENT_SETTINGS, &mode) &&
+      mode.dmDisplayFrequency > 1) {
+    hz = mode.dmDisplayFrequency;
+  }
+  monitor.period = 1.0 / hz;
+
+  if (info.dwFlags & MONITORINFOF_PRIMARY) {
+    monitors.insert(monitors.begin(), monitor);
+  } else {
+    monitors.push_back(monitor);
+  }
+  return TRUE;
+}
+
+double Seconds() {
+  static LARGE_INTEGER frequency = {};
+  if (frequency.QuadPart == 0) QueryPerformanceFrequency(&frequency);
+  LARGE_INTEGER now;
+  QueryPerformanceCounter(&now);
+  return (double)now.QuadPart / frequency.QuadPart;
+}
+
+int MonitorOfWindow(HWND hwnd) {
+  for (size_t i = 0; i < monitors.size(); i++) {
+    if (monitors[i].hwnd == hwnd) return (int)i;
+  }
+  return 0;
+}
+
+int WINAPI wWinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance,
+                    LPWSTR pCmdLine, int nCmdShow) {
+  if (wcsstr(pCmdLine, L"--trace-startup") != NULL) StartupTraceBegin();
+  SetProcessDpiAwareness(PROCESS_PER_MONITOR_DPI_AWARE);
+  StartupTraceMark("dpi awareness");
+  HANDLE hMutex = ::CreateMutex(NULL, TRUE, MUTEX_NAME);
+  if (hMutex != NULL) {
+    if (GetLastError() == ERROR_ALREADY_EXISTS) {
+      HWND handle = FindWindow(WIN_CLASS_NAME, NULL);
+      if (handle != NULL) {
+        ShowWindow(handle, SW_SHOWNORMAL);
+        SetForegroundWindow(handle);
+        return false;
+      }
+    }
+  } else {
+    MessageBoxA(NULL, "failed to execuate program", "Error",
+                MB_OK | MB_ICONERROR);
+    return false;
+  }
+  StartupTraceMark("mutex");
+
+  virtualOrigin.x = GetSystemMetrics(SM_XVIRTUALSCREEN);
+  virtualOrigin.y = GetSystemMetrics(SM_YVIRTUALSCREEN);
+  int virtualWidth = GetSystemMetrics(SM_CXVIRTUALSCREEN);
+  int virtualHeight = GetSystemMetrics(SM_CYVIRTUALSCREEN);
+  EnumDisplayMonitors(NULL, NULL, AddMonitor, 0);
+  if (monitors.empty()) {
+    Monitor monitor = {};
+    monitor.rect = {0, 0, virtualWidth, virtualHeight};
+    monitor.period = 1.0 / DEFAULT_REFRESH_HZ;
+    monitors.push_back(monitor);
+  }
+  StartupTraceMark("monitors");
+
+  WNDCLASSEX wcex;
+  wcex.cbSize = sizeof(wcex);
+  wcex.style = CS_HREDRAW | CS_VREDRAW;
+  wcex.lpfnWndProc = WindowProc;
+  wcex.cbClsExtra = 0;
+  wcex.cbWndExtra = 0;
+  wcex.hInstance = hInstance;
+  wcex.hIcon = LoadIcon(NULL, IDI_APPLICATION);
+  wcex.hCursor = LoadCursor(NULL, IDC_ARROW);
+  wcex.hbrBackground = (HBRUSH)CreateSolidBrush(RGB(0, 0, 0));
+  wcex.lpszMenuName = NULL;
+  wcex.lpszClassName = WIN_CLASS_NAME;
+  wcex.hIconSm = LoadIcon(NULL, IDI_APPLICATION);
+
+  RegisterClassEx(&wcex);
+  StartupTraceMark("window class");
+
+  RegisterHotKey(NULL, 1, MOD_CONTROL | MOD_SHIFT, VK_F12);
+
+  std::vector<AppOutput> outputs;
+  for (Monitor& monitor : monitors) {
+    const AppOutput& rect = monitor.rect;
+    monitor.hwnd = CreateWindowEx(
+        WS_EX_TOPMOST, WIN_CLASS_NAME, L"", WS_POPUP, rect.x + virtualOrigin.x,
+        rect.y + virtualOrigin.y, rect.width, rect.height, NULL, NULL,
+        GetModuleHandle(NULL), NULL);
+
+    // todo 怎么用 overlay 实现
+    // SetLayeredWindowAttributes(overlay, RGB(0, 0, 0), 0, LWA_COLORKEY);
+    // SetLayeredWindowAttributes(overlay, 0, 255, LWA_ALPHA);
+
+    if (monitor.hwnd == NULL) {
+      MessageBoxA(NULL, "fail to create window failed", "Error",
+                  MB_OK | MB_ICONERROR);
+      return false;
+    }
+    monitor.hdc = GetDC(monitor.hwnd);
+    outputs.push_back(rect);
+  }
+  StartupTraceMark("window");
+
+  //? 窗口先不显示: 截完图由 PlatformShowCapture 显示并贴上截图
+  showCommand = nCmdShow;
+
+  bool forceSoftware = wcsstr(pCmdLine, L"--software") != NULL;
+  if (!AppInit(virtualWidth, virtualHeight, outputs.data(),
+               (int)outputs.size(), forceSoftware)) {
+    return false;
+  }
+
+  //? 每台显示器按自己的刷新率到期就画一帧；和 SetTimer 一样不追帧，
+  //? 落后了就从现在重新计时。等待要 1ms 的精度，144Hz 一帧才 7ms
+  timeBeginPeriod(1);
+  double now = Seconds();
+  for (Monitor& monitor : monitors) monitor.next = now;
+  MSG msg = {};
+  while (true) {
+    while (PeekMessage(&msg, NULL, 0, 0, PM_REMOVE)) {
+      if (msg.message == WM_QUIT) {
+        AppShutdown();
+        for (Monitor& monitor : monitors) {
+          ReleaseDC(monitor.hwnd, monitor.hdc);
+        }
+        timeEndPeriod(1);
+        return 0;
+      }
+      if (msg.message == WM_HOTKEY && msg.wParam == 1) {
+        PostQuitMessage(0);
+        continue;
+      }
+      TranslateMessage(&msg);
+      DispatchMessage(&msg);
+    }
+
+    int due = 0;
+    for (size_t i = 1; i < monitors.size(); i++) {
+      if (monitors[i].next < monitors[due].next) due = (int)i;
+    }
+    Monitor& monitor = monitors[due];
+    now = Seconds();
+    if (now >= monitor.next) {
+      if (due != currentMonitor && g_glrc != NULL) {
+        wglMakeCurrent(monitor.hdc, g_glrc);
+      }
+      currentMonitor = due;
+      AppFrame(due, now);
+      monitor.next += monitor.period;
+      if (monitor.next < now) monitor.next = now + monitor.period;
+      continue;
+    }
+    DWORD wait = (DWORD)((monitor.next - now) * 1000.0);
+    MsgWaitForMultipleObjects(0, NULL, FALSE, wait, QS_ALLINPUT);
+  }
+
+  return 0;
+}
+
+LRESULT CALLBACK WindowProc(HWND hwnd, UINT uMsg, WPARAM wParam,
+                            LPARAM lParam) {
+  switch (uMsg) {
+    case WM_CREATE: {
+      return 0;
+    }
+    case WM_DESTROY: {
+      PostQuitMessage(0);
+      return 0;
+    }
+    case WM_KEYUP: {
+      switch (wParam) {
+        case VK_OEM_4:
+          AppKeyUp('[');
+          break;
+        case VK_OEM_6:
+          AppKeyUp(']');
+          break;
+        case VK_ESCAPE:
+          AppKeyUp(APP_KEY_ESCAPE);
+          break;
+        case 'R':
+          AppKeyUp('R');
+          SetFocus(hwnd);
+          break;
+        default:
+          if (wParam >= 'A' && wParam <= 'Z') AppKeyUp((int)wParam);
+          break;
+      }
+      return 0;
+    }
+    case WM_LBUTTONDOWN:
+    case WM_LBUTTONUP:
+    case WM_RBUTTONDOWN:
+    case WM_RBUTTONUP: {
+      AppButton button =
+          uMsg == WM_LBUTTONDOWN || uMsg == WM_LBUTTONUP ? APP_BUTTON_LEFT
+                                                         : APP_BUTTON_RIGHT;
+      bool down = uMsg == WM_LBUTTONDOWN || uMsg == WM_RBUTTONDOWN;
+      //? 客户区坐标加上这台显示器在桌面上的位置
+      const AppOutput& rect = monitors[MonitorOfWindow(hwnd)].rect;
+      AppMouseButton(button, down, GET_X_LPARAM(lParam) + rect.x,
+                     GET_Y_LPARAM(lParam) + rect.y);
+      return 0;
+    }
+    case WM_MOUSEWHEEL: {
+      auto fwKeys = GET_KEYSTATE_WPARAM(wParam);
+      AppMouseWheel(GET_WHEEL_DELTA_WPARAM(wParam), fwKeys & MK_SHIFT,
+                    fwKeys & MK_CONTROL);
+      return 0;
+    }
+    case WM_PAINT: {
+      PAINTSTRUCT ps;
+      //! 这里必须要手动绘制一下，不然peekmessage不会处理wm_paint事件
+      BeginPaint(hwnd, &ps);
+      EndPaint(hwnd, &ps);
+      return 0;
+    }
+    case WM_ERASEBKGND: {
+      return 1;
+    }
+  }
+  return DefWindowProc(hwnd, uMsg, wParam, lParam);
+}
+
+bool PlatformCreateContext() {
+  PIXELFORMATDESCRIPTOR pfd = {sizeof(PIXELFORMATDESCRIPTOR)};
+  pfd.nVersion = 1;
+  pfd.dwFlags = PFD_DRAW_TO_WINDOW | PFD_SUPPORT_OPENGL | PFD_DOUBLEBUFFER;
+  pfd.iPixelType = PFD_TYPE_RGBA;
+  pfd.cColorBits = 32;
+  pfd.cAlphaBits = 8;
+  pfd.cDepthBits = 24;
+  //! 同一个上下文只能 make current 到像素格式相同的 DC 上
+  HDC primary = monitors[0].hdc;
+  int pf = ChoosePixelFormat(primary, &pfd);
+  for (Monitor& monitor : monitors) SetPixelFormat(monitor.hdc, pf, &pfd);
+  StartupTraceMark("pixel format");
+
+  g_glrc = wglCreateContext(primary);
+  if (g_glrc == NULL) return false;
+  if (!wglMakeCurrent(primary, g_glrc)) {
+    PlatformDestroyContext();
+    return false;
+  }
+  currentMonitor = 0;
+
+  //? 几个窗口轮流 SwapBuffers，每次都等垂直同步的话 60Hz 的副屏会把
+  //? 主屏拖到 60Hz；节奏由主循环按各自的刷新率控制，DWM 合成不会撕裂
+  typedef BOOL(WINAPI * SwapIntervalProc)(int);
+  SwapIntervalProc swapInterval =
+      (SwapIntervalProc)wglGetProcAddress("wglSwapIntervalEXT");
+  if (monitors.size() > 1 && swapInterval != NULL) swapInterval(0);
+  StartupTraceMark("context");
+  return true;
+}
+
+void PlatformDestroyContext() {
+  wglMakeCurrent(NULL, NULL);
+  wglDeleteContext(g_glrc);
+  g_glrc = NULL;
+}
+
+void PlatformSwapBuffers() { SwapBuffers(monitors[currentMonitor].hdc); }
+
+void* PlatformGetProcAddress(const char* name) {
+  //? wglGetProcAddress 拿不到 opengl32.dll 导出的 1.1 函数，失败时还可能返回
+  //? 1 2 3 -1 而不是 NULL
+  PROC proc = wglGetProcAddress(name);
+  if (proc == NULL || proc == (PROC)1 || proc == (PROC)2 || proc == (PROC)3 ||
+      proc == (PROC)-1) {
+    static HMODULE opengl32 = LoadLibraryA("opengl32.dll");
+    proc = GetProcAddress(opengl32, name);
+  }
+  return (void*)proc;
+}
+
+unsigned int PlatformFramebuffer() { return 0; }
+
+//? 自下而上的 32 位 DIB，和截图的行序一样，BitBlt 时 GDI 负责翻过来
+unsigned char* PlatformCreateSoftwareTarget(int width, int height,
+                                            int* pitch) {
+  BITMAPINFO bmi = {};
+  bmi.bmiHeader.biSize = sizeof(BITMAPINFOHEADER);
+  bmi.bmiHeader.biWidth = width;
+  bmi.bmiHeader.biHeight = height;  // 正数: 自下而上
+  bmi.bmiHeader.biPlanes = 1;
+  bmi.bmiHeader.biBitCount = 32;
+  bmi.bmiHeader.biCompression = BI_RGB;
+
+  unsigned char* pixels = nullptr;
+  HDC primary = monitors[0].hdc;
+  softBitmap = CreateDIBSection(primary, &bmi, DIB_RGB_COLORS, (void**)&pixels,
+                                NULL, 0);
+  if (softBitmap == NULL) return nullptr;
+  softDC = CreateCompatibleDC(primary);
+  SelectObject(softDC, softBitmap);
+  softWidth = width;
+  softHeight = height;
+  *pitch = width * 4;
+  return pixels;
+}
+
+void PlatformDestroySoftwareTarget() {
+  DeleteDC(softDC);
+  DeleteObject(softBitmap);
+}
+
+//? DIB 在 DC 里是按自上而下寻址的，桌面坐标直接用
+void PlatformPresentSoftware() {
+  const Monitor& monitor = monitors[currentMonitor];
+  const AppOutput& rect = monitor.rect;
+  BitBlt(monitor.hdc, 0, 0, rect.width, rect.height, softDC, rect.x, rect.y,
+         SRCCOPY);
+}
+
+unsigned char* PlatformCaptureScreen(int width, int height) {
+  HDC hScreen = GetDC(NULL);
+  HDC hMemDC = CreateCompatibleDC(hScreen);
+
+  HBITMAP hBitmap = CreateCompatibleBitmap(hScreen, width, height);
+  SelectObject(hMemDC, hBitmap);
+
+  //? 复制屏幕到 hBitmap，虚拟桌面的左上角不一定是 (0, 0)
+  BitBlt(hMemDC, 0, 0, width, height, hScreen, virtualOrigin.x,
+         virtualOrigin.y, SRCCOPY);
+  StartupTraceMark("capture");
+
+  DeleteDC(hMemDC);
+
+  BITMAP bm;
+  GetObject(hBitmap, sizeof(BITMAP), &bm);
+  BITMAPINFOHEADER bi = {};
+  bi.biSize = sizeof(BITMAPINFOHEADER);
+  bi.biWidth = bm.bmWidth;
+  bi.biHeight = bm.bmHeight;
+  bi.biPlanes = 1;
+  bi.biBitCount = 32;
+  bi.biCompression = BI_RGB;
+  assert(width == bm.bmWidth && height == bm.bmHeight);
+  size_t size = bm.bmWidth * bm.bmHeight * 4;
+  unsigned char* data = new unsigned char[size];
+
+  GetDIBits(hScreen, hBitmap, 0, height, data, (BITMAPINFO*)&bi,
+            DIB_RGB_COLORS);
+  //! 屏幕 DC 的第四个字节没有定义，常常是 0
+  for (size_t i = 3; i < size; i += 4) data[i] = 255;
+  ReleaseDC(NULL, hScreen);
+  DeleteObject(hBitmap);
+  StartupTraceMark("conversion");
+  return data;
+}
+
+//? 截图本身是自下而上的 32 位 DIB，SetDIBitsToDevice 直接贴，不用 GL
+//? 每个窗口贴自己那一块，源的 y 是从下边算的
+void PlatformShowCapture(const unsigned char* pixels, int width, int height) {
+  BITMAPINFO bmi = {};
+  bmi.bmiHeader.biSize = sizeof(BITMAPINFOHEADER);
+  bmi.bmiHeader.biWidth = width;
+  bmi.bmiHeader.biHeight = height;
+  bmi.bmiHeader.biPlanes = 1;
+  bmi.bmiHeader.biBitCount = 32;
+  bmi.bmiHeader.biCompression = BI_RGB;
+  for (const Monitor& monitor : monitors) {
+    const AppOutput& rect = monitor.rect;
+    ShowWindow(monitor.hwnd, showCommand);
+    SetWindowPos(monitor.hwnd, HWND_TOP, 0, 0, 0, 0, SWP_NOMOVE | SWP_NOSIZE);
+    SetDIBitsToDevice(monitor.hdc, 0, 0, rect.width, rect.height, rect.x,
+                      height - rect.y - rect.height, 0, height, pixels, &bmi,
+                      DIB_RGB_COLORS);
+  }
+  SetFocus(monitors[0].hwnd);
+  GdiFlush();
+}
+
+void PlatformGetCursor(int* x, int* y) {
+  POINT p;
+  GetCursorPos(&p);
+  *x = p.x - virtualOrigin.x;
+  *y = p.y - virtualOrigin.y;
+}
+
+bool PlatformCopyText(const char* text) {
+  size_t len = strlen(text) + 1;
+  HGLOBAL mem = GlobalAlloc(GMEM_MOVEABLE, len);
+  if (!mem) return false;
+  memcpy(GlobalLock(mem), text, len);
+  GlobalUnlock(mem);
+
+  if (!OpenClipboard(monitors[0].hwnd)) {
+    GlobalFree(mem);
+    return false;
+  }
+  EmptyClipboard();
+  if (!SetClipboardData(CF_TEXT, mem)) {
+    GlobalFree(mem);
+  }
+  CloseClipboard();
+  return true;
+}
+
+void PlatformShowError(const char* title, const char* message) {
+  MessageBoxA(NULL, message, title, MB_OK | MB_ICONERROR);
+}
+
+std::string PlatformExeDir() {
+  char pathBuf[BUF_SIZE] = {};
+  GetModuleFileNameA(NULL, pathBuf, BUF_SIZE);
+  std::string path(pathBuf);
+  return path.substr(0, path.find_last_of("/\\"));
+}
+
+void PlatformQuit() { PostQuitMessage(0); }
@@ -0,0 +1,620 @@
+#include <limits.h>
+#include <math.h>
+#include <poll.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/ipc.h>
+#include <sys/shm.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <string>
+
+#include <GL/glx.h>
+#include <X11/XKBlib.h>
+#include <X11/Xatom.h>
+#include <X11/Xlib.h>
+#include <X11/Xutil.h>
+#include <X11/extensions/XShm.h>
+#include <X11/keysym.h>
+#ifdef XINPUT2
+#include <X11/extensions/XInput2.h>
+#endif
+
+#include "platform.h"
+#include "trace.h"
+
+//& X11 + GLX 的平台层
+//? 全屏的 override-redirect 窗口，相当于 Win32 的 WS_POPUP + WS_EX_TOPMOST
+//? 按键、按钮和滚轮走核心事件。指针位置: 编译时有 XInput2 (定义了 XINPUT2)
+//? 且服务器支持 2.0 时取自 XI_Motion 事件 (每次移动都有，不用每帧往返一次)；
+//? 否则、或者第一个 XI_Motion 到来之前，每帧用 XQueryPointer 取
+//? (同 GetCursorPos)
+//? 截图和软件渲染的呈现都走 XShm，服务器不支持时退回 XGetImage / XPutImage
+//? 没有用 XRandR，整个 screen 算一台显示器 (一个输出)，按固定间隔刷新
+
+#define REFRESH_INTERVAL_MS 16
+
+Display* display;
+Window root, overlay;
+bool running = true;
+bool useShm;
+
+#ifdef XINPUT2
+int xiOpcode;  // 0: 服务器没有 XInput2
+bool pointerKnown;
+double pointerX, pointerY;
+#endif
+
+GLXFBConfig fbConfig;
+GLXContext glContext;
+
+//? 截图的原始 XImage 留到 PlatformShowCapture 贴到窗口上再释放
+XImage* captureImage;
+XShmSegmentInfo captureShm;
+bool captureIsShm;
+
+//? 软件渲染画进自上而下的 XImage，每帧 XShmPutImage 到窗口
+XImage* softImage;
+XShmSegmentInfo softShm;
+GC softGC;
+
+//? X11 的剪贴板由持有者应答，所以要自己留着内容
+std::string clipboardText;
+Atom atomClipboard, atomTargets, atomUtf8;
+
+//! 有些请求失败时服务器回的是异步错误，默认的处理函数会直接退出进程
+bool xErrorOccurred;
+int CatchXError(Display*, XErrorEvent*) {
+  xErrorOccurred = true;
+  return 0;
+}
+
+void HandleEvent(XEvent& event);
+
+#ifdef XINPUT2
+//? 在窗口上选所有主指针的 XI_Motion，服务器不支持时留着 xiOpcode = 0
+void SelectPointerEvents() {
+  int event, error;
+  if (!XQueryExtension(display, "XInputExtension", &xiOpcode, &event,
+                       &error)) {
+    xiOpcode = 0;
+    return;
+  }
+  int major = 2, minor = 0;
+  if (XIQueryVersion(display, &major, &minor) != Success) {
+    xiOpcode = 0;
+    return;
+  }
+  unsigned char bits[XIMaskLen(XI_LASTEVENT)] = {};
+  XISetMask(bits, XI_Motion);
+  XIEventMask mask = {XIAllMasterDevices, (int)sizeof(bits), bits};
+  XISelectEvents(display, overlay, &mask, 1);
+}
+#endif
+
+//? 只要 24 位的 visual: 32 位的 ARGB visual 在合成器下会按 alpha 透明
+XVisualInfo* ChooseVisual(int screen) {
+  static const int attribs[] = {GLX_X_RENDERABLE,
+                                True,
+                                GLX_DRAWABLE_TYPE,
+                                GLX_WINDOW_BIT,
+                                GLX_RENDER_TYPE,
+                                GLX_RGBA_BIT,
+                                GLX_RED_SIZE,
+                                8,
+                                GLX_GREEN_SIZE,
+                                8,
+                                GLX_BLUE_SIZE,
+                                8,
+                                GLX_DEPTH_SIZE,
+                                24,
+                                GLX_DOUBLEBUFFER,
+                                True,
+                                None};
+  int count = 0;
+  GLXFBConfig* configs = glXChooseFBConfig(display, screen, attribs, &count);
+  if (configs == NULL) return NULL;
+  XVisualInfo* chosen = NULL;
+  for (int i = 0; i < count && chosen == NULL; i++) {
+    XVisualInfo* vi = glXGetVisualFromFBConfig(display, configs[i]);
+    if (vi != NULL && vi->depth == 24) {
+      fbConfig = configs[i];
+      chosen = vi;
+    } else if (vi != NULL) {
+      XFree(vi);
+    }
+  }
+  XFree(configs);
+  return chosen;
+}
+
+int main(int argc, char** argv) {
+  bool forceSoftware = false;
+  int frameLimit = 0;  // --frames N: 画 N 帧后退出，给 make xvfb-test 用
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "--software") == 0) forceSoftware = true;
+    if (strcmp(argv[i], "--trace-startup") == 0) StartupTraceBegin();
+    if (strcmp(argv[i], "--frames") == 0 && i + 1 < argc) {
+      frameLimit = atoi(argv[++i]);
+    }
+  }
+
+  display = XOpenDisplay(NULL);
+  if (display == NULL) {
+    PlatformShowError("Error", "failed to open display");
+    return 1;
+  }
+  StartupTraceMark("open display");
+  int screen = DefaultScreen(display);
+  root = RootWindow(display, screen);
+  int width = DisplayWidth(display, screen);
+  int height = DisplayHeight(display, screen);
+
+  int shmMajor, shmMinor;
+  Bool shmPixmaps;
+  useShm = XShmQueryVersion(display, &shmMajor, &shmMinor, &shmPixmaps);
+
+  atomClipboard = XInternAtom(display, "CLIPBOARD", False);
+  atomTargets = XInternAtom(display, "TARGETS", False);
+  atomUtf8 = XInternAtom(display, "UTF8_STRING", False);
+
+  //? 没有 GLX 时用默认 visual，核心会走软件渲染
+  XVisualInfo* vi = forceSoftware ? NULL : ChooseVisual(screen);
+  Visual* visual = vi ? vi->visual : DefaultVisual(display, screen);
+  int depth = vi ? vi->depth : DefaultDepth(display, screen);
+  if (vi != NULL) XFree(vi);
+
+  XSetWindowAttributes attrs = {};
+  attrs.colormap = XCreateColormap(display, root, visual, AllocNone);
+  attrs.override_redirect = True;
+  attrs.background_pixmap = None;  // 同 WM_ERASEBKGND 返回 1
+  attrs.border_pixel = 0;
+  attrs.event_mask = KeyPressMask | KeyReleaseMask | ButtonPressMask |
+                     ButtonReleaseMask | ExposureMask | StructureNotifyMask;
+  overlay = XCreateWindow(
+      display, root, 0, 0, width, height, 0, depth, InputOutput, visual,
+      CWColormap | CWOverrideRedirect | CWBackPixmap | CWBorderPixel |
+          CWEventMask,
+      &attrs);
+  if (overlay == None) {
+    PlatformShowError("Error", "fail to create window failed");
+    XCloseDisplay(display);
+    return 1;
+  }
+  StartupTraceMark("window");
+#ifdef XINPUT2
+  SelectPointerEvents();
+#endif
+
+  //! 窗口由 PlatformShowCapture 在截图以后才映射，不然截到的是自己
+  AppOutput output = {0, 0, width, height};
+  if (!AppInit(width, height, &output, 1, forceSoftware)) {
+    XDestroyWindow(display, overlay);
+    XCloseDisplay(display);
+    return 1;
+  }
+
+  XkbSetDetectableAutoRepeat(display, True, NULL);
+  //? override-redirect 的窗口窗口管理器不会给焦点，自己抓键盘
+  XSync(display, False);
+  if (XGrabKeyboard(display, overlay, True, GrabModeAsync, GrabModeAsync,
+                    CurrentTime) != GrabSuccess) {
+    XSetInputFocus(display, overlay, RevertToParent, CurrentTime);
+  }
+
+  //? 热键 Ctrl+Shift+F12 退出，Lock / NumLock 开着时也要能用
+  KeyCode f12 = XKeysymToKeycode(display, XK_F12);
+  unsigned int locks[] = {0, LockMask, Mod2Mask, LockMask | Mod2Mask};
+  for (unsigned int lock : locks) {
+    XGrabKey(display, f12, ControlMask | ShiftMask | lock, root, True,
+             GrabModeAsync, GrabModeAsync);
+  }
+
+  //? 和 SetTimer 一样不追帧: 落后了就从现在重新计时
+  auto period = std::chrono::milliseconds(REFRESH_INTERVAL_MS);
+  auto start = std::chrono::steady_clock::now();
+  auto next = start + period;
+  int fd = ConnectionNumber(display);
+  int frames = 0;
+  while (running) {
+    while (running && XPending(display)) {
+      XEvent event;
+      XNextEvent(display, &event);
+      HandleEvent(event);
+    }
+    if (!running) break;
+
+    auto now = std::chrono::steady_clock::now();
+    if (now >= next) {
+      std::chrono::duration<double> seconds = now - start;
+      AppFrame(0, seconds.count());
+      if (frameLimit > 0 && ++frames >= frameLimit) running = false;
+      next += period;
+      if (next < now) next = now + period;
+      continue;
+    }
+    auto wait =
+        std::chrono::duration_cast<std::chrono::milliseconds>(next - now);
+    pollfd pfd = {fd, POLLIN, 0};
+    poll(&pfd, 1, (int)wait.count() + 1);
+  }
+
+  AppShutdown();
+  for (unsigned int lock : locks) {
+    XUngrabKey(display, f12, ControlMask | ShiftMask | lock, root);
+  }
+  XUngrabKeyboard(display, CurrentTime);
+  XDestroyWindow(display, overlay);
+  XFreeColormap(display, attrs.colormap);
+  XCloseDisplay(display);
+  return 0;
+}
+
+void AnswerSelection(const XSelectionRequestEvent& request) {
+  XSelectionEvent reply = {};
+  reply.type = SelectionNotify;
+  reply.display = request.display;
+  reply.requestor = request.requestor;
+  reply.selection = request.selection;
+  reply.target = request.target;
+  reply.time = request.time;
+  reply.property = None;
+
+  if (request.target == atomTargets) {
+    Atom targets[] = {atomTargets, atomUtf8, XA_STRING};
+    XChangeProperty(display, request.requestor, request.property, XA_ATOM, 32,
+                    PropModeReplace, (unsigned char*)targets, 3);
+    reply.property = request.property;
+  } else if (request.target == atomUtf8 || request.target == XA_STRING) {
+    //? 取色的文本只有 ASCII，两种格式内容一样
+    XChangeProperty(display, request.requestor, request.property,
+                    request.target, 8, PropModeReplace,
+                    (const unsigned char*)clipboardText.data(),
+                    (int)clipboardText.size());
+    reply.property = request.property;
+  }
+  XSendEvent(display, request.requestor, False, NoEventMask, (XEvent*)&reply);
+}
+
+void HandleEvent(XEvent& event) {
+  switch (event.type) {
+    case KeyPress: {
+      KeySym sym = XLookupKeysym(&event.xkey, 0);
+      unsigned int mods = ControlMask | ShiftMask;
+      if (sym == XK_F12 && (event.xkey.state & mods) == mods) running = false;
+      break;
+    }
+    case KeyRelease: {
+      //? 索引 0 不受 Shift 影响，字母是小写的
+      KeySym sym = XLookupKeysym(&event.xkey, 0);
+      if (sym >= XK_a && sym <= XK_z) {
+        AppKeyUp('A' + (int)(sym - XK_a));
+      } else if (sym == XK_bracketleft) {
+        AppKeyUp('[');
+      } else if (sym == XK_bracketright) {
+        AppKeyUp(']');
+      } else if (sym == XK_Escape) {
+        AppKeyUp(APP_KEY_ESCAPE);
+      }
+      break;
+    }
+    case ButtonPress:
+    case ButtonRelease: {
+      bool down = event.type == ButtonPress;
+      XButtonEvent& b = event.xbutton;
+      if (b.button == Button1) {
+        AppMouseButton(APP_BUTTON_LEFT, down, b.x, b.y);
+      } else if (b.button == Button3) {
+        AppMouseButton(APP_BUTTON_RIGHT, down, b.x, b.y);
+      } else if ((b.button == Button4 || b.button == Button5) && down) {
+        //? 滚轮是 4 / 5 号按钮的按下，一格按 WM_MOUSEWHEEL 的 120 算
+        AppMouseWheel(b.button == Button4 ? 120 : -120, b.state & ShiftMask,
+                      b.state & ControlMask);
+      }
+      break;
+    }
+    case SelectionRequest: {
+      AnswerSelection(event.xselectionrequest);
+      break;
+    }
+    case SelectionClear: {
+      clipboardText.clear();
+      break;
+    }
+#ifdef XINPUT2
+    case GenericEvent: {
+      XGenericEventCookie& cookie = event.xcookie;
+      if (xiOpcode == 0 || cookie.extension != xiOpcode ||
+          !XGetEventData(display, &cookie)) {
+        break;
+      }
+      if (cookie.evtype == XI_Motion) {
+        XIDeviceEvent* motion = (XIDeviceEvent*)cookie.data;
+        pointerX = motion->event_x;
+        pointerY = motion->event_y;
+        pointerKnown = true;
+      }
+      XFreeEventData(display, &cookie);
+      break;
+    }
+#endif
+  }
+}
+
+bool PlatformCreateContext() {
+  if (fbConfig == NULL) return false;
+
+  //? 优先要 3.3 core，驱动不支持 GLX_ARB_create_context 时退回旧接口，
+  //? 版本不够的话核心会自己发现并改用软件渲染
+  auto createContextAttribs =
+      (PFNGLXCREATECONTEXTATTRIBSARBPROC)glXGetProcAddressARB(
+          (const GLubyte*)"glXCreateContextAttribsARB");
+  XErrorHandler oldHandler = XSetErrorHandler(CatchXError);
+  xErrorOccurred = false;
+  if (createContextAttribs != NULL) {
+    const int attribs[] = {GLX_CONTEXT_MAJOR_VERSION_ARB,
+                           3,
+                           GLX_CONTEXT_MINOR_VERSION_ARB,
+                           3,
+                           GLX_CONTEXT_PROFILE_MASK_ARB,
+                           GLX_CONTEXT_CORE_PROFILE_BIT_ARB,
+                           None};
+    glContext = createContextAttribs(display, fbConfig, NULL, True, attribs);
+    XSync(display, False);
+  }
+  if (glContext == NULL || xErrorOccurred) {
+    xErrorOccurred = false;
+    glContext =
+        glXCreateNewContext(display, fbConfig, GLX_RGBA_TYPE, NULL, True);
+    XSync(display, False);
+  }
+  XSetErrorHandler(oldHandler);
+  if (glContext == NULL || xErrorOccurred) {
+    glContext = NULL;
+    return false;
+  }
+
+  if (!glXMakeCurrent(display, overlay, glContext)) {
+    PlatformDestroyContext();
+    return false;
+  }
+  StartupTraceMark("context");
+  return true;
+}
+
+void PlatformDestroyContext() {
+  glXMakeCurrent(display, None, NULL);
+  if (glContext != NULL) glXDestroyContext(display, glContext);
+  glContext = NULL;
+}
+
+void PlatformSwapBuffers() { glXSwapBuffers(display, overlay); }
+
+void* PlatformGetProcAddress(const char* name) {
+  return (void*)glXGetProcAddressARB((const GLubyte*)name);
+}
+
+unsigned int PlatformFramebuffer() { return 0; }
+
+//? 建一个共享内存段挂到 image 上；失败时 image->data 为 NULL
+bool AttachShm(XImage* image, XShmSegmentInfo* info) {
+  image->data = NULL;
+  info->shmid = shmget(IPC_PRIVATE, image->bytes_per_line * image->height,
+                       IPC_CREAT | 0600);
+  if (info->shmid < 0) return false;
+  info->shmaddr = (char*)shmat(info->shmid, NULL, 0);
+  info->readOnly = False;
+  bool attached = false;
+  if (info->shmaddr != (char*)-1) {
+    //! 远程连接时 XShmAttach 会异步失败
+    XErrorHandler oldHandler = XSetErrorHandler(CatchXError);
+    xErrorOccurred = false;
+    XShmAttach(display, info);
+    XSync(display, False);
+    XSetErrorHandler(oldHandler);
+    attached = !xErrorOccurred;
+    if (!attached) shmdt(info->shmaddr);
+  }
+  //? 双方都挂上以后就可以标记删除，进程退出时自动回收
+  shmctl(info->shmid, IPC_RMID, NULL);
+  if (!attached) return false;
+  image->data = info->shmaddr;
+  return true;
+}
+
+void DestroyShmImage(XImage* image, XShmSegmentInfo* info) {
+  XShmDetach(display, info);
+  XSync(display, False);
+  shmdt(info->shmaddr);
+  image->data = NULL;  // 否则 XDestroyImage 会 free 共享内存
+  XDestroyImage(image);
+}
+
+//? 核心按 BGRA 读写，对应小端机器上 32 位、红色在高位的 TrueColor
+bool IsBgra(const XImage* image) {
+  return image->bits_per_pixel == 32 && image->byte_order == LSBFirst &&
+         image->red_mask == 0xff0000 && image->green_mask == 0xff00 &&
+         image->blue_mask == 0xff;
+}
+
+unsigned char* PlatformCreateSoftwareTarget(int width, int height,
+                                            int* pitch) {
+  XWindowAttributes wa;
+  XGetWindowAttributes(display, overlay, &wa);
+  softImage = NULL;
+  if (useShm) {
+    softImage = XShmCreateImage(display, wa.visual, wa.depth, ZPixmap, NULL,
+                                &softShm, width, height);
+    if (softImage != NULL && !AttachShm(softImage, &softShm)) {
+      XDestroyImage(softImage);
+      softImage = NULL;
+      useShm = false;
+    }
+  }
+  if (softImage == NULL) {
+    softImage = XCreateImage(display, wa.visual, wa.depth, ZPixmap, 0, NULL,
+                             width, height, 32, 0);
+    if (softImage == NULL) return nullptr;
+    softImage->data = (char*)malloc(softImage->bytes_per_line * height);
+  }
+  if (softImage->data == NULL || !IsBgra(softImage)) {
+    PlatformDestroySoftwareTarget();
+    return nullptr;
+  }
+  softGC = XCreateGC(display, overlay, 0, NULL);
+
+  //? XImage 是自上而下的，第 0 行在最后
+  *pitch = -softImage->bytes_per_line;
+  return (unsigned char*)softImage->data +
+         (size_t)(height - 1) * softImage->bytes_per_line;
+}
+
+void PlatformDestroySoftwareTarget() {
+  if (softImage == NULL) return;
+  if (softGC != NULL) XFreeGC(display, softGC);
+  softGC = NULL;
+  if (useShm) {
+    DestroyShmImage(softImage, &softShm);
+  } else {
+    XDestroyImage(softImage);
+  }
+  softImage = NULL;
+}
+
+void PlatformPresentSoftware() {
+  if (useShm) {
+    XShmPutImage(display, overlay, softGC, softImage, 0, 0, 0, 0,
+                 softImage->width, softImage->height, False);
+    //! 等服务器读完再画下一帧，不然会撕裂
+    XSync(display, False);
+  } else {
+    XPutImage(display, overlay, softGC, softImage, 0, 0, 0, 0,
+              softImage->width, softImage->height);
+    XFlush(display);
+  }
+}
+
+void ReleaseCapture() {
+  if (captureImage == NULL) return;
+  if (captureIsShm) {
+    DestroyShmImage(captureImage, &captureShm);
+  } else {
+    XDestroyImage(captureImage);
+  }
+  captureImage = NULL;
+}
+
+unsigned char* PlatformCaptureScreen(int width, int height) {
+  XWindowAttributes ra;
+  XGetWindowAttributes(display, root, &ra);
+
+  XImage* image = NULL;
+  XShmSegmentInfo info = {};
+  bool shm = false;
+  if (useShm) {
+    image = XShmCreateImage(display, ra.visual, ra.depth, ZPixmap, NULL, &info,
+                            width, height);
+    if (image != NULL && AttachShm(image, &info)) {
+      shm = XShmGetImage(display, root, image, 0, 0, AllPlanes);
+      if (!shm) DestroyShmImage(image, &info);
+    } else if (image != NULL) {
+      XDestroyImage(image);
+    }
+    if (!shm) image = NULL;
+  }
+  if (image == NULL) {
+    image = XGetImage(display, root, 0, 0, width, height, AllPlanes, ZPixmap);
+    if (image == NULL) return nullptr;
+  }
+  StartupTraceMark("capture");
+
+  unsigned char* data = nullptr;
+  if (IsBgra(image)) {
+    //? 翻成自下而上，和 GetDIBits 的结果一样；root 的 X 通道不一定是 255
+    data = new unsigned char[(size_t)width * height * 4];
+    for (int y = 0; y < height; y++) {
+      const char* src =
+          image->data + (size_t)(height - 1 - y) * image->bytes_per_line;
+      unsigned char* dst = data + (size_t)y * width * 4;
+      memcpy(dst, src, (size_t)width * 4);
+      for (int x = 0; x < width; x++) dst[x * 4 + 3] = 255;
+    }
+  }
+  StartupTraceMark("conversion");
+
+  captureImage = image;
+  captureShm = info;
+  captureIsShm = shm;
+  if (!data) ReleaseCapture();
+  return data;
+}
+
+Bool IsMapNotify(Display*, XEvent* event, XPointer window) {
+  return event->type == MapNotify && event->xmap.window == *(Window*)window;
+}
+
+//? 贴的是截图时拿到的那个 XImage (本来就是自上而下的)，不用再转换
+void PlatformShowCapture(const unsigned char*, int width, int height) {
+  XMapRaised(display, overlay);
+  //! 窗口真的映射了再画，不然内容会被丢掉
+  XEvent event;
+  XIfEvent(display, &event, IsMapNotify, (XPointer)&overlay);
+
+  XWindowAttributes wa;
+  XGetWindowAttributes(display, overlay, &wa);
+  if (captureImage != NULL && captureImage->depth == wa.depth) {
+    GC gc = XCreateGC(display, overlay, 0, NULL);
+    if (captureIsShm) {
+      XShmPutImage(display, overlay, gc, captureImage, 0, 0, 0, 0, width,
+                   height, False);
+    } else {
+      XPutImage(display, overlay, gc, captureImage, 0, 0, 0, 0, width,
+                height);
+    }
+    XFreeGC(display, gc);
+  }
+  XSync(display, False);
+  ReleaseCapture();
+}
+
+void PlatformGetCursor(int* x, int* y) {
+#ifdef XINPUT2
+  //? 坐标带小数，向下取整和核心事件的整数坐标一致
+  if (pointerKnown) {
+    *x = (int)floor(pointerX);
+    *y = (int)floor(pointerY);
+    return;
+  }
+#endif
+  Window rootReturn, childReturn;
+  int rootX, rootY, winX = 0, winY = 0;
+  unsigned int mask;
+  XQueryPointer(display, overlay, &rootReturn, &childReturn, &rootX, &rootY,
+                &winX, &winY, &mask);
+  *x = winX;
+  *y = winY;
+}
+
+bool PlatformCopyText(const char* text) {
+  //? 没有剪贴板管理器时，程序退出后内容就没了
+  clipboardText = text;
+  XSetSelectionOwner(display, atomClipboard, overlay, CurrentTime);
+  return XGetSelectionOwner(display, atomClipboard) == overlay;
+}
+
+void PlatformShowError(const char* title, const char* message) {
+  fprintf(stderr, "%s: %s\n", title, message);
+}
+
+std::string PlatformExeDir() {
+  char pathBuf[PATH_MAX] = {};
+  if (readlink("/proc/self/exe", pathBuf, sizeof(pathBuf) - 1) <= 0) {
+    return ".";
+  }
+  std::string path(pathBuf);
+  return path.substr(0, path.find_last_of('/'));
+}
+
+void PlatformQuit() { running = false; }
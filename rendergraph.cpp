@@ -0,0 +1,179 @@
+#include "rendergraph.h"
+
+#include <algorithm>
+#include <vector>
+
+namespace {
+
+const int kQueryCount = 3;  // 每个 pass 几个查询轮流用
+
+//? 查询对应的 tag 和面积，pending 表示结果还没读
+struct PassQueries {
+  GLuint ids[kQueryCount];
+  int tag[kQueryCount];
+  float area[kQueryCount];
+  bool pending[kQueryCount];
+  int next;
+};
+
+struct PooledTarget {
+  GLuint framebuffer, texture;
+  int width, height;
+  bool busy;
+};
+
+std::vector<RenderPass> passes;
+std::vector<PassQueries> queries;
+std::vector<PooledTarget> pool;
+
+//? 没在用、放得下的纹理里挑最小的一张，都不行再新建
+//? 新建的至少和输出一样大，分辨率一档档回升时不会每档都新建一张
+int AcquireTarget(int width, int height, int outputWidth, int outputHeight) {
+  int best = -1;
+  for (int i = 0; i < (int)pool.size(); i++) {
+    const PooledTarget& t = pool[i];
+    if (t.busy || t.width < width || t.height < height) continue;
+    if (best < 0 ||
+        t.width * t.height < pool[best].width * pool[best].height) {
+      best = i;
+    }
+  }
+  if (best < 0) {
+    PooledTarget t = {};
+    t.width = std::max(width, outputWidth);
+    t.height = std::max(height, outputHeight);
+    glGenTextures(1, &t.texture);
+    glBindTexture(GL_TEXTURE_2D, t.texture);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, t.width, t.height, 0, GL_BGRA,
+                 GL_UNSIGNED_BYTE, nullptr);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    glGenFramebuffers(1, &t.framebuffer);
+    glBindFramebuffer(GL_FRAMEBUFFER, t.framebuffer);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D,
+                           t.texture, 0);
+    pool.push_back(t);
+    best = (int)pool.size() - 1;
+  }
+  pool[best].busy = true;
+  return best;
+}
+
+//? 读出已经完成的查询，没出来的留到下次
+void CollectTimings(int index) {
+  RenderPass& pass = passes[index];
+  PassQueries& q = queries[index];
+  for (int i = 0; i < kQueryCount; i++) {
+    if (!q.pending[i]) continue;
+    GLint available = 0;
+    glGetQueryObjectiv(q.ids[i], GL_QUERY_RESULT_AVAILABLE, &available);
+    if (!available) continue;
+    GLuint64 ns = 0;
+    glGetQueryObjectui64v(q.ids[i], GL_QUERY_RESULT, &ns);
+    q.pending[i] = false;
+    float ms = ns / 1e6f;
+    pass.gpuMs = pass.gpuMs == 0.0f ? ms : pass.gpuMs * 0.9f + ms * 0.1f;
+    if (pass.onTimed) pass.onTimed(ms, q.tag[i], q.area[i]);
+  }
+}
+
+}  // namespace
+
+int RenderGraphAddPass(const char* name, const RenderPassFn& execute) {
+  RenderPass pass = {};
+  pass.name = name;
+  pass.execute = execute;
+  pass.enabled = true;
+  passes.push_back(pass);
+  queries.push_back(PassQueries());
+  return (int)passes.size() - 1;
+}
+
+RenderPass& RenderGraphPass(int index) { return passes[index]; }
+
+int RenderGraphPassCount() { return (int)passes.size(); }
+
+void RenderGraphExecute(GLuint framebuffer, int width, int height) {
+  int count = (int)passes.size();
+  int input = -1;  // 上一个 pass 画进的池里的纹理
+  RenderTarget inputTarget = {};
+
+  for (int i = 0; i < count; i++) {
+    RenderPass& pass = passes[i];
+    if (!pass.enabled) continue;
+
+    bool offscreen = false;
+    for (int j = i + 1; j < count; j++) {
+      if (passes[j].enabled) {
+        offscreen = passes[j].readsInput;
+        break;
+      }
+    }
+
+    RenderTarget target = {framebuffer, 0, width, height, width, height};
+    int slot = -1;
+    if (offscreen) {
+      int w = width, h = height;
+      if (input >= 0) {
+        w = inputTarget.width;
+        h = inputTarget.height;
+      }
+      if (pass.width) {
+        w = pass.width;
+        h = pass.height;
+      }
+      slot = AcquireTarget(w, h, width, height);
+      const PooledTarget& t = pool[slot];
+      target = {t.framebuffer, t.texture, w, h, t.width, t.height};
+    }
+    glBindFramebuffer(GL_FRAMEBUFFER, target.framebuffer);
+    glViewport(0, 0, target.width, target.height);
+    if (offscreen) glClear(GL_COLOR_BUFFER_BIT);
+
+    // 上一轮用这个查询的结果还没出来就这次不计时
+    PassQueries& q = queries[i];
+    if (!q.ids[0]) glGenQueries(kQueryCount, q.ids);
+    CollectTimings(i);
+    int query = q.next;
+    bool timed = !q.pending[query];
+    if (timed) glBeginQuery(GL_TIME_ELAPSED, q.ids[query]);
+
+    pass.execute(pass.readsInput && input >= 0 ? &inputTarget : nullptr,
+                 target);
+
+    if (timed) {
+      glEndQuery(GL_TIME_ELAPSED);
+      q.pending[query] = true;
+      q.tag[query] = pass.tag;
+      q.area[query] = (float)target.width * target.height / width / height;
+      q.next = (query + 1) % kQueryCount;
+    }
+
+    if (input >= 0) pool[input].busy = false;
+    input = slot;
+    inputTarget = target;
+  }
+  if (input >= 0) pool[input].busy = false;
+
+  glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+  glViewport(0, 0, width, height);
+}
+
+int RenderGraphPoolSize() { return (int)pool.size(); }
+
+void RenderGraphRelease() {
+  for (PooledTarget& t : pool) {
+    glDeleteFramebuffers(1, &t.framebuffer);
+    glDeleteTextures(1, &t.texture);
+  }
+  pool.clear();
+  for (PassQueries& q : queries) {
+    if (q.ids[0]) glDeleteQueries(kQueryCount, q.ids);
+  }
+  passes.clear();
+  queries.clear();
+}
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <functional>
+
+#include "glload.h"
+
+//& 渲染图: 每帧按加入的顺序跑一串 pass，没打开的 pass 整个跳过
+//? (不绑 FBO、不清屏、不计时)，一串都关掉的功能不花任何 GPU 时间
+//? 下一个打开的 pass 要读输入时，这个 pass 才画进池里的纹理，否则直接画到
+//? 输出上；池里的纹理用完就还回去给后面的 pass，稳定以后每帧没有分配
+//? 每个 pass 有自己的 GL_TIME_ELAPSED 查询，结果出来才读，不等 GPU
+
+//? 画的范围都从左下角开始，池里的纹理可能比 width x height 大
+struct RenderTarget {
+  GLuint framebuffer;
+  GLuint texture;  // 输出上是 0
+  int width, height;
+  int textureWidth, textureHeight;
+};
+
+typedef std::function<void(const RenderTarget* input,
+                           const RenderTarget& target)>
+    RenderPassFn;
+
+struct RenderPass {
+  const char* name;
+  RenderPassFn execute;
+  bool enabled;
+  bool readsInput;    // 读上一个打开的 pass 的结果 (没有就是 nullptr)
+  int width, height;  // 画进纹理时的尺寸，0 表示和输入一样 (或者输出尺寸)
+  int tag;            // 计时时记下，结果出来和耗时一起交给 onTimed
+  //? area 是画的像素占输出的比例
+  std::function<void(float ms, int tag, float area)> onTimed;
+  float gpuMs;  // 平滑后的耗时，关掉以后保留最后的值
+};
+
+//? 返回下标，也就是执行顺序
+int RenderGraphAddPass(const char* name, const RenderPassFn& execute);
+RenderPass& RenderGraphPass(int index);
+int RenderGraphPassCount();
+
+//? framebuffer 是这一帧的输出 (窗口是 0)，结束时绑回它和整个 viewport
+void RenderGraphExecute(GLuint framebuffer, int width, int height);
+
+//? 池里有几张纹理
+int RenderGraphPoolSize();
+
+//? 删掉池里的纹理和查询，要在上下文还在时调用
+void RenderGraphRelease();
@@ -0,0 +1,153 @@
+#include "sdf.h"
+
+#include <math.h>
+
+#include <vector>
+
+namespace {
+
+const float INF = 1e20f;
+
+// Felzenszwalb & Huttenlocher 的一维平方距离变换，O(n)
+// f 是采样值，d 输出，v/z 是工作区 (v: n, z: n + 1)
+void Transform1D(const float* f, float* d, int n, int* v, float* z) {
+  int k = 0;
+  v[0] = 0;
+  z[0] = -INF;
+  z[1] = INF;
+  for (int q = 1; q < n; q++) {
+    float s;
+    while (true) {
+      int p = v[k];
+      s = ((f[q] + q * q) - (f[p] + p * p)) / (2.0f * (q - p));
+      if (s > z[k] || k == 0) break;
+      k--;
+    }
+    if (s <= z[k]) {
+      // k == 0 且新抛物线完全盖住了旧的
+      v[0] = q;
+      z[1] = INF;
+      continue;
+    }
+    k++;
+    v[k] = q;
+    z[k] = s;
+    z[k + 1] = INF;
+  }
+
+  k = 0;
+  for (int q = 0; q < n; q++) {
+    while (z[k + 1] < q) k++;
+    int p = v[k];
+    d[q] = (q - p) * (q - p) + f[p];
+  }
+}
+
+// grid 里 0 是种子，INF 是其他点；原地变成到最近种子的平方距离
+void Transform2D(float* grid, int width, int height) {
+  int n = width > height ? width : height;
+  std::vector<float> f(n), d(n), z(n + 1);
+  std::vector<int> v(n);
+
+  for (int x = 0; x < width; x++) {
+    for (int y = 0; y < height; y++) f[y] = grid[y * width + x];
+    Transform1D(f.data(), d.data(), height, v.data(), z.data());
+    for (int y = 0; y < height; y++) grid[y * width + x] = d[y];
+  }
+  for (int y = 0; y < height; y++) {
+    float* row = grid + y * width;
+    for (int x = 0; x < width; x++) f[x] = row[x];
+    Transform1D(f.data(), row, width, v.data(), z.data());
+  }
+}
+
+}  // namespace
+
+void BuildDistanceField(const unsigned char* coverage, int width, int height,
+                        int factor, float spread, unsigned char* out,
+                        int outPitch) {
+  int hiWidth = width * factor;
+  int hiHeight = height * factor;
+  int count = hiWidth * hiHeight;
+
+  //? 分别算到最近的内部点和最近的外部点的距离，相减就是有向距离
+  std::vector<float> outside(count), inside(count);
+  for (int i = 0; i < count; i++) {
+    bool in = coverage[i] >= 128;
+    outside[i] = in ? 0.0f : INF;
+    inside[i] = in ? INF : 0.0f;
+  }
+  Transform2D(outside.data(), hiWidth, hiHeight);
+  Transform2D(inside.data(), hiWidth, hiHeight);
+
+  // 取每个输出像素中心对应的高分辨率像素，距离换算成输出像素
+  // 距离量到的是像素中心，边缘在两个像素中间，所以各减半个像素
+  float toOut = 1.0f / factor;
+  for (int y = 0; y < height; y++) {
+    int hy = y * factor + factor / 2;
+    for (int x = 0; x < width; x++) {
+      int i = hy * hiWidth + x * factor + factor / 2;
+      float dist = inside[i] > 0.0f ? sqrtf(inside[i]) - 0.5f
+                                    : 0.5f - sqrtf(outside[i]);
+      dist *= toOut;
+      float value = 128.0f + dist / spread * 127.0f;
+      value = value < 0.0f ? 0.0f : (value > 255.0f ? 255.0f : value);
+      out[y * outPitch + x] = (unsigned char)(value + 0.5f);
+    }
+  }
+}
+
+void BuildBitmapDistanceField(const unsigned char rows[8], int texelScale,
+                              int padding, float spread, unsigned char* out,
+                              int outPitch) {
+  // 点阵外面一圈当作空白，内部点到字形外框的距离也算进去
+  bool set[10][10] = {};
+  for (int j = 0; j < 8; j++) {
+    for (int i = 0; i < 8; i++) set[j + 1][i + 1] = rows[j] & (0x80 >> i);
+  }
+
+  // 超过 spread 的距离都会饱和，只需要看附近几格
+  int reach = (int)ceilf(spread / texelScale) + 1;
+  int size = 8 * texelScale + 2 * padding;
+
+  // 输出像素中心到每一列/行正方形的距离平方，x 和 y 是同一张表
+  // cell 是中心所在的格子 (set 的下标，比点阵坐标大 1)
+  std::vector<float> d2(size * 10);
+  std::vector<int> cell(size);
+  for (int t = 0; t < size; t++) {
+    float f = (t - padding + 0.5f) / texelScale;
+    cell[t] = (int)floorf(f) + 1;
+    for (int k = 0; k < 10; k++) {
+      float d = fmaxf(fmaxf(k - 1 - f, f - k), 0.0f);
+      d2[t * 10 + k] = d * d;
+    }
+  }
+
+  for (int y = 0; y < size; y++) {
+    const float* dy2 = &d2[y * 10];
+    int cy = cell[y];
+    int j0 = cy - reach < 0 ? 0 : cy - reach;
+    int j1 = cy + reach > 9 ? 9 : cy + reach;
+    for (int x = 0; x < size; x++) {
+      const float* dx2 = &d2[x * 10];
+      int cx = cell[x];
+      bool in = cx >= 1 && cx <= 8 && cy >= 1 && cy <= 8 && set[cy][cx];
+
+      // 到最近的另一种 (内部点找空白，外部点找实心) 正方形的距离
+      int i0 = cx - reach < 0 ? 0 : cx - reach;
+      int i1 = cx + reach > 9 ? 9 : cx + reach;
+      float best = INF;
+      for (int j = j0; j <= j1; j++) {
+        for (int i = i0; i <= i1; i++) {
+          if (set[j][i] != in) best = fminf(best, dx2[i] + dy2[j]);
+        }
+      }
+
+      float dist = sqrtf(best) * texelScale;
+      if (!in) dist = -dist;
+      float value = 128.0f + dist / spread * 127.0f;
+      value = value < 0.0f ? 0.0f : (value > 255.0f ? 255.0f : value);
+      out[y * outPitch + x] = (unsigned char)(value + 0.5f);
+    }
+  }
+}
@@ -0,0 +1,17 @@
+#pragma once
+
+//& 有向距离场: 文字用，一份小图集可以放大到任意倍数
+
+//? coverage 是 (width * factor) x (height * factor) 的高分辨率覆盖率图
+//? (>= 128 算在字形内)，缩小 factor 倍后写成 width x height 的 8 位距离场
+//? 128 是边缘，内部更大；离边缘 spread 个输出像素以外饱和到 0 或 255
+void BuildDistanceField(const unsigned char* coverage, int width, int height,
+                        int factor, float spread, unsigned char* out,
+                        int outPitch);
+
+//? rows 是 8x8 点阵 (每行一个字节，最高位在左)，每个点放大成 texelScale
+//? 个输出像素，四周再留 padding 个像素，编码和上面一样
+//? 点阵字形就是一堆单位正方形，直接算到正方形的距离，是精确的
+void BuildBitmapDistanceField(const unsigned char rows[8], int texelScale,
+                              int padding, float spread, unsigned char* out,
+                              int outPitch);
@@ -0,0 +1,451 @@
+#include "softrender.h"
+
+#include <math.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include <algorithm>
+#include <vector>
+
+#include "parallel.h"
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+namespace {
+
+const uint32_t kClearColor = 0xFF1A1A1A;      // glClearColor(0.1, 0.1, 0.1)
+const uint32_t kSelectionColor = 0xFFFFCC00;  // vec4(1.0, 0.8, 0.0, 1.0)
+const uint32_t kLoupeBorderColor = 0xFFE6E6E6;  // vec4(0.9, 0.9, 0.9, 1.0)
+const int kTextVertexFloats = 7;              // x y u v r g b
+
+//? 一行里第 x 列像素中心对应的截图坐标是 base + x * step (线性)
+struct RowMap {
+  float base, step;
+  float at(int x) const { return base + x * step; }
+};
+
+//? 满足 lo <= map.at(x) < hi 的列 [begin, end)，先估算再用同一个式子修正
+void ColumnRange(const RowMap& map, float lo, float hi, int width, int& begin,
+                 int& end) {
+  auto first = [&](float bound) {
+    double guess = ceil((bound - map.base) / (double)map.step);
+    int x = guess < 0 ? 0 : guess > width ? width : (int)guess;
+    while (x > 0 && map.at(x - 1) >= bound) x--;
+    while (x < width && map.at(x) < bound) x++;
+    return x;
+  };
+  begin = first(lo);
+  end = first(hi);
+  if (end < begin) end = begin;
+}
+
+void Fill(uint32_t* dst, int n, uint32_t value) {
+  for (int i = 0; i < n; i++) dst[i] = value;
+}
+
+//? 最近邻: 每列取哪个像素整帧不变，先用 SIMD 算好下标，每行只剩查表
+void BuildNearestColumns(const RowMap& map, int width, int begin, int end,
+                         std::vector<int>& columns) {
+  columns.resize(end - begin);
+  int* index = columns.data() - begin;
+  int x = begin;
+#ifdef __SSE2__
+  __m128 step = _mm_set1_ps(map.step);
+  __m128 base = _mm_set1_ps(map.base);
+  __m128 offset = _mm_setr_ps(0, 1, 2, 3);
+  __m128i last = _mm_set1_epi32(width - 1);
+  for (; x + 4 <= end; x += 4) {
+    __m128 xs = _mm_add_ps(_mm_set1_ps((float)x), offset);
+    __m128i i = _mm_cvttps_epi32(_mm_add_ps(base, _mm_mul_ps(xs, step)));
+    // 只可能因为舍入超出一点，截到最后一列
+    __m128i over = _mm_cmpgt_epi32(i, last);
+    i = _mm_or_si128(_mm_andnot_si128(over, i), _mm_and_si128(over, last));
+    _mm_storeu_si128((__m128i*)(index + x), i);
+  }
+#endif
+  for (; x < end; x++) {
+    int i = (int)map.at(x);
+    index[x] = i < width ? i : width - 1;
+  }
+}
+
+void SampleNearest(const uint32_t* row, const std::vector<int>& columns,
+                   int begin, int end, uint32_t* dst) {
+  const int* index = columns.data() - begin;
+  for (int x = begin; x < end; x++) dst[x] = row[index[x]];
+}
+
+//? 双线性，和 GL_LINEAR + GL_CLAMP_TO_BORDER 一样: 截图外的像素是透明黑
+//? 缩小时没有 mipmap，只从第 0 级取
+//? 每一列的左像素和权重整帧不变，先算好；每行先把用到的像素竖着插值成
+//? 16 位通道放进 temp (下标 +1，两头各留一个 0 像素)，再横着两两插值
+struct BilinearColumns {
+  std::vector<int> left;       // 左边像素的下标，-1 表示在截图外
+  std::vector<int16_t> weight;  // 每列 8 个通道: 4 个 256 - wx，4 个 wx
+};
+
+void BuildBilinearColumns(const RowMap& map, int begin, int end,
+                          BilinearColumns& columns) {
+  columns.left.resize(end - begin);
+  columns.weight.resize((end - begin) * 8);
+  for (int x = begin; x < end; x++) {
+    float sx = map.at(x) - 0.5f;
+    int x0 = (int)floorf(sx);
+    int wx = (int)((sx - x0) * 256.0f + 0.5f);
+    columns.left[x - begin] = x0;
+    int16_t* w = &columns.weight[(x - begin) * 8];
+    for (int c = 0; c < 4; c++) {
+      w[c] = (int16_t)(256 - wx);
+      w[c + 4] = (int16_t)wx;
+    }
+  }
+}
+
+//? temp[i + 1] = 第 y0 行和 y0 + 1 行的第 i 个像素按 wy 插值，i 在 [lo, hi]
+void BlendRows(const uint32_t* row0, const uint32_t* row1, int wy, int lo,
+               int hi, uint16_t* temp) {
+  int i = lo;
+#ifdef __SSE2__
+  __m128i zero = _mm_setzero_si128();
+  __m128i round = _mm_set1_epi16(128);
+  __m128i w0 = _mm_set1_epi16((short)(256 - wy));
+  __m128i w1 = _mm_set1_epi16((short)wy);
+  // 16 位通道，最大 255 * 256 + 128，不会溢出无符号
+  for (; i + 4 <= hi + 1; i += 4) {
+    __m128i a = _mm_loadu_si128((const __m128i*)(row0 + i));
+    __m128i b = _mm_loadu_si128((const __m128i*)(row1 + i));
+    __m128i lo16 = _mm_add_epi16(
+        _mm_add_epi16(_mm_mullo_epi16(_mm_unpacklo_epi8(a, zero), w0),
+                      _mm_mullo_epi16(_mm_unpacklo_epi8(b, zero), w1)),
+        round);
+    __m128i hi16 = _mm_add_epi16(
+        _mm_add_epi16(_mm_mullo_epi16(_mm_unpackhi_epi8(a, zero), w0),
+                      _mm_mullo_epi16(_mm_unpackhi_epi8(b, zero), w1)),
+        round);
+    _mm_storeu_si128((__m128i*)(temp + (i + 1) * 4), _mm_srli_epi16(lo16, 8));
+    _mm_storeu_si128((__m128i*)(temp + (i + 3) * 4), _mm_srli_epi16(hi16, 8));
+  }
+#endif
+  for (; i <= hi; i++) {
+    for (int c = 0; c < 4; c++) {
+      int a = (row0[i] >> (c * 8)) & 0xFF;
+      int b = (row1[i] >> (c * 8)) & 0xFF;
+      temp[(i + 1) * 4 + c] = (uint16_t)((a * (256 - wy) + b * wy + 128) >> 8);
+    }
+  }
+}
+
+void SampleBilinear(const uint32_t* image, const uint32_t* zeroRow, int width,
+                    int height, const BilinearColumns& columns, float v,
+                    int begin, int end, uint16_t* temp, uint32_t* dst) {
+  float sy = v - 0.5f;
+  int y0 = (int)floorf(sy);
+  int wy = (int)((sy - y0) * 256.0f + 0.5f);
+  const uint32_t* row0 = y0 >= 0 && y0 < height ? image + y0 * width : zeroRow;
+  const uint32_t* row1 =
+      y0 + 1 >= 0 && y0 + 1 < height ? image + (y0 + 1) * width : zeroRow;
+
+  // 这一行用到的像素 [lo, hi]，截图外的两个位置固定是 0
+  int lo = columns.left.front(), hi = columns.left.back() + 1;
+  memset(temp, 0, 4 * sizeof(uint16_t));
+  memset(temp + (width + 1) * 4, 0, 4 * sizeof(uint16_t));
+  BlendRows(row0, row1, wy, lo < 0 ? 0 : lo, hi >= width ? width - 1 : hi,
+            temp);
+
+  const int* left = columns.left.data() - begin;
+  const int16_t* weight = columns.weight.data() - begin * 8;
+  int x = begin;
+#ifdef __SSE2__
+  // 一次两个输出像素，各自的左右像素乘上权重后把高低 64 位相加
+  __m128i round = _mm_set1_epi16(128);
+  for (; x + 2 <= end; x += 2) {
+    __m128i p0 = _mm_loadu_si128((const __m128i*)(temp + (left[x] + 1) * 4));
+    __m128i p1 =
+        _mm_loadu_si128((const __m128i*)(temp + (left[x + 1] + 1) * 4));
+    p0 = _mm_mullo_epi16(p0, _mm_loadu_si128((const __m128i*)(weight + x * 8)));
+    p1 = _mm_mullo_epi16(
+        p1, _mm_loadu_si128((const __m128i*)(weight + (x + 1) * 8)));
+    __m128i sum = _mm_add_epi16(_mm_unpacklo_epi64(p0, p1),
+                                _mm_unpackhi_epi64(p0, p1));
+    sum = _mm_srli_epi16(_mm_add_epi16(sum, round), 8);
+    _mm_storel_epi64((__m128i*)(dst + x), _mm_packus_epi16(sum, sum));
+  }
+#endif
+  for (; x < end; x++) {
+    const uint16_t* p = temp + (left[x] + 1) * 4;
+    const int16_t* w = weight + x * 8;
+    uint32_t out = 0;
+    for (int c = 0; c < 4; c++) {
+      out |= (uint32_t)((p[c] * w[c] + p[c + 4] * w[c + 4] + 128) >> 8)
+             << (c * 8);
+    }
+    dst[x] = out;
+  }
+}
+
+//? 手电筒外面的阴影: mix(color, 0, shadow) 之后还要按 alpha = 1 - shadow
+//? 混合到清屏色上 (GL_BLEND 一直开着)，截图的 alpha 是 255，所以合起来是
+//? color * (1 - shadow)^2 + clear * shadow
+//? k 是 8 位定点的 (1 - shadow)^2，add 是每个通道的 clear * shadow
+void Shade(uint32_t* dst, int n, int k, uint32_t add) {
+  int i = 0;
+#ifdef __SSE2__
+  __m128i zero = _mm_setzero_si128();
+  __m128i round = _mm_set1_epi16(128);
+  __m128i scale = _mm_set1_epi16((short)k);
+  __m128i offset = _mm_unpacklo_epi8(_mm_set1_epi32((int)add), zero);
+  for (; i + 4 <= n; i += 4) {
+    __m128i p = _mm_loadu_si128((const __m128i*)(dst + i));
+    __m128i lo = _mm_mullo_epi16(_mm_unpacklo_epi8(p, zero), scale);
+    __m128i hi = _mm_mullo_epi16(_mm_unpackhi_epi8(p, zero), scale);
+    lo = _mm_add_epi16(_mm_srli_epi16(_mm_add_epi16(lo, round), 8), offset);
+    hi = _mm_add_epi16(_mm_srli_epi16(_mm_add_epi16(hi, round), 8), offset);
+    _mm_storeu_si128((__m128i*)(dst + i), _mm_packus_epi16(lo, hi));
+  }
+#endif
+  for (; i < n; i++) {
+    uint32_t p = dst[i], out = 0;
+    for (int shift = 0; shift < 32; shift += 8) {
+      int c = ((((p >> shift) & 0xFF) * k + 128) >> 8) +
+              (int)((add >> shift) & 0xFF);
+      out |= (uint32_t)(c > 255 ? 255 : c) << shift;
+    }
+    dst[i] = out;
+  }
+}
+
+//? 整帧共用的东西: 列的映射只和相机有关，每行都一样
+struct Frame {
+  const SoftScreenParams* params;
+  RowMap map;
+  int clipBegin, clipEnd;  // 要写的列
+  int begin, end;  // 其中截图四边形盖住的列，其余是清屏色
+  std::vector<int> nearest;
+  BilinearColumns columns;
+  std::vector<uint32_t> zeroRow;  // 截图上下之外的一行 (透明黑)
+};
+
+void RenderRow(const Frame& frame, int y, uint16_t* temp, uint32_t* dst) {
+  const SoftScreenParams& p = *frame.params;
+  int width = p.width;
+  float s = p.cameraScale;
+  float halfH = p.height * 0.5f;
+  int begin = frame.begin, end = frame.end;
+
+  // 和 vertexShader 相反的变换，像素中心在 +0.5
+  float fy = y + 0.5f;
+  float v = (fy - halfH) / s + halfH - p.cameraY;
+  int clipBegin = frame.clipBegin, clipEnd = frame.clipEnd;
+  if (!(v >= 0 && v < p.height) || begin == end) {
+    Fill(dst + clipBegin, clipEnd - clipBegin, kClearColor);
+    return;
+  }
+  Fill(dst + clipBegin, begin - clipBegin, kClearColor);
+  Fill(dst + end, clipEnd - end, kClearColor);
+
+  const uint32_t* image = (const uint32_t*)p.image;
+  if (p.bilinear) {
+    SampleBilinear(image, frame.zeroRow.data(), width, p.height,
+                   frame.columns, v, begin, end, temp, dst);
+  } else {
+    int iy = (int)v < p.height ? (int)v : p.height - 1;
+    SampleNearest(image + iy * width, frame.nearest, begin, end, dst);
+  }
+
+  // 圆内 (length < flRadius * cameraScale) 不加阴影，一行里是一段连续的列
+  float lit = 1.0f - p.flShadow;
+  int k = (int)(lit * lit * 256.0f + 0.5f);
+  if (k < 256) {
+    uint32_t add = 0;
+    for (int shift = 0; shift < 32; shift += 8) {
+      float clear = (float)((kClearColor >> shift) & 0xFF);
+      add |= (uint32_t)(clear * p.flShadow + 0.5f) << shift;
+    }
+    int litBegin = begin, litEnd = begin;
+    float radius = p.flRadius * s;
+    float dy = fy - p.cursorY;
+    if (dy * dy < radius * radius) {
+      float half = sqrtf(radius * radius - dy * dy);
+      litBegin = (int)floorf(p.cursorX - half - 0.5f) + 1;
+      litEnd = (int)ceilf(p.cursorX + half - 0.5f);
+      litBegin = litBegin < begin ? begin : litBegin > end ? end : litBegin;
+      litEnd = litEnd < litBegin ? litBegin : litEnd > end ? end : litEnd;
+    }
+    Shade(dst + begin, litBegin - begin, k, add);
+    Shade(dst + litEnd, end - litEnd, k, add);
+  }
+
+  // 选区边框: 外扩 1 / cameraScale 的框减去选区本身
+  const float* sel = p.selection;
+  if (sel && (sel[2] > sel[0] || sel[3] > sel[1])) {
+    float edge = 1.0f / s;
+    if (v >= sel[1] - edge && v < sel[3] + edge) {
+      int outerBegin, outerEnd, innerBegin = 0, innerEnd = 0;
+      ColumnRange(frame.map, sel[0] - edge, sel[2] + edge, width, outerBegin,
+                  outerEnd);
+      if (v >= sel[1] && v < sel[3]) {
+        ColumnRange(frame.map, sel[0], sel[2], width, innerBegin, innerEnd);
+      }
+      if (outerBegin < begin) outerBegin = begin;
+      if (outerEnd > end) outerEnd = end;
+      for (int x = outerBegin; x < outerEnd; x++) {
+        if (x < innerBegin || x >= innerEnd) dst[x] = kSelectionColor;
+      }
+    }
+  }
+}
+
+//? 距离场图集的双线性采样 (GL_LINEAR + GL_CLAMP_TO_EDGE)，返回 0..1
+float SampleAtlas(const unsigned char* atlas, int width, int height, float u,
+                  float v) {
+  float x = u * width - 0.5f;
+  float y = v * height - 0.5f;
+  int x0 = (int)floorf(x), y0 = (int)floorf(y);
+  float fx = x - x0, fy = y - y0;
+  int x1 = x0 + 1, y1 = y0 + 1;
+  x0 = x0 < 0 ? 0 : x0 >= width ? width - 1 : x0;
+  x1 = x1 < 0 ? 0 : x1 >= width ? width - 1 : x1;
+  y0 = y0 < 0 ? 0 : y0 >= height ? height - 1 : y0;
+  y1 = y1 < 0 ? 0 : y1 >= height ? height - 1 : y1;
+  float top = atlas[y0 * width + x0] * (1 - fx) + atlas[y0 * width + x1] * fx;
+  float bottom =
+      atlas[y1 * width + x0] * (1 - fx) + atlas[y1 * width + x1] * fx;
+  return (top * (1 - fy) + bottom * fy) / 255.0f;
+}
+
+}  // namespace
+
+void SoftRenderScreen(const SoftScreenParams& params, unsigned char* target,
+                      int pitch) {
+  int width = params.width;
+  float s = params.cameraScale;
+  float halfW = width * 0.5f;
+
+  Frame frame;
+  frame.params = &params;
+  frame.map.step = 1.0f / s;
+  frame.map.base = (0.5f - halfW) / s + halfW + params.cameraX;
+  ColumnRange(frame.map, 0.0f, (float)width, width, frame.begin, frame.end);
+  const int* clip = params.clip;
+  frame.clipBegin = clip[0];
+  frame.clipEnd = clip[2];
+  frame.begin = std::min(std::max(frame.begin, clip[0]), clip[2]);
+  frame.end = std::min(std::max(frame.end, frame.begin), clip[2]);
+  if (frame.begin < frame.end) {
+    if (params.bilinear) {
+      BuildBilinearColumns(frame.map, frame.begin, frame.end, frame.columns);
+      frame.zeroRow.assign(width, 0);
+    } else {
+      BuildNearestColumns(frame.map, width, frame.begin, frame.end,
+                          frame.nearest);
+    }
+  }
+
+  ParallelFor(clip[1], clip[3], [&](int begin, int end) {
+    std::vector<uint16_t> temp(params.bilinear ? (width + 2) * 4 : 0);
+    for (int y = begin; y < end; y++) {
+      RenderRow(frame, y, temp.data(),
+                (uint32_t*)(target + (ptrdiff_t)y * pitch));
+    }
+  });
+}
+
+//? 和 textfragmentShader 一样: 128/255 是边缘，过渡宽度取相邻像素的距离差
+//? HUD 只有几百个字形，不值得分线程
+void SoftRenderText(const float* vertices, int vertexCount,
+                    const unsigned char* atlas, int atlasWidth,
+                    int atlasHeight, unsigned char* target, int pitch,
+                    const int clip[4]) {
+  const float edge = 128.0f / 255.0f;
+  for (int q = 0; q + 6 <= vertexCount; q += 6) {
+    // 第 1 个顶点是左下 (u0, v1)，第 5 个是右上 (u1, v0)
+    const float* lo = vertices + (q + 1) * kTextVertexFloats;
+    const float* hi = vertices + (q + 5) * kTextVertexFloats;
+    float x0 = lo[0], y0 = lo[1], x1 = hi[0], y1 = hi[1];
+    if (x1 <= x0 || y1 <= y0) continue;
+    float du = (hi[2] - lo[2]) / (x1 - x0);
+    float dv = (hi[3] - lo[3]) / (y1 - y0);
+
+    int px0 = (int)ceilf(x0 - 0.5f), px1 = (int)ceilf(x1 - 0.5f);
+    int py0 = (int)ceilf(y0 - 0.5f), py1 = (int)ceilf(y1 - 0.5f);
+    if (px0 < clip[0]) px0 = clip[0];
+    if (py0 < clip[1]) py0 = clip[1];
+    if (px1 > clip[2]) px1 = clip[2];
+    if (py1 > clip[3]) py1 = clip[3];
+
+    float color[3] = {lo[6] * 255.0f, lo[5] * 255.0f, lo[4] * 255.0f};  // BGR
+    for (int py = py0; py < py1; py++) {
+      float v = lo[3] + (py + 0.5f - y0) * dv;
+      unsigned char* row = target + (ptrdiff_t)py * pitch + px0 * 4;
+      for (int px = px0; px < px1; px++, row += 4) {
+        float u = lo[2] + (px + 0.5f - x0) * du;
+        float dist = SampleAtlas(atlas, atlasWidth, atlasHeight, u, v);
+        float ddx =
+            SampleAtlas(atlas, atlasWidth, atlasHeight, u + du, v) - dist;
+        float ddy =
+            SampleAtlas(atlas, atlasWidth, atlasHeight, u, v + dv) - dist;
+        float w = 0.5f * (fabsf(ddx) + fabsf(ddy));
+
+        float alpha;
+        if (w < 1e-6f) {
+          alpha = dist >= edge ? 1.0f : 0.0f;
+        } else {
+          float t = (dist - (edge - w)) / (2.0f * w);
+          t = t < 0 ? 0 : t > 1 ? 1 : t;
+          alpha = t * t * (3.0f - 2.0f * t);
+        }
+        if (alpha <= 0.0f) continue;
+        for (int c = 0; c < 3; c++) {
+          row[c] = (unsigned char)(color[c] * alpha + row[c] * (1 - alpha) +
+                                   0.5f);
+        }
+      }
+    }
+  }
+}
+
+//? 只有几万个像素，逐个算格子，不分线程
+void SoftRenderLoupe(const SoftLoupeParams& params, unsigned char* target,
+                     int pitch, const int clip[4]) {
+  const uint32_t* image = (const uint32_t*)params.image;
+  int x0 = std::max(params.rect[0], clip[0]);
+  int y0 = std::max(params.rect[1], clip[1]);
+  int x1 = std::min(params.rect[2], clip[2]);
+  int y1 = std::min(params.rect[3], clip[3]);
+  int zoom = params.zoom, half = params.cells / 2;
+  int inner = params.cells * zoom;
+  for (int y = y0; y < y1; y++) {
+    uint32_t* row = (uint32_t*)(target + (ptrdiff_t)y * pitch);
+    int ly = y - params.rect[1] - params.border;
+    for (int x = x0; x < x1; x++) {
+      int lx = x - params.rect[0] - params.border;
+      if (lx < 0 || ly < 0 || lx >= inner || ly >= inner) {
+        row[x] = kLoupeBorderColor;
+        continue;
+      }
+      int cx = lx / zoom, cy = ly / zoom;
+      int sx = params.centerX + cx - half, sy = params.centerY + cy - half;
+      uint32_t color = kClearColor;
+      if (sx >= 0 && sx < params.width && sy >= 0 && sy < params.height) {
+        color = image[sy * params.width + sx] | 0xFF000000;
+      }
+      int ix = lx - cx * zoom, iy = ly - cy * zoom;
+      bool edge = ix < 1 || iy < 1;
+      if (edge) {
+        uint32_t dark = 0xFF000000;
+        for (int shift = 0; shift < 24; shift += 8) {
+          dark |= (((color >> shift) & 0xFF) * 6 + 5) / 10 << shift;
+        }
+        color = dark;
+      }
+      if (cx == half && cy == half &&
+          (edge || ix >= zoom - 1 || iy >= zoom - 1)) {
+        color = kSelectionColor;
+      }
+      row[x] = color;
+    }
+  }
+}
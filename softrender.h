@@ -0,0 +1,42 @@
+#pragma once
+
+//& 软件渲染: 没有可用的 OpenGL 时在 CPU 上画出和 shader 一样的画面
+//? 目标缓冲是 BGRA，target 指向第 0 行 (最下面一行，和纹理一样)，
+//? pitch 是到上一行的字节数: 自下而上的 DIB 是正数，自上而下的 XImage 是负数
+//? 目标和截图一样大 (整个桌面)，坐标换算和 vertexShader / fragmentShader 一致
+//? clip 是目标坐标 (y 向上) 的 x0 y0 x1 y1，只写这个矩形，一般是当前输出
+
+struct SoftScreenParams {
+  const unsigned char* image;  // 截图
+  int width, height;           // 截图和目标的尺寸
+  float cameraX, cameraY, cameraScale;
+  bool bilinear;             // 否则最近邻
+  float cursorX, cursorY;    // 手电筒中心，窗口坐标 (y 向上)
+  float flRadius, flShadow;  // 同 shader 的 flRadius / flShadow
+  const float* selection;    // 截图坐标 x0 y0 x1 y1，宽高都是 0 表示没有选区
+  int clip[4];
+};
+
+//? clip 里都会被写一遍 (截图以外是清屏色)，按行交给 ParallelFor
+void SoftRenderScreen(const SoftScreenParams& params, unsigned char* target,
+                      int pitch);
+
+//? 把 HUD 的字形四边形 (每个 6 个顶点，x y u v r g b) 混合到目标上
+//? atlas 是距离场图集的 CPU 副本，一个字节一个像素，clip 同上
+void SoftRenderText(const float* vertices, int vertexCount,
+                    const unsigned char* atlas, int atlasWidth,
+                    int atlasHeight, unsigned char* target, int pitch,
+                    const int clip[4]);
+
+//? 放大镜，和 loupeFragShader 一样: rect 是目标坐标 (y 向上) 的
+//? x0 y0 x1 y1 (含边框)，正中那格是截图的 (centerX, centerY)，clip 同上
+struct SoftLoupeParams {
+  const unsigned char* image;  // 截图
+  int width, height;
+  int rect[4];
+  int centerX, centerY;
+  int cells, zoom, border;
+};
+
+void SoftRenderLoupe(const SoftLoupeParams& params, unsigned char* target,
+                     int pitch, const int clip[4]);
@@ -0,0 +1,87 @@
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+//& 比较两张 BMP (colorpicker-headless --dump 的输出)，给 make render-test 用
+//? 打印最大的通道差、差超过 SOFT_DIFF 的像素数，超出容差时返回 1
+//? 容差是 GL 和软件渲染之间的: 截图的缩放、手电筒、放大镜逐像素一致，
+//? 只有 HUD 文字的距离场在字形边缘插值不同 (GL 按纹理单元插值，软件按
+//? 浮点重新算)，实测最多差 36 级，涉及约 0.11% 的像素
+
+//? 任何像素任何通道的差都不能超过这个值
+#define MAX_DIFF 48
+//? 差超过 SOFT_DIFF 的像素不能多于 MAX_SHARE
+#define SOFT_DIFF 8
+#define MAX_SHARE 0.005
+
+//? 只读 24 / 32 位不压缩的 BMP，行序不管 (两张图一样就行)
+static bool ReadBmp(const char* path, int& width, int& height,
+                    std::vector<unsigned char>& rgb) {
+  FILE* f = fopen(path, "rb");
+  if (!f) return false;
+  unsigned char header[54];
+  bool ok = false;
+  if (fread(header, 1, sizeof(header), f) == sizeof(header) &&
+      header[0] == 'B' && header[1] == 'M') {
+    auto get32 = [&](int offset) {
+      return (int)(header[offset] | header[offset + 1] << 8 |
+                   header[offset + 2] << 16 | header[offset + 3] << 24);
+    };
+    int offset = get32(10);
+    int bpp = header[28];
+    width = get32(18);
+    height = abs(get32(22));
+    if (width > 0 && (bpp == 24 || bpp == 32) && get32(30) == 0) {
+      int stride = (width * (bpp / 8) + 3) & ~3;
+      std::vector<unsigned char> row(stride);
+      rgb.resize((size_t)width * height * 3);
+      fseek(f, offset, SEEK_SET);
+      ok = true;
+      for (int y = 0; y < height && ok; y++) {
+        ok = fread(row.data(), 1, stride, f) == (size_t)stride;
+        for (int x = 0; x < width; x++) {
+          memcpy(&rgb[((size_t)y * width + x) * 3], &row[x * (bpp / 8)], 3);
+        }
+      }
+    }
+  }
+  fclose(f);
+  return ok;
+}
+
+int main(int argc, char** argv) {
+  if (argc != 3) {
+    fprintf(stderr, "usage: bmpdiff a.bmp b.bmp\n");
+    return 2;
+  }
+  int w0, h0, w1, h1;
+  std::vector<unsigned char> a, b;
+  if (!ReadBmp(argv[1], w0, h0, a) || !ReadBmp(argv[2], w1, h1, b)) {
+    fprintf(stderr, "bmpdiff: failed to read %s or %s\n", argv[1], argv[2]);
+    return 2;
+  }
+  if (w0 != w1 || h0 != h1) {
+    printf("%s: size %dx%d vs %dx%d\n", argv[1], w0, h0, w1, h1);
+    return 1;
+  }
+
+  int maxDiff = 0;
+  size_t over = 0;
+  size_t count = (size_t)w0 * h0;
+  for (size_t i = 0; i < count; i++) {
+    int diff = 0;
+    for (int c = 0; c < 3; c++) {
+      diff = std::max(diff, abs(a[i * 3 + c] - b[i * 3 + c]));
+    }
+    maxDiff = std::max(maxDiff, diff);
+    if (diff > SOFT_DIFF) over++;
+  }
+
+  double share = (double)over / count;
+  bool pass = maxDiff <= MAX_DIFF && share <= MAX_SHARE;
+  printf("%s: max diff %d, %zu pixels (%.3f%%) over %d -> %s\n", argv[1],
+         maxDiff, over, share * 100, SOFT_DIFF, pass ? "ok" : "FAIL");
+  return pass ? 0 : 1;
+}
@@ -0,0 +1,467 @@
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+#include "color.h"
+#include "test.h"
+
+//& color.cpp 的批量转换和双精度的逐像素参考实现对比
+//? 参考实现按教科书的写法 (fmod、cbrt、pow、分支)，和内核没有共用代码
+//? 内核用 -O3 -fno-trapping-math 编译，立方根是近似的，所以逐值比较有容差；
+//? 另外 8 位颜色经过 "转过去再转回来" 必须一个不差地回到原值
+
+namespace {
+
+typedef void (*Kernel)(ColorSpan in, size_t count, ColorSpan out);
+typedef void (*Reference)(const double in[3], double out[3]);
+
+const double kLabEpsilon = 216.0 / 24389.0;
+const double kLabKappa = 24389.0 / 27.0;
+const double kWhite[3] = {0.95047, 1.0, 1.08883};
+
+double RefDecode(double c) {
+  return c <= 0.04045 ? c / 12.92 : pow((c + 0.055) / 1.055, 2.4);
+}
+
+double RefEncode(double c) {
+  return c <= 0.0031308 ? c * 12.92 : 1.055 * pow(c, 1.0 / 2.4) - 0.055;
+}
+
+void RefSrgbToLinear(const double in[3], double out[3]) {
+  for (int c = 0; c < 3; c++) out[c] = RefDecode(in[c]);
+}
+
+void RefLinearToSrgb(const double in[3], double out[3]) {
+  for (int c = 0; c < 3; c++) out[c] = RefEncode(in[c]);
+}
+
+//? 最大通道所在的扇区，和原来的 RGBtoHSV 一样用 fmod
+double RefHue(double r, double g, double b, double maxv, double delta) {
+  if (delta <= 0) return 0;
+  double h;
+  if (maxv == r) {
+    h = fmod((g - b) / delta, 6.0);
+  } else if (maxv == g) {
+    h = (b - r) / delta + 2.0;
+  } else {
+    h = (r - g) / delta + 4.0;
+  }
+  h *= 60.0;
+  return h < 0 ? h + 360.0 : h;
+}
+
+void RefRgbToHsv(const double in[3], double out[3]) {
+  double maxv = fmax(in[0], fmax(in[1], in[2]));
+  double minv = fmin(in[0], fmin(in[1], in[2]));
+  double delta = maxv - minv;
+  out[0] = RefHue(in[0], in[1], in[2], maxv, delta);
+  out[1] = maxv > 0 ? delta / maxv : 0;
+  out[2] = maxv;
+}
+
+//? 六个扇区的 switch
+void RefHsvToRgb(const double in[3], double out[3]) {
+  double h = fmod(in[0] / 60.0, 6.0), s = in[1], v = in[2];
+  if (h < 0) h += 6.0;
+  int sector = (int)floor(h);
+  double f = h - sector;
+  double p = v * (1 - s), q = v * (1 - s * f), t = v * (1 - s * (1 - f));
+  const double table[6][3] = {{v, t, p}, {q, v, p}, {p, v, t},
+                              {p, q, v}, {t, p, v}, {v, p, q}};
+  for (int c = 0; c < 3; c++) out[c] = table[sector % 6][c];
+}
+
+void RefRgbToHsl(const double in[3], double out[3]) {
+  double maxv = fmax(in[0], fmax(in[1], in[2]));
+  double minv = fmin(in[0], fmin(in[1], in[2]));
+  double delta = maxv - minv;
+  double l = (maxv + minv) / 2;
+  double denom = 1 - fabs(2 * l - 1);
+  out[0] = RefHue(in[0], in[1], in[2], maxv, delta);
+  out[1] = delta > 0 && denom > 0 ? delta / denom : 0;
+  out[2] = l;
+}
+
+//? 色度 C、次分量 X、亮度偏移 m 的写法
+void RefHslToRgb(const double in[3], double out[3]) {
+  double h = fmod(in[0] / 60.0, 6.0), s = in[1], l = in[2];
+  if (h < 0) h += 6.0;
+  double chroma = (1 - fabs(2 * l - 1)) * s;
+  double x = chroma * (1 - fabs(fmod(h, 2.0) - 1));
+  double m = l - chroma / 2;
+  const double table[6][3] = {{chroma, x, 0}, {x, chroma, 0},
+                              {0, chroma, x}, {0, x, chroma},
+                              {x, 0, chroma}, {chroma, 0, x}};
+  int sector = (int)floor(h) % 6;
+  for (int c = 0; c < 3; c++) out[c] = table[sector][c] + m;
+}
+
+double RefLabF(double t) {
+  return t > kLabEpsilon ? cbrt(t) : (kLabKappa * t + 16) / 116;
+}
+
+void RefLinearToLab(const double in[3], double out[3]) {
+  double r = in[0], g = in[1], b = in[2];
+  double xyz[3] = {0.4123908 * r + 0.3575843 * g + 0.1804808 * b,
+                   0.2126390 * r + 0.7151687 * g + 0.0721923 * b,
+                   0.0193308 * r + 0.1191948 * g + 0.9505322 * b};
+  double f[3];
+  for (int c = 0; c < 3; c++) f[c] = RefLabF(xyz[c] / kWhite[c]);
+  out[0] = 116 * f[1] - 16;
+  out[1] = 500 * (f[0] - f[1]);
+  out[2] = 200 * (f[1] - f[2]);
+}
+
+void RefLabToLinear(const double in[3], double out[3]) {
+  double fy = (in[0] + 16) / 116;
+  double fx = fy + in[1] / 500;
+  double fz = fy - in[2] / 200;
+  auto finv = [](double f) {
+    double f3 = f * f * f;
+    return f3 > kLabEpsilon ? f3 : (116 * f - 16) / kLabKappa;
+  };
+  double x = finv(fx);
+  double y = in[0] > kLabKappa * kLabEpsilon ? fy * fy * fy : in[0] / kLabKappa;
+  double z = finv(fz);
+  x *= kWhite[0];
+  y *= kWhite[1];
+  z *= kWhite[2];
+  out[0] = 3.2409699 * x - 1.5373832 * y - 0.4986108 * z;
+  out[1] = -0.9692436 * x + 1.8759675 * y + 0.0415551 * z;
+  out[2] = 0.0556301 * x - 0.2039770 * y + 1.0569715 * z;
+}
+
+void RefLinearToOklab(const double in[3], double out[3]) {
+  double r = in[0], g = in[1], b = in[2];
+  double l = cbrt(0.4122214708 * r + 0.5363325363 * g + 0.0514459929 * b);
+  double m = cbrt(0.2119034982 * r + 0.6806995451 * g + 0.1073969566 * b);
+  double s = cbrt(0.0883024619 * r + 0.2817188376 * g + 0.6299787005 * b);
+  out[0] = 0.2104542553 * l + 0.7936177850 * m - 0.0040720468 * s;
+  out[1] = 1.9779984951 * l - 2.4285922050 * m + 0.4505937099 * s;
+  out[2] = 0.0259040371 * l + 0.7827717662 * m - 0.8086757660 * s;
+}
+
+void RefOklabToLinear(const double in[3], double out[3]) {
+  double l = in[0] + 0.3963377774 * in[1] + 0.2158037573 * in[2];
+  double m = in[0] - 0.1055613458 * in[1] - 0.0638541728 * in[2];
+  double s = in[0] - 0.0894841775 * in[1] - 1.2914855480 * in[2];
+  l = l * l * l;
+  m = m * m * m;
+  s = s * s * s;
+  out[0] = 4.0767416621 * l - 3.3077115913 * m + 0.2309699292 * s;
+  out[1] = -1.2684380046 * l + 2.6097574011 * m - 0.3413193965 * s;
+  out[2] = -0.0041960863 * l - 0.7034186147 * m + 1.7076147010 * s;
+}
+
+void RefOklabToOklch(const double in[3], double out[3]) {
+  double h = atan2(in[2], in[1]) * 180 / M_PI;
+  out[0] = in[0];
+  out[1] = hypot(in[1], in[2]);
+  out[2] = h < 0 ? h + 360 : h;
+}
+
+void RefOklchToOklab(const double in[3], double out[3]) {
+  double h = in[2] * M_PI / 180;
+  out[0] = in[0];
+  out[1] = in[1] * cos(h);
+  out[2] = in[1] * sin(h);
+}
+
+//? SoA 的一组颜色
+struct Colors {
+  std::vector<float> c[3];
+
+  size_t size() const { return c[0].size(); }
+  void resize(size_t n) {
+    for (auto& v : c) v.assign(n, 0.0f);
+  }
+  void push(float a, float b, float d) {
+    c[0].push_back(a);
+    c[1].push_back(b);
+    c[2].push_back(d);
+  }
+  ColorSpan span(size_t offset = 0) {
+    return {c[0].data() + offset, c[1].data() + offset, c[2].data() + offset};
+  }
+};
+
+uint32_t Xorshift(uint32_t& state) {
+  state ^= state << 13;
+  state ^= state >> 17;
+  state ^= state << 5;
+  return state;
+}
+
+//? 扫描用的 RGB 输入 (0~1):
+//? 8 位的粗网格、整条灰阶、每个通道单独从 0 到 255 (其余取 0 或 255)、
+//? 分段函数拐点两侧的相邻 float、固定种子的随机值
+Colors RgbSweep() {
+  Colors colors;
+  for (int r = 0; r <= 255; r += 15) {
+    for (int g = 0; g <= 255; g += 15) {
+      for (int b = 0; b <= 255; b += 15) {
+        colors.push(r / 255.0f, g / 255.0f, b / 255.0f);
+      }
+    }
+  }
+  for (int v = 0; v < 256; v++) {
+    float f = v / 255.0f;
+    colors.push(f, f, f);
+    for (float other : {0.0f, 1.0f}) {
+      colors.push(f, other, other);
+      colors.push(other, f, other);
+      colors.push(other, other, f);
+    }
+  }
+  const float edges[] = {0.0f, 1e-7f, 1e-4f, 0.0031308f, 0.04045f,
+                         0.5f, 0.999999f, 1.0f};
+  for (float e : edges) {
+    for (float f : {nextafterf(e, -1.0f), e, nextafterf(e, 2.0f)}) {
+      if (f < 0.0f || f > 1.0f) continue;
+      colors.push(f, f, f);
+      colors.push(f, 0.0f, 1.0f);
+      colors.push(1.0f, f, 0.5f);
+    }
+  }
+  uint32_t state = 12345;
+  for (int i = 0; i < 20000; i++) {
+    float v[3];
+    for (float& x : v) x = (Xorshift(state) >> 8) / 16777215.0f;
+    colors.push(v[0], v[1], v[2]);
+  }
+  return colors;
+}
+
+Colors Convert(Kernel kernel, Colors& in) {
+  Colors out;
+  out.resize(in.size());
+  kernel(in.span(), in.size(), out.span());
+  return out;
+}
+
+//? 色相在圆上比较
+double AngleDiff(double a, double b) {
+  double d = fmod(fabs(a - b), 360.0);
+  return d > 180 ? 360 - d : d;
+}
+
+//? hueChannel 是色相所在的通道 (-1 表示没有)；色度太小时色相不确定，不比
+//? (HSV/HSL 按输入的 max - min 判断，OKLCH 按输入的 a b 判断)
+struct Tolerance {
+  double abs[3];
+  int hueChannel;
+};
+
+//? 整段调用一次 (向量化的主循环)，再用 1~17 的各种长度分段调用 (尾部和不对齐
+//? 的起点)，两次结果都和参考实现比较
+void CheckKernel(const char* name, Kernel kernel, Reference reference,
+                 Colors& in, const Tolerance& tol) {
+  size_t n = in.size();
+  Colors whole = Convert(kernel, in);
+  Colors pieces;
+  pieces.resize(n);
+  for (size_t i = 0, len = 1; i < n; i += len, len = len % 17 + 1) {
+    size_t count = std::min(len, n - i);
+    kernel(in.span(i), count, pieces.span(i));
+  }
+
+  double worst[3] = {};
+  for (size_t i = 0; i < n; i++) {
+    double src[3] = {in.c[0][i], in.c[1][i], in.c[2][i]};
+    double ref[3];
+    reference(src, ref);
+
+    // 色相只在有足够色度时比较
+    bool hueDefined = true;
+    if (tol.hueChannel == 0) {
+      double maxv = fmax(src[0], fmax(src[1], src[2]));
+      double minv = fmin(src[0], fmin(src[1], src[2]));
+      hueDefined = maxv - minv > 1e-3;
+    } else if (tol.hueChannel == 2) {
+      hueDefined = hypot(src[1], src[2]) > 1e-3;
+    }
+
+    for (const Colors* got : {&whole, &pieces}) {
+      for (int c = 0; c < 3; c++) {
+        double diff = c == tol.hueChannel ? AngleDiff(got->c[c][i], ref[c])
+                                          : fabs(got->c[c][i] - ref[c]);
+        if (c == tol.hueChannel && !hueDefined) continue;
+        worst[c] = fmax(worst[c], diff);
+        CHECK(diff <= tol.abs[c],
+              "%s input (%.9g %.9g %.9g) channel %d: got %.9g want %.9g",
+              name, src[0], src[1], src[2], c, got->c[c][i], ref[c]);
+      }
+    }
+  }
+  printf("  %-14s max error %.2e %.2e %.2e\n", name, worst[0], worst[1],
+         worst[2]);
+}
+
+//? 全部 8 位颜色 (步长 3，含 0 和 255) 转过去再转回来，量化后必须等于原值
+void CheckRoundTrip(const char* name, const std::vector<Kernel>& forward,
+                    const std::vector<Kernel>& backward) {
+  Colors colors;
+  for (int r = 0; r <= 255; r += 3) {
+    for (int g = 0; g <= 255; g += 3) {
+      for (int b = 0; b <= 255; b += 3) {
+        colors.push(r / 255.0f, g / 255.0f, b / 255.0f);
+      }
+    }
+  }
+  Colors x = colors;
+  for (Kernel k : forward) x = Convert(k, x);
+  for (Kernel k : backward) x = Convert(k, x);
+
+  int mismatches = 0;
+  for (size_t i = 0; i < colors.size(); i++) {
+    for (int c = 0; c < 3; c++) {
+      long want = lroundf(colors.c[c][i] * 255);
+      long got = lroundf(fminf(fmaxf(x.c[c][i], 0.0f), 1.0f) * 255);
+      if (got != want) mismatches++;
+      CHECK(got == want, "%s round trip (%ld) channel %d came back as %ld",
+            name, want, c, got);
+    }
+  }
+  printf("  %-14s %zu colors, %d mismatches\n", name, colors.size(),
+         mismatches);
+}
+
+//? 8 位拆包: UnpackSrgb 就是 v / 255；UnpackLinear 的表用 i / 255.0f 建，
+//? SrgbToLinear 的输入是 v * (1 / 255.0f)，两者差一两个 ulp
+void CheckUnpack() {
+  const int count = 256 * 3 + 5;  // 不是 4 的倍数，尾部也走到
+  std::vector<unsigned char> bgra(count * 4);
+  for (int i = 0; i < count; i++) {
+    bgra[i * 4 + 0] = (unsigned char)(i * 7);
+    bgra[i * 4 + 1] = (unsigned char)(i * 3 + 1);
+    bgra[i * 4 + 2] = (unsigned char)i;
+    bgra[i * 4 + 3] = 255;
+  }
+  Colors srgb, linear, expected;
+  srgb.resize(count);
+  linear.resize(count);
+  expected.resize(count);
+  UnpackSrgb(bgra.data(), count, srgb.span());
+  UnpackLinear(bgra.data(), count, linear.span());
+  SrgbToLinear(srgb.span(), count, expected.span());
+
+  for (int i = 0; i < count; i++) {
+    for (int c = 0; c < 3; c++) {
+      int v = bgra[i * 4 + 2 - c];
+      CHECK(srgb.c[c][i] == v * (1.0f / 255.0f), "UnpackSrgb %d -> %.9g", v,
+            srgb.c[c][i]);
+      CHECK(fabs(linear.c[c][i] - RefDecode(v / 255.0)) <= 3e-7,
+            "UnpackLinear %d -> %.9g", v, linear.c[c][i]);
+      CHECK(fabs(linear.c[c][i] - expected.c[c][i]) <= 3e-7,
+            "UnpackLinear %d -> %.9g, SrgbToLinear %.9g", v, linear.c[c][i],
+            expected.c[c][i]);
+    }
+  }
+}
+
+}  // namespace
+
+void ColorTests() {
+  printf("color:\n");
+  CheckUnpack();
+
+  Colors rgb = RgbSweep();
+  Colors linear = Convert(SrgbToLinear, rgb);
+  Colors hsv = Convert(RgbToHsv, rgb);
+  Colors hsl = Convert(RgbToHsl, rgb);
+  Colors lab = Convert(LinearToLab, linear);
+  Colors oklab = Convert(LinearToOklab, linear);
+  Colors oklch = Convert(OklabToOklch, oklab);
+
+  //? 容差: sRGB 类约 2~3 个 float ulp；色相 1e-3 度；HSL 的 S 在 L 接近 0 或 1
+  //? 时分母很小，放宽到 5e-5；Lab 的 a b 是 cbrt 之差乘 500，5e-4 仍远小于
+  //? 1 ΔE；8 位精度是 1/255 ≈ 4e-3，下面的往返检查保证量化后不差
+  CheckKernel("SrgbToLinear", SrgbToLinear, RefSrgbToLinear, rgb,
+              {{3e-7, 3e-7, 3e-7}, -1});
+  CheckKernel("LinearToSrgb", LinearToSrgb, RefLinearToSrgb, linear,
+              {{3e-7, 3e-7, 3e-7}, -1});
+  CheckKernel("RgbToHsv", RgbToHsv, RefRgbToHsv, rgb,
+              {{1e-3, 2e-7, 0}, 0});
+  CheckKernel("HsvToRgb", HsvToRgb, RefHsvToRgb, hsv,
+              {{1e-6, 1e-6, 1e-6}, -1});
+  CheckKernel("RgbToHsl", RgbToHsl, RefRgbToHsl, rgb,
+              {{1e-3, 5e-5, 1e-7}, 0});
+  CheckKernel("HslToRgb", HslToRgb, RefHslToRgb, hsl,
+              {{1e-6, 1e-6, 1e-6}, -1});
+  CheckKernel("LinearToLab", LinearToLab, RefLinearToLab, linear,
+              {{5e-4, 5e-4, 5e-4}, -1});
+  CheckKernel("LabToLinear", LabToLinear, RefLabToLinear, lab,
+              {{1e-6, 1e-6, 1e-6}, -1});
+  CheckKernel("LinearToOklab", LinearToOklab, RefLinearToOklab, linear,
+              {{1e-6, 1e-6, 1e-6}, -1});
+  CheckKernel("OklabToLinear", OklabToLinear, RefOklabToLinear, oklab,
+              {{3e-6, 3e-6, 3e-6}, -1});
+  CheckKernel("OklabToOklch", OklabToOklch, RefOklabToOklch, oklab,
+              {{0, 1e-7, 1e-3}, 2});
+  CheckKernel("OklchToOklab", OklchToOklab, RefOklchToOklab, oklch,
+              {{0, 1e-6, 1e-6}, -1});
+
+  CheckRoundTrip("sRGB/linear", {SrgbToLinear}, {LinearToSrgb});
+  CheckRoundTrip("HSV", {RgbToHsv}, {HsvToRgb});
+  CheckRoundTrip("HSL", {RgbToHsl}, {HslToRgb});
+  CheckRoundTrip("Lab", {SrgbToLinear, LinearToLab},
+                 {LabToLinear, LinearToSrgb});
+  CheckRoundTrip("OKLab", {SrgbToLinear, LinearToOklab},
+                 {OklabToLinear, LinearToSrgb});
+  CheckRoundTrip("OKLCH", {SrgbToLinear, LinearToOklab, OklabToOklch},
+                 {OklchToOklab, OklabToLinear, LinearToSrgb});
+}
+
+//? 每种转换 1M 像素一批，报告每秒多少像素 (单线程)
+void ColorBench() {
+  printf("color (single thread, 1M pixels per call):\n");
+  const size_t count = 1 << 20;
+  std::vector<unsigned char> bgra(count * 4);
+  uint32_t state = 777;
+  for (unsigned char& b : bgra) b = (unsigned char)Xorshift(state);
+
+  Colors srgb, linear, out;
+  srgb.resize(count);
+  linear.resize(count);
+  out.resize(count);
+  UnpackSrgb(bgra.data(), count, srgb.span());
+  UnpackLinear(bgra.data(), count, linear.span());
+  Colors lab = Convert(LinearToLab, linear);
+  Colors oklab = Convert(LinearToOklab, linear);
+  Colors oklch = Convert(OklabToOklch, oklab);
+  Colors hsv = Convert(RgbToHsv, srgb);
+  Colors hsl = Convert(RgbToHsl, srgb);
+
+  auto report = [&](const char* name, double seconds) {
+    printf("  %-14s %8.1f Mpx/s\n", name, count / seconds / 1e6);
+  };
+  report("UnpackSrgb", TimeIt([&] {
+           UnpackSrgb(bgra.data(), count, out.span());
+         }));
+  report("UnpackLinear", TimeIt([&] {
+           UnpackLinear(bgra.data(), count, out.span());
+         }));
+
+  struct Case {
+    const char* name;
+    Kernel kernel;
+    Colors* in;
+  };
+  const Case cases[] = {
+      {"SrgbToLinear", SrgbToLinear, &srgb},
+      {"LinearToSrgb", LinearToSrgb, &linear},
+      {"RgbToHsv", RgbToHsv, &srgb},
+      {"HsvToRgb", HsvToRgb, &hsv},
+      {"RgbToHsl", RgbToHsl, &srgb},
+      {"HslToRgb", HslToRgb, &hsl},
+      {"LinearToLab", LinearToLab, &linear},
+      {"LabToLinear", LabToLinear, &lab},
+      {"LinearToOklab", LinearToOklab, &linear},
+      {"OklabToLinear", OklabToLinear, &oklab},
+      {"OklabToOklch", OklabToOklch, &oklab},
+      {"OklchToOklab", OklchToOklab, &oklch},
+  };
+  for (const Case& c : cases) {
+    report(c.name, TimeIt([&] { c.kernel(c.in->span(), count, out.span()); }));
+  }
+}
@@ -0,0 +1,166 @@
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <utility>
+#include <vector>
+
+#include "gradient.h"
+#include "parallel.h"
+#include "test.h"
+
+//& gradient.cpp: SSE2 的亮度和 Sobel 与逐像素的标量参考实现对照，
+//& 以及在已知位置有边的合成图上检查吸附结果
+
+namespace {
+
+uint32_t Xorshift(uint32_t& state) {
+  state ^= state << 13;
+  state ^= state >> 17;
+  state ^= state << 5;
+  return state;
+}
+
+std::vector<unsigned char> RandomImage(int width, int height, uint32_t seed) {
+  std::vector<unsigned char> bgra((size_t)width * height * 4);
+  for (unsigned char& b : bgra) b = (unsigned char)(Xorshift(seed) >> 24);
+  return bgra;
+}
+
+//? 灰度图: 每个像素的 R = G = B = luma(x, y)，亮度权重和为 256，转换无损
+template <class Luma>
+std::vector<unsigned char> GrayImage(int width, int height, Luma luma) {
+  std::vector<unsigned char> bgra((size_t)width * height * 4);
+  for (int y = 0; y < height; y++) {
+    for (int x = 0; x < width; x++) {
+      unsigned char* p = &bgra[((size_t)y * width + x) * 4];
+      p[0] = p[1] = p[2] = (unsigned char)luma(x, y);
+      p[3] = 255;
+    }
+  }
+  return bgra;
+}
+
+//? 按定义逐像素算: 越界的行列取边上的像素，"上" 是内存里的下一行
+void RefGradientField(const unsigned char* bgra, int width, int height,
+                      std::vector<unsigned char>& gx,
+                      std::vector<unsigned char>& gy) {
+  auto luma = [&](int x, int y) {
+    x = std::min(std::max(x, 0), width - 1);
+    y = std::min(std::max(y, 0), height - 1);
+    const unsigned char* p = bgra + ((size_t)y * width + x) * 4;
+    return (54 * p[2] + 183 * p[1] + 19 * p[0]) >> 8;
+  };
+  gx.resize((size_t)width * height);
+  gy.resize(gx.size());
+  for (int y = 0; y < height; y++) {
+    for (int x = 0; x < width; x++) {
+      int dx = 0, dy = 0;
+      for (int k = -1; k <= 1; k++) {
+        int weight = k == 0 ? 2 : 1;
+        dx += weight * (luma(x + 1, y + k) - luma(x - 1, y + k));
+        dy += weight * (luma(x + k, y + 1) - luma(x + k, y - 1));
+      }
+      gx[(size_t)y * width + x] = (unsigned char)(abs(dx) >> 2);
+      gy[(size_t)y * width + x] = (unsigned char)(abs(dy) >> 2);
+    }
+  }
+}
+
+void CheckField(const std::vector<unsigned char>& image, int width,
+                int height) {
+  GradientField field;
+  ComputeGradientField(image.data(), width, height, field);
+  std::vector<unsigned char> gx, gy;
+  RefGradientField(image.data(), width, height, gx, gy);
+  CHECK(field.width == width && field.height == height, "%dx%d: size %dx%d",
+        width, height, field.width, field.height);
+  for (size_t i = 0; i < gx.size(); i++) {
+    CHECK(field.gx[i] == gx[i] && field.gy[i] == gy[i],
+          "%dx%d at (%d, %d): gx %d gy %d want %d %d", width, height,
+          (int)(i % width), (int)(i / width), field.gx[i], field.gy[i], gx[i],
+          gy[i]);
+  }
+}
+
+}  // namespace
+
+//? 梯度场逐值对照 (含 SSE2 每次 8 个像素之后的尾巴和 1 像素宽/高)；
+//? 吸附: 左右两块、上下两块亮度不同，边界在第 61 列和第 45 行
+void GradientTests() {
+  printf("gradient:\n");
+  const int sizes[][2] = {{64, 48}, {97, 71}, {9, 3}, {10, 10},
+                          {17, 2},  {1, 30},  {30, 1}};
+  uint32_t seed = 21;
+  for (const auto& size : sizes) {
+    CheckField(RandomImage(size[0], size[1], seed++), size[0], size[1]);
+  }
+
+  const int width = 203, height = 117;
+  auto blockLuma = [](int x, int y) {
+    return (x >= 61 ? 150 : 30) + (y >= 45 ? 80 : 0);
+  };
+  std::vector<unsigned char> blocks = GrayImage(width, height, blockLuma);
+  CheckField(blocks, width, height);
+  GradientField field;
+  ComputeGradientField(blocks.data(), width, height, field);
+  for (float x = 53.0f; x <= 69.0f; x += 0.75f) {
+    int snapped = SnapEdgeX(field, x, 10, 8);
+    CHECK(snapped == 61, "snap x from %.2f: %d", x, snapped);
+  }
+  for (float y = 37.0f; y <= 53.0f; y += 0.75f) {
+    int snapped = SnapEdgeY(field, 150, y, 8);
+    CHECK(snapped == 45, "snap y from %.2f: %d", y, snapped);
+  }
+  CHECK(SnapEdgeX(field, 50.0f, 10, 8) == -1, "edge out of radius");
+  CHECK(SnapEdgeX(field, 150.0f, 10, 8) == -1, "flat row");
+  CHECK(SnapEdgeY(field, 20, 100.0f, 8) == -1, "flat column");
+  CHECK(SnapEdgeX(field, 61.0f, -1, 8) == -1, "row out of range");
+  CHECK(SnapEdgeY(field, width, 45.0f, 8) == -1, "column out of range");
+
+  // 抗锯齿的边: 30 50 110 140 150，从左边远处碰到的第一个够强的边界是 59，
+  // 要爬到两侧梯度之和最大的 61
+  std::vector<unsigned char> ramp = GrayImage(width, height, [](int x, int) {
+    const int values[] = {30, 50, 110, 140};
+    return x < 59 ? 30 : x > 62 ? 150 : values[x - 59];
+  });
+  ComputeGradientField(ramp.data(), width, height, field);
+  for (float x = 55.0f; x <= 67.0f; x += 1.0f) {
+    int snapped = SnapEdgeX(field, x, 60, 8);
+    CHECK(snapped == 61, "snap anti-aliased x from %.0f: %d", x, snapped);
+  }
+}
+
+//? 8K 截图算一次梯度场；吸附在随机噪声上 (每个边界都够强，要爬坡) 和
+//? 纯色上 (整个范围扫完也找不到) 各查一次，半径 8 是放大时，64 是上限
+void GradientBench() {
+  const int width = 7680, height = 4320;
+  printf("gradient (8K, %d worker threads):\n", ParallelWorkerCount());
+  std::vector<unsigned char> noise = RandomImage(width, height, 9);
+  GradientField field;
+  double seconds = TimeIt(
+      [&] { ComputeGradientField(noise.data(), width, height, field); }, 0.5);
+  printf("  field    %8.1f ms\n", seconds * 1e3);
+
+  GradientField flat;
+  std::vector<unsigned char> gray =
+      GrayImage(width, height, [](int, int) { return 128; });
+  ComputeGradientField(gray.data(), width, height, flat);
+  const std::pair<const char*, const GradientField*> fields[] = {
+      {"noise", &field}, {"flat", &flat}};
+  for (const auto& f : fields) {
+    for (int radius : {8, 64}) {
+      // 每次换一行 / 一列，拖动时查询的线也在变，缓存里不一定有
+      int line = 0;
+      double x = TimeIt([&] {
+        line = (line + 97) % height;
+        SnapEdgeX(*f.second, width * 0.5f, line, radius);
+      });
+      double y = TimeIt([&] {
+        line = (line + 97) % width;
+        SnapEdgeY(*f.second, line, height * 0.5f, radius);
+      });
+      printf("  snap %-5s radius %2d  x %6.3f us  y %6.3f us\n", f.first,
+             radius, x * 1e6, y * 1e6);
+    }
+  }
+}
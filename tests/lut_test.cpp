@@ -0,0 +1,259 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#include "lut.h"
+#include "test.h"
+
+//& lut.cpp: 颜色变换的表和双精度的直接变换对照，查表和按定义的三线性插值对照
+//? 色盲模拟的矩阵按论文重新抄一遍，不用 lut.cpp 里的常量
+
+namespace {
+
+// Machado, Oliveira, Fernandes 2009 表格里严重程度 1.0 的一行
+const double kMachado[3][9] = {
+    {0.152286, 1.052583, -0.204868, 0.114503, 0.786281, 0.099216, -0.003882,
+     -0.048116, 1.051998},
+    {0.367322, 0.860646, -0.227968, 0.280085, 0.672501, 0.047413, -0.011820,
+     0.042940, 0.968881},
+    {1.255528, -0.076749, -0.178779, -0.078411, 0.930809, 0.147602, 0.004733,
+     0.691367, 0.303900}};
+
+uint32_t Xorshift(uint32_t& state) {
+  state ^= state << 13;
+  state ^= state >> 17;
+  state ^= state << 5;
+  return state;
+}
+
+double Decode(double c) {
+  return c <= 0.04045 ? c / 12.92 : pow((c + 0.055) / 1.055, 2.4);
+}
+
+double Encode(double c) {
+  return c <= 0.0031308 ? c * 12.92 : 1.055 * pow(c, 1.0 / 2.4) - 0.055;
+}
+
+double Clamp01(double v) { return fmin(fmax(v, 0.0), 1.0); }
+
+//? 色盲模拟: 解码、乘矩阵、截到 0~1、编码；rgb 是 sRGB 0~1
+void RefSimulate(const double m[9], const double rgb[3], double out[3]) {
+  double lin[3];
+  for (int c = 0; c < 3; c++) lin[c] = Decode(rgb[c]);
+  for (int r = 0; r < 3; r++) {
+    double v =
+        m[r * 3] * lin[0] + m[r * 3 + 1] * lin[1] + m[r * 3 + 2] * lin[2];
+    out[r] = Encode(Clamp01(v));
+  }
+}
+
+//? 对比度拉伸: [low, high] 拉到 0~1，gamma 让中位数落在 0.5
+void RefStretch(const LutImageStats& s, const double rgb[3], double out[3]) {
+  double mid = (s.median - s.low) / (s.high - s.low);
+  double gamma = log(0.5) / log(mid);
+  for (int c = 0; c < 3; c++) {
+    out[c] = pow(Clamp01((rgb[c] - s.low) / (s.high - s.low)), gamma);
+  }
+}
+
+//? 表里格点 (i, j, k) 的值，R 变化最快
+const unsigned char* Node(const std::vector<unsigned char>& lut, int i, int j,
+                          int k) {
+  return &lut[(((size_t)k * LUT_SIZE + j) * LUT_SIZE + i) * 4];
+}
+
+//? 按定义的三线性插值，双精度
+void RefLookup(const std::vector<unsigned char>& lut,
+               const unsigned char rgb[3], double out[3]) {
+  int base[3];
+  double frac[3];
+  for (int c = 0; c < 3; c++) {
+    double x = rgb[c] / 255.0 * (LUT_SIZE - 1);
+    base[c] = std::min((int)x, LUT_SIZE - 2);
+    frac[c] = x - base[c];
+  }
+  for (int c = 0; c < 3; c++) out[c] = 0;
+  for (int k = 0; k < 2; k++) {
+    for (int j = 0; j < 2; j++) {
+      for (int i = 0; i < 2; i++) {
+        double w = (i ? frac[0] : 1 - frac[0]) * (j ? frac[1] : 1 - frac[1]) *
+                   (k ? frac[2] : 1 - frac[2]);
+        const unsigned char* p =
+            Node(lut, base[0] + i, base[1] + j, base[2] + k);
+        for (int c = 0; c < 3; c++) out[c] += w * p[c];
+      }
+    }
+  }
+}
+
+std::vector<unsigned char> Build(ColorTransform transform,
+                                 const LutImageStats& stats) {
+  std::vector<unsigned char> lut((size_t)LUT_SIZE * LUT_SIZE * LUT_SIZE * 4);
+  BuildColorLut(transform, stats, LUT_SIZE, lut.data());
+  return lut;
+}
+
+//? 格点上的值和直接变换的差不超过 1 级 (表里存的是四舍五入后的 8 位值)
+template <class Ref>
+void CheckNodes(const char* name, const std::vector<unsigned char>& lut,
+                Ref reference) {
+  const int grid = LUT_SIZE - 1;
+  int maxDiff = 0;
+  for (int k = 0; k <= grid; k += 4) {
+    for (int j = 0; j <= grid; j += 4) {
+      for (int i = 0; i <= grid; i += 4) {
+        double rgb[3] = {(double)i / grid, (double)j / grid, (double)k / grid};
+        double want[3];
+        reference(rgb, want);
+        const unsigned char* got = Node(lut, i, j, k);
+        for (int c = 0; c < 3; c++) {
+          maxDiff = std::max(maxDiff, abs(got[c] - (int)lround(want[c] * 255)));
+        }
+      }
+    }
+  }
+  CHECK(maxDiff <= 1, "%s nodes: max diff %d", name, maxDiff);
+}
+
+//? 不在格点上的随机颜色: 查表和按定义插值一致 (只差舍入)；
+//? 和直接变换的差是 33 格插值本身的误差: 大多数颜色在 2 级以内，
+//? 只有变换里有折点 (截到 0~1、拉伸的两端) 落在格子中间时差得多
+#define OFF_GRID_SOFT_DIFF 2
+#define OFF_GRID_MAX_SHARE 0.03
+#define OFF_GRID_MAX_DIFF 24
+template <class Ref>
+void CheckOffGrid(const char* name, const std::vector<unsigned char>& lut,
+                  Ref reference) {
+  const int samples = 20000;
+  uint32_t seed = 77;
+  int lookupDiff = 0, transformDiff = 0, over = 0;
+  for (int n = 0; n < samples; n++) {
+    uint32_t v = Xorshift(seed);
+    unsigned char rgb[3] = {(unsigned char)v, (unsigned char)(v >> 8),
+                            (unsigned char)(v >> 16)};
+    unsigned char got[3];
+    LookupColorLut(lut.data(), LUT_SIZE, rgb, got);
+    double interpolated[3], want[3];
+    RefLookup(lut, rgb, interpolated);
+    double in[3] = {rgb[0] / 255.0, rgb[1] / 255.0, rgb[2] / 255.0};
+    reference(in, want);
+    int diff = 0;
+    for (int c = 0; c < 3; c++) {
+      lookupDiff =
+          std::max(lookupDiff, abs(got[c] - (int)lround(interpolated[c])));
+      diff = std::max(diff, abs(got[c] - (int)lround(want[c] * 255)));
+    }
+    transformDiff = std::max(transformDiff, diff);
+    if (diff > OFF_GRID_SOFT_DIFF) over++;
+  }
+  double share = (double)over / samples;
+  printf("  %-8s lookup vs transform: max diff %d, %.2f%% over %d\n", name,
+         transformDiff, share * 100, OFF_GRID_SOFT_DIFF);
+  CHECK(lookupDiff <= 1, "%s lookup vs interpolation: max diff %d", name,
+        lookupDiff);
+  CHECK(transformDiff <= OFF_GRID_MAX_DIFF && share <= OFF_GRID_MAX_SHARE,
+        "%s lookup vs transform: max diff %d, %.2f%% over %d", name,
+        transformDiff, share * 100, OFF_GRID_SOFT_DIFF);
+}
+
+}  // namespace
+
+void LutTests() {
+  printf("lut:\n");
+  LutImageStats stats = {0.1f, 0.55f, 0.9f};
+
+  // 不变换: 每个 8 位颜色查表后还是自己 (容差 1/255)
+  std::vector<unsigned char> identity = Build(TRANSFORM_NONE, stats);
+  int identityDiff = 0;
+  for (int b = 0; b < 256; b += 3) {
+    for (int g = 0; g < 256; g++) {
+      for (int r = 0; r < 256; r++) {
+        unsigned char rgb[3] = {(unsigned char)r, (unsigned char)g,
+                                (unsigned char)b};
+        unsigned char out[3];
+        LookupColorLut(identity.data(), LUT_SIZE, rgb, out);
+        for (int c = 0; c < 3; c++) {
+          identityDiff = std::max(identityDiff, abs(out[c] - rgb[c]));
+        }
+      }
+    }
+  }
+  CHECK(identityDiff <= 1, "identity round trip: max diff %d", identityDiff);
+
+  const ColorTransform cvd[3] = {TRANSFORM_PROTAN, TRANSFORM_DEUTAN,
+                                 TRANSFORM_TRITAN};
+  for (int t = 0; t < 3; t++) {
+    std::vector<unsigned char> lut = Build(cvd[t], stats);
+    auto reference = [&](const double in[3], double out[3]) {
+      RefSimulate(kMachado[t], in, out);
+    };
+    const char* name = ColorTransformName(cvd[t]);
+    CheckNodes(name, lut, reference);
+    CheckOffGrid(name, lut, reference);
+
+    // 原色和白: 格点正好在 0 和 1 上，和论文的矩阵算出来的一致
+    const double primaries[4][3] = {{1, 0, 0}, {0, 1, 0}, {0, 0, 1}, {1, 1, 1}};
+    const int last = LUT_SIZE - 1;
+    for (const auto& p : primaries) {
+      double want[3];
+      RefSimulate(kMachado[t], p, want);
+      const unsigned char* got =
+          Node(lut, (int)p[0] * last, (int)p[1] * last, (int)p[2] * last);
+      for (int c = 0; c < 3; c++) {
+        CHECK(abs(got[c] - (int)lround(want[c] * 255)) <= 1,
+              "%s primary (%g %g %g) channel %d: %d want %.2f", name, p[0],
+              p[1], p[2], c, got[c], want[c] * 255);
+      }
+    }
+  }
+
+  std::vector<unsigned char> stretch = Build(TRANSFORM_STRETCH, stats);
+  auto stretchRef = [&](const double in[3], double out[3]) {
+    RefStretch(stats, in, out);
+  };
+  CheckNodes("STRETCH", stretch, stretchRef);
+  CheckOffGrid("STRETCH", stretch, stretchRef);
+
+  // 分位数: 1% 的像素是 10，98% 是 100，1% 是 250
+  std::vector<unsigned char> image(100 * 100 * 4, 100);
+  for (int i = 0; i < 100; i++) {
+    memset(&image[i * 4], 10, 4);
+    memset(&image[(9900 + i) * 4], 250, 4);
+  }
+  LutImageStats measured = ComputeLutImageStats(image.data(), 100, 100);
+  CHECK(lround(measured.low * 255) == 100 &&
+            lround(measured.median * 255) == 100 &&
+            lround(measured.high * 255) == 250,
+        "image stats %f %f %f", measured.low, measured.median, measured.high);
+
+  // P3 检查: sRGB 里有的颜色 (灰、中等饱和度) 变成灰，P3 的纯红保留
+  std::vector<unsigned char> gamut = Build(TRANSFORM_GAMUT, stats);
+  const int last = LUT_SIZE - 1, half = last / 2;
+  const unsigned char* red = Node(gamut, last, 0, 0);
+  CHECK(red[0] == 255 && red[1] == 0 && red[2] == 0, "P3 red: %d %d %d",
+        red[0], red[1], red[2]);
+  const unsigned char* muted = Node(gamut, half, half + 4, half - 4);
+  CHECK(muted[0] == muted[1] && muted[1] == muted[2] && muted[0] < 128,
+        "in-gamut colour: %d %d %d", muted[0], muted[1], muted[2]);
+
+  // 伪彩色: 灰阶从暗到亮依次是蓝、绿、红占优 (turbo 的顺序)，黑是暗色
+  std::vector<unsigned char> falseColor = Build(TRANSFORM_FALSE_COLOR, stats);
+  const unsigned char* black = Node(falseColor, 0, 0, 0);
+  CHECK(std::max({black[0], black[1], black[2]}) < 64,
+        "false colour black: %d %d %d", black[0], black[1], black[2]);
+  int peak[3] = {}, peakValue[3] = {};
+  for (int v = 0; v <= last; v++) {
+    const unsigned char* p = Node(falseColor, v, v, v);
+    for (int c = 0; c < 3; c++) {
+      if (p[c] > peakValue[c]) {
+        peakValue[c] = p[c];
+        peak[c] = v;
+      }
+    }
+  }
+  CHECK(peak[2] < peak[1] && peak[1] < peak[0],
+        "false colour peaks: r %d g %d b %d", peak[0], peak[1], peak[2]);
+}
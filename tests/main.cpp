@@ -0,0 +1,33 @@
+#include <cstring>
+
+#include "test.h"
+
+int testFailures;
+
+bool ShouldReportFailure() { return testFailures <= 20; }
+
+//? 不带参数跑测试，--bench 跑基准
+int main(int argc, char** argv) {
+  if (argc > 1 && strcmp(argv[1], "--bench") == 0) {
+    ColorBench();
+    PickerBench();
+    RegionBench();
+    MipBench();
+    GradientBench();
+    return 0;
+  }
+
+  ColorTests();
+  PickerTests();
+  RegionTests();
+  MipTests();
+  GradientTests();
+  LutTests();
+
+  if (testFailures) {
+    printf("%d checks failed\n", testFailures);
+    return 1;
+  }
+  printf("all tests passed\n");
+  return 0;
+}
@@ -0,0 +1,130 @@
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+#include "mip.h"
+#include "parallel.h"
+#include "test.h"
+
+//& mip.cpp: SSE2 的 2x2 盒式滤波和逐像素的标量参考实现逐字节对照
+
+namespace {
+
+uint32_t Xorshift(uint32_t& state) {
+  state ^= state << 13;
+  state ^= state >> 17;
+  state ^= state << 5;
+  return state;
+}
+
+std::vector<unsigned char> RandomImage(int width, int height, uint32_t seed) {
+  std::vector<unsigned char> bgra((size_t)width * height * 4);
+  for (unsigned char& b : bgra) b = (unsigned char)(Xorshift(seed) >> 24);
+  return bgra;
+}
+
+//? 按定义: 奇数边长时最后一行/列重复自己，四个值求和后四舍五入
+std::vector<unsigned char> RefDownsample(const std::vector<unsigned char>& src,
+                                         int width, int height) {
+  int dstWidth = MipSize(width, 1), dstHeight = MipSize(height, 1);
+  std::vector<unsigned char> dst((size_t)dstWidth * dstHeight * 4);
+  for (int y = 0; y < dstHeight; y++) {
+    for (int x = 0; x < dstWidth; x++) {
+      int xs[2] = {std::min(2 * x, width - 1), std::min(2 * x + 1, width - 1)};
+      int ys[2] = {std::min(2 * y, height - 1),
+                   std::min(2 * y + 1, height - 1)};
+      for (int c = 0; c < 4; c++) {
+        int sum = 0;
+        for (int j = 0; j < 2; j++) {
+          for (int i = 0; i < 2; i++) {
+            sum += src[((size_t)ys[j] * width + xs[i]) * 4 + c];
+          }
+        }
+        dst[((size_t)y * dstWidth + x) * 4 + c] =
+            (unsigned char)((sum + 2) / 4);
+      }
+    }
+  }
+  return dst;
+}
+
+//? 整条金字塔逐级对照，每一级用参考实现上一级的结果做输入
+void CheckChain(int width, int height, uint32_t seed) {
+  std::vector<unsigned char> src = RandomImage(width, height, seed);
+  int levels = MipLevelCount(width, height);
+  for (int level = 1; level <= levels; level++) {
+    int w = MipSize(width, level - 1), h = MipSize(height, level - 1);
+    std::vector<unsigned char> want = RefDownsample(src, w, h);
+    std::vector<unsigned char> got(want.size() + 16, 0xcd);
+    DownsampleBox2x2(src.data(), w, h, got.data());
+    CHECK(memcmp(got.data(), want.data(), want.size()) == 0,
+          "%dx%d level %d (from %dx%d) differs", width, height, level, w, h);
+    for (size_t i = want.size(); i < got.size(); i++) {
+      CHECK(got[i] == 0xcd, "%dx%d level %d wrote past the end", width,
+            height, level);
+    }
+    src.swap(want);
+  }
+}
+
+}  // namespace
+
+//? 偶数、奇数、1 像素宽/高，以及 SSE2 每次 4 个输出像素之后剩下尾巴的宽度
+void MipTests() {
+  printf("mip:\n");
+  const int sizes[][2] = {{64, 64}, {97, 71}, {1, 33}, {33, 1},  {1, 1},
+                          {2, 2},   {8, 3},   {9, 9},  {15, 17}, {16, 5},
+                          {17, 4},  {18, 2},  {301, 203}};
+  uint32_t seed = 11;
+  for (const auto& size : sizes) CheckChain(size[0], size[1], seed++);
+
+  CHECK(MipLevelCount(1, 1) == 0, "levels of 1x1");
+  CHECK(MipLevelCount(7680, 4320) == 12, "levels of 8K: %d",
+        MipLevelCount(7680, 4320));
+
+  // 后台线程 (分段提交) 和前台同时用线程池，结果都不能错
+  const int width = 1027, height = 613;
+  std::vector<unsigned char> image = RandomImage(width, height, 3);
+  std::vector<unsigned char> want = RefDownsample(image, width, height);
+  std::vector<unsigned char> background(want.size()), foreground(want.size());
+  std::thread worker([&] {
+    ParallelMarkBackgroundThread();
+    for (int i = 0; i < 8; i++) {
+      DownsampleBox2x2(image.data(), width, height, background.data());
+    }
+  });
+  for (int i = 0; i < 8; i++) {
+    DownsampleBox2x2(image.data(), width, height, foreground.data());
+  }
+  worker.join();
+  CHECK(background == want, "background downsample differs");
+  CHECK(foreground == want, "foreground downsample differs");
+}
+
+//? 8K 截图的第 1 级 (占整条金字塔大部分的工作量) 和整条金字塔
+void MipBench() {
+  const int width = 7680, height = 4320;
+  printf("mip (8K, %d worker threads):\n", ParallelWorkerCount());
+  std::vector<unsigned char> image = RandomImage(width, height, 5);
+  std::vector<unsigned char> level1((size_t)MipSize(width, 1) *
+                                    MipSize(height, 1) * 4);
+  std::vector<unsigned char> scratch(level1.size());
+  double seconds = TimeIt(
+      [&] { DownsampleBox2x2(image.data(), width, height, level1.data()); },
+      0.5);
+  printf("  level 1  %8.1f ms\n", seconds * 1e3);
+  seconds = TimeIt(
+      [&] {
+        // 第 L 级写进 buffers[L % 2]
+        unsigned char* buffers[2] = {scratch.data(), level1.data()};
+        DownsampleBox2x2(image.data(), width, height, buffers[1]);
+        for (int level = 2; level <= MipLevelCount(width, height); level++) {
+          DownsampleBox2x2(buffers[(level - 1) % 2], MipSize(width, level - 1),
+                           MipSize(height, level - 1), buffers[level % 2]);
+        }
+      },
+      0.5);
+  printf("  chain    %8.1f ms\n", seconds * 1e3);
+}
@@ -0,0 +1,265 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <utility>
+#include <vector>
+
+#include "parallel.h"
+#include "picker.h"
+#include "test.h"
+
+//& picker.cpp: 区域取色和逐像素排序的参考实现对比，区域统计和逐像素直方图对比
+
+namespace {
+
+uint32_t Xorshift(uint32_t& state) {
+  state ^= state << 13;
+  state ^= state >> 17;
+  state ^= state << 5;
+  return state;
+}
+
+//? 随机 BGRA 图；low 为真时每个通道只在 [0, 8) 里取值，中位数附近有大量相同值
+std::vector<unsigned char> RandomImage(int width, int height, uint32_t seed,
+                                       bool low) {
+  std::vector<unsigned char> bgra((size_t)width * height * 4);
+  for (unsigned char& b : bgra) {
+    uint32_t v = Xorshift(seed);
+    b = (unsigned char)(low ? v & 7 : v >> 24);
+  }
+  return bgra;
+}
+
+//? 收集裁剪后区域的每个通道值排序，按定义算均值、下中位数、截尾平均
+bool RefSampleArea(const unsigned char* bgra, int width, int height, int cx,
+                   int cy, int size, SampleMode mode, unsigned char rgb[3]) {
+  if (mode == SAMPLE_POINT) size = 1;
+  size = std::min(size, SAMPLE_MAX_SIZE);
+  int x0 = std::max(cx - size / 2, 0);
+  int y0 = std::max(cy - size / 2, 0);
+  int x1 = std::min(cx - size / 2 + size, width);
+  int y1 = std::min(cy - size / 2 + size, height);
+  if (x0 >= x1 || y0 >= y1) {
+    rgb[0] = rgb[1] = rgb[2] = 0;
+    return false;
+  }
+
+  for (int c = 0; c < 3; c++) {
+    std::vector<int> values;
+    for (int y = y0; y < y1; y++) {
+      for (int x = x0; x < x1; x++) {
+        values.push_back(bgra[((size_t)y * width + x) * 4 + 2 - c]);
+      }
+    }
+    std::sort(values.begin(), values.end());
+    size_t n = values.size();
+    size_t lo = 0, hi = n;
+    if (mode == SAMPLE_MEDIAN) {
+      rgb[c] = (unsigned char)values[(n - 1) / 2];
+      continue;
+    }
+    if (mode == SAMPLE_TRIMMED) {
+      lo = n / 4;
+      hi = n - n / 4;
+    }
+    uint64_t sum = 0;
+    for (size_t i = lo; i < hi; i++) sum += values[i];
+    rgb[c] = (unsigned char)((sum + (hi - lo) / 2) / (hi - lo));
+  }
+  return true;
+}
+
+void CheckSample(const std::vector<unsigned char>& image, int width,
+                 int height, int cx, int cy, int size, SampleMode mode) {
+  unsigned char got[3], want[3];
+  bool gotOk = SampleArea(image.data(), width, height, cx, cy, size, mode, got);
+  bool wantOk =
+      RefSampleArea(image.data(), width, height, cx, cy, size, mode, want);
+  CHECK(gotOk == wantOk, "%s size %d at (%d, %d): returned %d",
+        SampleModeName(mode), size, cx, cy, gotOk);
+  for (int c = 0; c < 3; c++) {
+    CHECK(got[c] == want[c], "%s size %d at (%d, %d) channel %d: %d want %d",
+          SampleModeName(mode), size, cx, cy, c, got[c], want[c]);
+  }
+}
+
+}  // namespace
+
+//? 每种模式、每个尺寸 (含奇偶和超过上限的 80)，中心放在图内、贴边和图外
+void PickerTests() {
+  printf("picker: %s kernel\n", SampleKernelName());
+  const int width = 97, height = 71;
+  for (bool low : {false, true}) {
+    std::vector<unsigned char> image = RandomImage(width, height, 99, low);
+    for (int m = 0; m < SAMPLE_MODE_COUNT; m++) {
+      SampleMode mode = (SampleMode)m;
+      for (int size = 1; size <= SAMPLE_MAX_SIZE + 16; size++) {
+        const int centers[][2] = {{48, 35}, {0, 0},     {96, 70}, {3, 69},
+                                  {90, 2},  {-40, 10}, {50, 200}};
+        for (const auto& center : centers) {
+          CheckSample(image, width, height, center[0], center[1], size, mode);
+        }
+      }
+    }
+  }
+}
+
+//? 64x64 是上限，也是最慢的情况；3x3 看固定开销
+void PickerBench() {
+  printf("picker (%s kernel, per call):\n", SampleKernelName());
+  const int width = 256, height = 256;
+  std::vector<unsigned char> image = RandomImage(width, height, 7, false);
+  for (int size : {3, 64}) {
+    for (int m = SAMPLE_MEAN; m < SAMPLE_MODE_COUNT; m++) {
+      SampleMode mode = (SampleMode)m;
+      unsigned char rgb[3];
+      int cx = 100;
+      double seconds = TimeIt([&] {
+        // 每次换个位置，免得编译器把调用提出循环
+        cx = cx == 100 ? 101 : 100;
+        SampleArea(image.data(), width, height, cx, 128, size, mode, rgb);
+      });
+      printf("  %2dx%-2d %-8s %8.2f us\n", size, size, SampleModeName(mode),
+             seconds * 1e6);
+    }
+  }
+}
+
+namespace {
+
+//? 8K 的合成截图: 大块纯色背景、窗口边框、一行行 "文字" (短的深色段)、
+//? 一块渐变，连续相同的像素很多，接近真实界面
+std::vector<unsigned char> UiImage(int width, int height) {
+  std::vector<unsigned char> bgra((size_t)width * height * 4);
+  uint32_t seed = 4242;
+  for (int y = 0; y < height; y++) {
+    uint32_t* row = (uint32_t*)(bgra.data() + (size_t)y * width * 4);
+    for (int x = 0; x < width; x++) {
+      uint32_t color = 0xff202124;  // 深色桌面
+      if (x > width / 8 && x < width * 5 / 8 && y > height / 8 &&
+          y < height * 7 / 8) {
+        color = 0xfff8f9fa;  // 窗口
+        if (y % 24 < 12 && x % 97 < 70 && (Xorshift(seed) & 3)) {
+          color = 0xff3c4043;  // 文字
+        }
+      } else if (x > width * 5 / 8) {
+        unsigned char v = (unsigned char)(x * 255 / width);
+        color = 0xff000000u | v << 16 | (255 - v) << 8 | (y & 0xff);
+      }
+      row[x] = color;
+    }
+  }
+  return bgra;
+}
+
+//? 逐像素累加直方图，再算均值和标准差
+void RefRegionHistogram(const unsigned char* bgra, int width, int x0, int y0,
+                        int x1, int y1, uint32_t histogram[3][256]) {
+  memset(histogram, 0, sizeof(uint32_t) * 3 * 256);
+  for (int y = y0; y < y1; y++) {
+    for (int x = x0; x < x1; x++) {
+      const unsigned char* p = bgra + ((size_t)y * width + x) * 4;
+      for (int c = 0; c < 3; c++) histogram[c][p[2 - c]]++;
+    }
+  }
+}
+
+void CheckRegion(const std::vector<unsigned char>& image, int width,
+                 int height, int x0, int y0, int x1, int y1) {
+  RegionStats stats;
+  bool ok = ComputeRegionStats(image.data(), width, height, x0, y0, x1, y1,
+                               stats);
+  CHECK(ok, "region (%d %d %d %d) returned false", x0, y0, x1, y1);
+  if (!ok) return;
+
+  static uint32_t histogram[3][256];
+  RefRegionHistogram(image.data(), width, std::max(std::min(x0, x1), 0),
+                     std::max(std::min(y0, y1), 0),
+                     std::min(std::max(x0, x1), width),
+                     std::min(std::max(y0, y1), height), histogram);
+  uint32_t count = 0;
+  for (int v = 0; v < 256; v++) count += histogram[0][v];
+  CHECK(stats.count == count, "region count %u want %u", stats.count, count);
+  for (int c = 0; c < 3; c++) {
+    double sum = 0;
+    for (int v = 0; v < 256; v++) {
+      CHECK(stats.histogram[c][v] == histogram[c][v],
+            "region channel %d value %d: %u want %u", c, v,
+            stats.histogram[c][v], histogram[c][v]);
+      sum += (double)v * histogram[c][v];
+    }
+    CHECK(fabs(stats.mean[c] - sum / count) < 1e-3, "region mean %d: %f",
+          c, stats.mean[c]);
+  }
+  float share = 0;
+  for (int k = 0; k < stats.dominantCount; k++) share += stats.dominantShare[k];
+  CHECK(stats.dominantCount > 0 && share <= 1.0001f,
+        "region dominant count %d share %f", stats.dominantCount, share);
+}
+
+}  // namespace
+
+//? 直方图和均值逐值对照；主色用三种已知占比的纯色块检查
+void RegionTests() {
+  printf("region:\n");
+  const int width = 301, height = 203;
+  std::vector<unsigned char> noise = RandomImage(width, height, 5, false);
+  CheckRegion(noise, width, height, 0, 0, width, height);
+  CheckRegion(noise, width, height, 17, 9, 18, 10);
+  CheckRegion(noise, width, height, 290, 150, -5, 3);  // 反向且越界
+  std::vector<unsigned char> ui = UiImage(width, height);
+  CheckRegion(ui, width, height, 0, 0, width, height);
+  CheckRegion(ui, width, height, 40, 20, 260, 190);
+
+  // 左一半红，右上 1/4 绿，右下 1/4 蓝
+  std::vector<unsigned char> blocks((size_t)width * height * 4);
+  for (int y = 0; y < height; y++) {
+    for (int x = 0; x < width; x++) {
+      uint32_t color = x < 150 ? 0xffc83214 : y < 100 ? 0xff1eb428 : 0xff0a14f0;
+      memcpy(&blocks[((size_t)y * width + x) * 4], &color, 4);
+    }
+  }
+  RegionStats stats;
+  ComputeRegionStats(blocks.data(), width, height, 0, 0, 300, 200, stats);
+  const unsigned char expected[3][3] = {{200, 50, 20}, {30, 180, 40},
+                                        {10, 20, 240}};
+  const float shares[3] = {0.5f, 0.25f, 0.25f};
+  CHECK(stats.dominantCount == 3, "blocks dominant count %d",
+        stats.dominantCount);
+  for (int k = 0; k < 3 && k < stats.dominantCount; k++) {
+    CHECK(memcmp(stats.dominant[k], expected[k], 3) == 0,
+          "blocks dominant %d: %d %d %d", k, stats.dominant[k][0],
+          stats.dominant[k][1], stats.dominant[k][2]);
+    CHECK(fabs(stats.dominantShare[k] - shares[k]) < 1e-6,
+          "blocks share %d: %f", k, stats.dominantShare[k]);
+  }
+}
+
+//? 整屏 8K (7680x4320)，一张接近界面的图和一张随机噪声 (最坏情况)
+//? 线程数从 1 开始翻倍到全部，看分片并行的伸缩
+void RegionBench() {
+  const int width = 7680, height = 4320;
+  int workers = ParallelWorkerCount();
+  printf("region (8K full screen, up to %d worker threads):\n", workers);
+  std::vector<unsigned char> ui = UiImage(width, height);
+  std::vector<unsigned char> noise = RandomImage(width, height, 3, false);
+  const std::pair<const char*, const std::vector<unsigned char>*> images[] = {
+      {"ui", &ui}, {"noise", &noise}};
+  RegionStats stats;
+  for (const auto& image : images) {
+    for (int limit = 1;; limit = std::min(limit * 2, workers)) {
+      ParallelSetWorkerLimit(limit);
+      double seconds = TimeIt(
+          [&] {
+            ComputeRegionStats(image.second->data(), width, height, 0, 0,
+                               width, height, stats);
+          },
+          1.0);
+      printf("  %-8s %2d threads %8.1f ms\n", image.first, limit,
+             seconds * 1e3);
+      if (limit == workers) break;
+    }
+  }
+  ParallelSetWorkerLimit(0);
+}
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <chrono>
+#include <cstdio>
+
+//& 测试和基准的公共部分，不用测试框架
+//? CHECK 失败时打印位置和信息并计数，不中断；main 最后按失败数返回
+//? 每个模块一组 XxxTests() / XxxBench()，在 tests/main.cpp 里依次调用
+//? 测试只查结果；基准只打印耗时和吞吐，不判断快慢 (机器不同)
+
+extern int testFailures;
+
+//? 失败太多时只打印前面的，免得刷屏
+bool ShouldReportFailure();
+
+#define CHECK(cond, ...)                                         \
+  do {                                                           \
+    if (!(cond)) {                                               \
+      testFailures++;                                            \
+      if (ShouldReportFailure()) {                               \
+        printf("%s:%d: CHECK(%s) failed: ", __FILE__, __LINE__,  \
+               #cond);                                           \
+        printf(__VA_ARGS__);                                     \
+        printf("\n");                                            \
+      }                                                          \
+    }                                                            \
+  } while (0)
+
+//? 反复调用 fn 直到累计超过 minSeconds，返回平均每次的秒数
+template <class Fn>
+double TimeIt(Fn fn, double minSeconds = 0.2) {
+  typedef std::chrono::steady_clock Clock;
+  fn();  // 预热: 缺页、缓存、线程池启动
+  int runs = 0;
+  auto start = Clock::now();
+  std::chrono::duration<double> elapsed;
+  do {
+    fn();
+    runs++;
+    elapsed = Clock::now() - start;
+  } while (elapsed.count() < minSeconds);
+  return elapsed.count() / runs;
+}
+
+void ColorTests();
+void ColorBench();
+void PickerTests();
+void PickerBench();
+void RegionTests();
+void RegionBench();
+void MipTests();
+void MipBench();
+void GradientTests();
+void GradientBench();
+void LutTests();
@@ -0,0 +1,99 @@
+//& 把 8x8 点阵字体烘焙成 font8x8.h: make bakefont
+//? 每个字形 8 行，每行一个字节，最高位是最左边的像素；基线在第 7 行下面
+
+#include <ft2build.h>
+#include FT_FREETYPE_H
+
+#include <cstdio>
+
+static bool Bake(FT_Face face, unsigned long codepoint, unsigned char rows[8]) {
+  for (int i = 0; i < 8; i++) rows[i] = 0;
+  if (!FT_Get_Char_Index(face, codepoint)) return false;
+  if (FT_Load_Char(face, codepoint, FT_LOAD_RENDER | FT_LOAD_TARGET_MONO)) {
+    return false;
+  }
+
+  FT_GlyphSlot glyph = face->glyph;
+  FT_Bitmap& bm = glyph->bitmap;
+  int ascender = (int)(face->size->metrics.ascender >> 6);
+  for (unsigned int r = 0; r < bm.rows; r++) {
+    int y = ascender - glyph->bitmap_top + (int)r;
+    if (y < 0 || y >= 8) continue;
+    for (unsigned int c = 0; c < bm.width; c++) {
+      int x = glyph->bitmap_left + (int)c;
+      if (x < 0 || x >= 8) continue;
+      if (bm.buffer[r * bm.pitch + c / 8] & (0x80 >> (c % 8))) {
+        rows[y] |= 0x80 >> x;
+      }
+    }
+  }
+  return true;
+}
+
+static void PrintRows(FILE* out, const unsigned char rows[8]) {
+  for (int i = 0; i < 8; i++) {
+    fprintf(out, "0x%02X%s", rows[i], i < 7 ? ", " : "");
+  }
+}
+
+int main(int argc, char** argv) {
+  if (argc < 3) {
+    fprintf(stderr, "usage: bakefont font.ttf font8x8.h\n");
+    return 1;
+  }
+
+  FT_Library ft;
+  FT_Face face;
+  if (FT_Init_FreeType(&ft) || FT_New_Face(ft, argv[1], 0, &face)) {
+    fprintf(stderr, "failed to load font: %s\n", argv[1]);
+    return 1;
+  }
+  FT_Set_Pixel_Sizes(face, 0, 8);
+
+  FILE* out = fopen(argv[2], "w");
+  if (!out) {
+    fprintf(stderr, "failed to open %s\n", argv[2]);
+    return 1;
+  }
+
+  fprintf(out,
+          "#pragma once\n\n"
+          "// 由 tools/bakefont.cpp 从 %s 生成，不要手改\n\n"
+          "#include <cstdint>\n\n"
+          "#define FONT8X8_ASCENDER %d  // 基线以上的行数\n\n"
+          "//? 每个字形 8 行，每行一个字节，最高位是最左边的像素\n"
+          "constexpr unsigned char font8x8Ascii[128][8] = {\n",
+          argv[1], (int)(face->size->metrics.ascender >> 6));
+
+  unsigned char rows[8];
+  for (unsigned long c = 0; c < 128; c++) {
+    Bake(face, c, rows);
+    fprintf(out, "    {");
+    PrintRows(out, rows);
+    fprintf(out, "},  // U+%04lX\n", c);
+  }
+  fprintf(out, "};\n\n");
+
+  fprintf(out,
+          "struct Font8x8Glyph {\n"
+          "  uint32_t codepoint;\n"
+          "  unsigned char rows[8];\n"
+          "};\n\n"
+          "//? 字体里有的 Latin-1 字符 (比如 HSV 行的 °)\n"
+          "constexpr Font8x8Glyph font8x8Latin1[] = {\n");
+  for (unsigned long c = 0xA0; c <= 0xFF; c++) {
+    if (!Bake(face, c, rows)) continue;
+    fprintf(out, "    {0x%04lX, {", c);
+    PrintRows(out, rows);
+    fprintf(out, "}},\n");
+  }
+  fprintf(out,
+          "};\n\n"
+          "constexpr int font8x8Latin1Count =\n"
+          "    sizeof(font8x8Latin1) / sizeof(font8x8Latin1[0]);\n");
+
+  fclose(out);
+  FT_Done_Face(face);
+  FT_Done_FreeType(ft);
+  return 0;
+}
@@ -0,0 +1,51 @@
+#include "trace.h"
+
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "platform.h"
+
+namespace {
+struct TraceStep {
+  const char* name;
+  std::chrono::steady_clock::time_point time;
+};
+
+bool enabled;
+std::chrono::steady_clock::time_point start;
+std::vector<TraceStep> steps;
+}  // namespace
+
+void StartupTraceBegin() {
+  enabled = true;
+  start = std::chrono::steady_clock::now();
+  steps.reserve(32);
+}
+
+void StartupTraceMark(const char* step) {
+  if (!enabled) return;
+  steps.push_back({step, std::chrono::steady_clock::now()});
+}
+
+void StartupTraceEnd() {
+  if (!enabled) return;
+  enabled = false;
+
+  std::string path = PlatformExeDir() + "/startup_trace.txt";
+  FILE* f = fopen(path.c_str(), "w");
+  if (!f) return;
+  //? 每一步的耗时和到这一步为止的总时间
+  fprintf(f, "%-20s %10s %10s\n", "step", "ms", "total");
+  auto last = start;
+  for (const TraceStep& step : steps) {
+    std::chrono::duration<double, std::milli> delta = step.time - last;
+    std::chrono::duration<double, std::milli> total = step.time - start;
+    fprintf(f, "%-20s %10.3f %10.3f\n", step.name, delta.count(),
+            total.count());
+    last = step.time;
+  }
+  fclose(f);
+  steps.clear();
+}
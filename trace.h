@@ -0,0 +1,11 @@
+#pragma once
+
+//& 启动过程计时，命令行带 --trace-startup 时打开
+//? 入口处 StartupTraceBegin，之后每一步做完 StartupTraceMark 一下；
+//? 第一帧呈现后 StartupTraceEnd 把各步耗时写到可执行文件旁边的 startup_trace.txt
+//? 没打开时 Mark / End 什么都不做
+
+void StartupTraceBegin();
+//? step 要是字符串常量，只存指针
+void StartupTraceMark(const char* step);
+void StartupTraceEnd();